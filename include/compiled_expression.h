@@ -0,0 +1,221 @@
+#ifndef COMPILED_EXPRESSION_H
+#define COMPILED_EXPRESSION_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "expression.h"
+#include "expression_graph.h"
+
+namespace tt_int {
+
+class VariableRegistry;
+
+/**
+ * @brief Operation codes understood by the CompiledExpression interpreter
+ */
+enum class OpCode : std::uint8_t {
+    LoadConstant,   ///< dest = constants[lhs]
+    LoadVariable,   ///< dest = values[slot of variable lhs]
+    Add,            ///< dest = slot[lhs] + slot[rhs]
+    Subtract,       ///< dest = slot[lhs] - slot[rhs]
+    Multiply,       ///< dest = slot[lhs] * slot[rhs]
+    Divide,         ///< dest = slot[lhs] / slot[rhs], NaN when slot[rhs] == 0
+    Interpret       ///< dest = interpreted node lhs evaluated through Expression::evaluate()
+};
+
+/**
+ * @brief A single tape instruction: opcode plus operand slots
+ *
+ * For LoadConstant, LoadVariable and Interpret, lhs indexes the constant
+ * pool, the variable table or the interpreted nodes and rhs is unused.
+ */
+struct Instruction {
+    OpCode op;
+    std::uint32_t dest;
+    std::uint32_t lhs;
+    std::uint32_t rhs;
+};
+
+/**
+ * @brief Expression tree lowered to a flat post-order instruction tape
+ *
+ * The tree stays the front end; compiling walks it once and emits a contiguous
+ * instruction array that a tight interpreter loop executes without virtual
+ * dispatch or pointer chasing. Intermediate results live in a small register
+ * file whose slots are reused once their value has been consumed.
+ *
+ * The input may be a DAG (see eliminateCommonSubexpressions()): a node shared
+ * by several parents is emitted once and its register is kept live until its
+ * last consumer has run.
+ *
+ * The tape can also be run over a block of samples at once (evaluateBatch),
+ * in which case each instruction becomes a single loop over the block.
+ *
+ * Variable values are read from flat arrays by slot. Until bind() is called
+ * the slot of each variable is its index in getVariableNames(); binding to a
+ * VariableRegistry resolves every name once to the registry's slot so that
+ * evaluation never touches strings or maps.
+ *
+ * Nodes of other Expression subclasses are not lowered. Each becomes an
+ * Interpret instruction that calls the node's own evaluate() with a map of
+ * the variable values, as evaluating the tree would; since such a node may
+ * read any variable, bind() then makes the tape read every variable of the
+ * registry. The nodes are referenced, not copied, so the expression must
+ * outlive the tape, and evaluating them allocates.
+ */
+class CompiledExpression {
+public:
+    /**
+     * @brief Compile an expression tree into an instruction tape
+     * @param expr Root of the expression tree
+     * @throws std::invalid_argument if the tree contains a null node
+     */
+    explicit CompiledExpression(const Expression& expr);
+
+    /**
+     * @brief Compile the expression rooted at an ExpressionGraph node
+     *
+     * The nodes are lowered straight from the arena in id order, which is
+     * already topological, without building Expression objects; nodes
+     * shared by several parents are emitted once. The graph is not
+     * referenced after construction.
+     *
+     * @param graph Graph holding the expression
+     * @param root Id of the root node
+     * @throws std::invalid_argument if root is not in the graph
+     */
+    CompiledExpression(const ExpressionGraph& graph, ExpressionGraph::NodeId root);
+
+    /**
+     * @brief Resolve every referenced variable to its slot in a registry
+     *
+     * With interpreted nodes, every variable of the registry is added to
+     * getVariableNames() after the ones the tape itself references.
+     *
+     * @param registry Registry whose slot layout evaluation will use
+     * @throws std::out_of_range if a referenced variable is not registered
+     */
+    void bind(const VariableRegistry& registry);
+
+    /**
+     * @brief Evaluate the tape with variable values given by slot
+     * @param values Variable values indexed by slot (see getVariableSlots())
+     * @param registers Scratch space of at least getRegisterCount() doubles
+     * @return The result of evaluating the expression
+     */
+    double evaluate(const double* values, double* registers) const;
+
+    /**
+     * @brief Evaluate the tape with variable values looked up by name
+     * @param variables Map of variable names to their values
+     * @return The result of evaluating the expression
+     * @throws std::out_of_range if a referenced variable is missing
+     */
+    double evaluate(const std::map<std::string, double>& variables) const;
+
+    /**
+     * @brief Evaluate the tape over a block of samples stored column-wise
+     *
+     * Each instruction runs once per block as a simple element-wise loop the
+     * compiler can auto-vectorize. Results are identical to calling
+     * evaluate() once per sample.
+     *
+     * @param columns One column of count values per slot (see getVariableSlots());
+     *        columns of unreferenced slots are never read and may be null
+     * @param count Number of samples in the block
+     * @param out Destination for count results
+     * @param registers Scratch space of at least getRegisterCount() * count doubles
+     */
+    void evaluateBatch(const double* const* columns, size_t count,
+                       double* out, double* registers) const;
+
+    /**
+     * @brief Get the distinct variable names referenced by the expression
+     * @return Names in first-reference order; position is the variable index.
+     *         Interpreted nodes see only these variables.
+     */
+    const std::vector<std::string>& getVariableNames() const { return variableNames_; }
+
+    /**
+     * @brief Get the slot each variable is read from
+     * @return Slots parallel to getVariableNames()
+     */
+    const std::vector<size_t>& getVariableSlots() const { return variableSlots_; }
+
+    /**
+     * @brief Get the instruction tape
+     * @return Instructions in post-order execution order
+     */
+    const std::vector<Instruction>& getInstructions() const { return code_; }
+
+    /**
+     * @brief Get the constant pool
+     * @return Constants indexed by the lhs operand of LoadConstant
+     */
+    const std::vector<double>& getConstants() const { return constants_; }
+
+    /**
+     * @brief Whether the tape calls back into Expression::evaluate() for
+     *        nodes it could not lower
+     * @return true if it has Interpret instructions
+     */
+    bool hasInterpretedNodes() const { return !interpreted_.empty(); }
+
+    /**
+     * @brief Get the number of register slots the tape needs
+     * @return Minimum size of the scratch buffer passed to evaluate()
+     */
+    size_t getRegisterCount() const { return registerCount_; }
+
+private:
+    /**
+     * @brief Where a batch operand lives: a variable column or a register block
+     */
+    struct BatchSource {
+        bool isColumn;
+        std::uint32_t index;
+    };
+
+    struct BatchOperands {
+        BatchSource lhs;
+        BatchSource rhs;
+    };
+
+    /**
+     * @brief Record the result register and finish the tape once every
+     *        instruction has been emitted
+     */
+    void finish(std::uint32_t resultSlot);
+
+    void resolveBatchSources();
+
+    /**
+     * @brief Evaluate the tape for one sample
+     * @param variables Values for the interpreted nodes; built from values
+     *        when null
+     */
+    double run(const double* values, double* registers,
+               const std::map<std::string, double>* variables) const;
+
+    /**
+     * @brief Name-to-value map of one sample, for the interpreted nodes
+     */
+    std::map<std::string, double> makeVariableMap(const double* values) const;
+
+    std::vector<Instruction> code_;
+    std::vector<BatchOperands> batchOperands_;  // Parallel to code_
+    BatchSource batchResult_;
+    std::vector<double> constants_;
+    std::vector<const Expression*> interpreted_;  // Nodes of Interpret instructions
+    std::vector<std::string> variableNames_;
+    std::vector<size_t> variableSlots_;  // Parallel to variableNames_
+    size_t referencedCount_;             // Leading variableNames_ read by the tape's own loads
+    size_t registerCount_;
+    std::uint32_t resultSlot_;
+};
+
+} // namespace tt_int
+
+#endif // COMPILED_EXPRESSION_H
@@ -0,0 +1,127 @@
+#ifndef CONTROL_VARIATES_H
+#define CONTROL_VARIATES_H
+
+#include <cstddef>
+#include <vector>
+
+namespace tt_int {
+
+/**
+ * @brief Count, means and co-moments of the valid rows of a set of columns
+ *
+ * Column 0 is the target, columns 1 to q are the controls. A row is valid
+ * when none of its values is NaN; other rows are skipped in every column.
+ */
+struct ComomentStatistics {
+    size_t count = 0;
+    std::vector<double> mean;      // One per column
+    std::vector<double> comoment;  // Row-major sums of products of deviations from mean
+
+    /**
+     * @brief Empty statistics of a number of columns
+     */
+    explicit ComomentStatistics(size_t dimensions = 0);
+
+    /**
+     * @brief Get the number of columns
+     */
+    size_t getDimensions() const { return mean.size(); }
+
+    /**
+     * @brief Append the statistics of the rows that follow these ones
+     *
+     * Chan et al.'s pairwise combination extended to cross products; like
+     * SummaryStatistics::merge() the order of merges is part of the result.
+     *
+     * @param other Statistics of the following rows, with as many columns
+     */
+    void merge(const ComomentStatistics& other);
+};
+
+/**
+ * @brief Co-moments of one block of rows, computed in two passes
+ * @param columns Column k of the block starts at columns + k * stride
+ * @param stride Distance between the starts of consecutive columns
+ * @param count Number of rows
+ * @param out Statistics to overwrite; its dimensions select the columns read
+ */
+void summarizeComoments(const double* columns, size_t stride, size_t count, ComomentStatistics& out);
+
+/**
+ * @brief Reduces a sequence of block co-moments with a fixed-shape pairwise tree
+ *
+ * The co-moment counterpart of PairwiseReducer, with the same tree shape
+ * and the same rule for appending the reducer of a later run of blocks.
+ * Only the O(log n) pending nodes are kept, in one flat array: node k holds
+ * its means and then its co-moments. Adding blocks up to the maxBlocks
+ * given at construction never allocates.
+ */
+class ComomentReducer {
+public:
+    /**
+     * @brief Empty reducer
+     * @param dimensions Columns of the statistics added
+     * @param maxBlocks Blocks it will hold, to reserve the nodes for
+     */
+    explicit ComomentReducer(size_t dimensions = 0, size_t maxBlocks = 0);
+
+    /**
+     * @brief Add the co-moments of the next block
+     */
+    void add(const ComomentStatistics& block);
+
+    /**
+     * @brief Add the nodes of a reducer over the blocks that follow, in order
+     */
+    void append(const ComomentReducer& later);
+
+    /**
+     * @brief Co-moments of all blocks added so far
+     */
+    ComomentStatistics total() const;
+
+    /**
+     * @brief Number of blocks added so far
+     */
+    size_t getBlockCount() const;
+
+private:
+    void push(size_t count, size_t blocks, const double* mean, const double* comoment);
+
+    size_t dimensions_;
+    std::vector<size_t> counts_;   // Per node: rows
+    std::vector<size_t> blocks_;   // Per node: blocks covered
+    std::vector<double> values_;   // Per node: dimensions means, then dimensions^2 co-moments
+};
+
+/**
+ * @brief Mean of a target corrected by control variates
+ */
+struct ControlVariateEstimate {
+    double mean;                       ///< Controlled mean, NaN without valid rows
+    double standardError;              ///< Standard error of the controlled mean
+    std::vector<double> coefficients;  ///< Coefficient of each control
+};
+
+/**
+ * @brief Estimate a mean with control variates of known expectations
+ *
+ * The coefficients b minimize the variance of y - b . (c - E[c]): they solve
+ * the normal equations S_cc b = S_cy of the co-moments, by a Cholesky
+ * factorization that gives a control the coefficient 0 when it is constant
+ * or a linear combination of the controls before it. The standard error
+ * is that of the regression residuals, with one degree of freedom per
+ * control used.
+ *
+ * @param stats Co-moments of target and controls
+ * @param expectations Known expectation of each control, getDimensions() - 1 of them
+ * @return The controlled mean; mean and coefficients are NaN without
+ *         valid rows, and the standard error is NaN when no residual
+ *         degree of freedom is left
+ */
+ControlVariateEstimate estimateWithControls(const ComomentStatistics& stats,
+                                            const std::vector<double>& expectations);
+
+} // namespace tt_int
+
+#endif // CONTROL_VARIATES_H
@@ -1,60 +1,573 @@
 #ifndef DISTRIBUTION_H
 #define DISTRIBUTION_H
 
+#include <cmath>
+#include <cstdint>
+#include <memory>
 #include <random>
+#include <type_traits>
+#include "philox.h"
+#include "xoshiro.h"
 
 namespace tt_int {
 
+/**
+ * @brief True for engines with a fast native double conversion (nextDouble())
+ *
+ * Distributions use their own transforms on these engines instead of the
+ * <random> distribution objects.
+ */
+template <typename Engine>
+constexpr bool HAS_FAST_DOUBLE =
+    std::is_same_v<Engine, Xoshiro256PlusPlus> || std::is_same_v<Engine, Xoroshiro128Plus>;
+
+/**
+ * @brief Sampling state a distribution carries from one sample to the next
+ *
+ * Normal samplers produce variates in pairs and keep the second for the next
+ * call. That state belongs to a stream, not to a distribution: whoever owns
+ * the engine owns one SamplerState per variable, and passes it with the
+ * engine. Distributions are immutable after construction apart from one
+ * state of their own, used only by the overloads that take no SamplerState.
+ */
+struct SamplerState {
+    std::normal_distribution<double> standardNormal{0.0, 1.0};  // Pairs for std::mt19937 and Philox
+    double spare = 0.0;      // Second polar variate of the fast path
+    bool hasSpare = false;
+};
+
 /**
  * @brief Abstract base class for probability distributions
- * 
+ *
  * Distributions can be sampled to generate random values according to
  * their probability density function.
+ *
+ * There is one sample() overload per supported engine. Concrete distributions
+ * derive from DistributionBase and implement a single draw() template, so
+ * each overload is compiled against its concrete engine: the engine itself is
+ * never called through a virtual interface.
+ *
+ * Every sample() taking a SamplerState touches only the engine and the state
+ * passed in, so one distribution (and one VariableRegistry) can be shared by
+ * any number of threads, each with its own engine and states. The overloads
+ * without one continue a state kept in the object, like the original
+ * interface, and must not be called concurrently on one object.
+ *
+ * Subclasses written against the original interface, which override only
+ * sample(std::mt19937&), still work with std::mt19937: the state-taking
+ * overloads fall back to it. Other engines, and the cdf(), logPdf() and
+ * inverseCdf() based modes, throw std::logic_error for them until they
+ * override the corresponding members.
  */
 class Distribution {
 public:
     virtual ~Distribution() = default;
-    
+
+    /**
+     * @brief Sample a value, continuing this object's own sampling state
+     *
+     * The original sampling interface: consecutive calls continue one stream
+     * of normal pairs, as if the object held the std::normal_distribution
+     * itself. Not safe to call concurrently on one object; use the
+     * SamplerState overloads for shared distributions.
+     *
+     * @param rng Random number generator to use for sampling
+     * @return A random sample from the distribution
+     */
+    virtual double sample(std::mt19937& rng) const {
+        return sample(rng, ownState_);
+    }
+
     /**
      * @brief Sample a value from this distribution
+     *
+     * Calls sample(rng) by default, ignoring state, for subclasses that only
+     * implement the original interface. Subclasses must override at least
+     * one of the two.
+     *
+     * @param rng Random number generator to use for sampling
+     * @param state Sampling state of this variable on rng's stream
+     * @return A random sample from the distribution
+     */
+    virtual double sample(std::mt19937& rng, SamplerState& state) const;
+
+    /**
+     * @brief Sample a value using a counter-based Philox engine
+     * @param rng Random number generator to use for sampling
+     * @param state Sampling state of this variable on rng's stream
+     * @return A random sample from the distribution
+     */
+    virtual double sample(Philox4x32& rng, SamplerState& state) const;
+
+    /**
+     * @brief Sample a value using a xoshiro256++ engine
+     * @param rng Random number generator to use for sampling
+     * @param state Sampling state of this variable on rng's stream
+     * @return A random sample from the distribution
+     */
+    virtual double sample(Xoshiro256PlusPlus& rng, SamplerState& state) const;
+
+    /**
+     * @brief Sample a value using a xoroshiro128+ engine
+     * @param rng Random number generator to use for sampling
+     * @param state Sampling state of this variable on rng's stream
+     * @return A random sample from the distribution
+     */
+    virtual double sample(Xoroshiro128Plus& rng, SamplerState& state) const;
+
+    /**
+     * @brief Fill a block with samples in one virtual call
+     *
+     * With std::mt19937 this is exactly count calls of sample(rng), so the
+     * engine's sequence is consumed as before. The other engines use block
+     * kernels that draw uniforms in bulk and transform them in separate
+     * loops, so they may consume the engine differently from sample(rng).
+     * The default makes count scalar calls.
+     *
+     * @param rng Random number generator to use for sampling
+     * @param state Sampling state of this variable on rng's stream
+     * @param out Destination for count samples
+     * @param count Number of samples
+     */
+    virtual void sample(std::mt19937& rng, SamplerState& state, double* out, size_t count) const;
+
+    /**
+     * @brief Fill a block with samples using a counter-based Philox engine
+     */
+    virtual void sample(Philox4x32& rng, SamplerState& state, double* out, size_t count) const;
+
+    /**
+     * @brief Fill a block with samples using a xoshiro256++ engine
+     */
+    virtual void sample(Xoshiro256PlusPlus& rng, SamplerState& state, double* out, size_t count) const;
+
+    /**
+     * @brief Fill a block with samples using a xoroshiro128+ engine
+     */
+    virtual void sample(Xoroshiro128Plus& rng, SamplerState& state, double* out, size_t count) const;
+
+    /**
+     * @brief Sample a value with another engine, continuing this object's
+     *        own sampling state
+     *
+     * Like sample(std::mt19937&): not safe to call concurrently on one object.
+     *
      * @param rng Random number generator to use for sampling
      * @return A random sample from the distribution
      */
-    virtual double sample(std::mt19937& rng) const = 0;
+    template <typename Engine>
+    double sample(Engine& rng) const {
+        return sample(rng, ownState_);
+    }
+
+    /**
+     * @brief Fill a block with samples, continuing this object's own sampling state
+     *
+     * Not safe to call concurrently on one object.
+     *
+     * @param rng Random number generator to use for sampling
+     * @param out Destination for count samples
+     * @param count Number of samples
+     */
+    template <typename Engine>
+    void sample(Engine& rng, double* out, size_t count) const {
+        sample(rng, ownState_, out, count);
+    }
+
+    /**
+     * @brief Number of std::mt19937 outputs one sample consumes
+     *
+     * Lets a std::mt19937 stream be split by jumping ahead (see Mt19937Jump)
+     * rather than by drawing every value before the split point.
+     *
+     * @return The fixed count, or 0 if it varies from sample to sample (for
+     *         example with rejection sampling)
+     */
+    virtual size_t getFixedDrawCount() const { return 0; }
+
+    /**
+     * @brief Cumulative distribution function
+     * @param x Value
+     * @return P(X <= x)
+     * @throws std::logic_error unless overridden
+     */
+    virtual double cdf(double x) const;
+
+    /**
+     * @brief Natural logarithm of the probability density function
+     *
+     * Used by importance sampling to weigh a sample drawn from a proposal
+     * distribution by the likelihood ratio of the target.
+     *
+     * @param x Value
+     * @return log f(x); -infinity outside the support
+     * @throws std::logic_error unless overridden
+     */
+    virtual double logPdf(double x) const;
+
+    /**
+     * @brief Apply logPdf() to a block of values
+     * @param x count values
+     * @param out Destination for count log densities; may be x itself
+     * @param count Number of values
+     */
+    virtual void logPdf(const double* x, double* out, size_t count) const {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = logPdf(x[i]);
+        }
+    }
+
+    /**
+     * @brief Inverse of the cumulative distribution function
+     *
+     * Maps a uniform variate in (0, 1) to a sample of this distribution.
+     * Used by the quasi-Monte Carlo sampler, which replaces random draws
+     * with transformed low-discrepancy points.
+     *
+     * @param p Probability in [0, 1]
+     * @return The p-quantile; the support's bounds at 0 and 1
+     * @throws std::logic_error unless overridden
+     */
+    virtual double inverseCdf(double p) const;
+
+    /**
+     * @brief Apply inverseCdf() to a block of probabilities
+     * @param p count probabilities
+     * @param out Destination for count quantiles; may be p itself
+     * @param count Number of values
+     */
+    virtual void inverseCdf(const double* p, double* out, size_t count) const {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = inverseCdf(p[i]);
+        }
+    }
+
+    /**
+     * @brief Antithetic counterparts of a block of samples
+     *
+     * The counterpart of x is the value at the mirrored quantile,
+     * inverseCdf(1 - cdf(x)): it is distributed like x and as negatively
+     * correlated with it as possible. Subclasses with a closed form (a
+     * reflection about the median for symmetric distributions) override this.
+     *
+     * @param in count samples
+     * @param out Destination for count counterparts; may be in itself
+     * @param count Number of values
+     */
+    virtual void antithetic(const double* in, double* out, size_t count) const {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = inverseCdf(1.0 - cdf(in[i]));
+        }
+    }
+
+    /**
+     * @brief Create an independent copy with the same parameters
+     *
+     * Sharing one distribution through the SamplerState overloads is
+     * equally safe; clone() is for callers that want an owned copy. The
+     * copy starts with fresh sampling state of its own.
+     *
+     * @return The new distribution
+     * @throws std::logic_error unless overridden
+     */
+    virtual std::unique_ptr<Distribution> clone() const;
+
+private:
+    mutable SamplerState ownState_;  // Used only by the overloads without a SamplerState
+};
+
+/**
+ * @brief Draw 64 random bits: one output of a 64-bit engine, two of a 32-bit one
+ */
+template <typename Engine>
+std::uint64_t nextBits64(Engine& rng) {
+    if constexpr (HAS_FAST_DOUBLE<Engine>) {
+        return rng();
+    } else {
+        static_assert(Engine::max() == 0xffffffffu, "expects a 32-bit engine");
+        const std::uint64_t high = rng();
+        return (high << 32) | rng();
+    }
+}
+
+/**
+ * @brief Fill out with doubles uniformly distributed in [0, 1), straight
+ *        from engine bits (53 bits per value)
+ */
+template <typename Engine>
+void fillUnitDoubles(Engine& rng, double* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = toUnitDouble(nextBits64(rng));
+    }
+}
+
+/**
+ * @brief Layer tables of a 128-layer Ziggurat for the standard normal
+ *
+ * Marsaglia and Tsang's method ("The Ziggurat Method for Generating Random
+ * Variables", 2000) in Doornik's formulation (2005), which draws the layer
+ * and the uniform from independent bits.
+ */
+struct ZigguratTables {
+    static constexpr size_t LAYERS = 128;
+    static constexpr double TAIL_START = 3.442619855899;      // R, start of the tail
+    static constexpr double LAYER_AREA = 9.91256303526217e-3; // V, area of every layer
+
+    double x[LAYERS + 1];  // Layer edges, decreasing; x[0] is the base layer's pseudo-width
+    double ratio[LAYERS];  // x[i + 1] / x[i]: |u| below this is inside the layer's core
+
+    /**
+     * @brief The tables, built on first use and shared by the whole process
+     */
+    static const ZigguratTables& get();
+};
+
+/**
+ * @brief How NormalDistribution turns uniform bits into normal samples
+ */
+enum class NormalSampler {
+    Default,  ///< std::normal_distribution for all std::mt19937 draws and scalar Philox draws; Box-Muller for block draws of other engines (including Philox, so chunked runs), polar for their scalar draws
+    Ziggurat,  ///< 128-layer Ziggurat for every engine; one 64-bit draw for ~99% of samples
+    BoxMuller  ///< One Box-Muller transform per sample from two 64-bit draws, keeping the cosine variate; stateless with a fixed draw count, so runs can partition the std::mt19937 stream
+};
+
+/**
+ * @brief Implements every Distribution::sample overload via Derived::draw()
+ *        and Derived::drawBlock()
+ * @tparam Derived Concrete distribution with
+ *         `template <typename Engine> double draw(Engine& rng, SamplerState& state) const` and
+ *         `template <typename Engine> void drawBlock(Engine& rng, SamplerState& state, double* out, size_t count) const`
+ *         members
+ */
+template <typename Derived>
+class DistributionBase : public Distribution {
+public:
+    using Distribution::sample;
+
+    double sample(std::mt19937& rng, SamplerState& state) const override {
+        return derived().draw(rng, state);
+    }
+    double sample(Philox4x32& rng, SamplerState& state) const override {
+        return derived().draw(rng, state);
+    }
+    double sample(Xoshiro256PlusPlus& rng, SamplerState& state) const override {
+        return derived().draw(rng, state);
+    }
+    double sample(Xoroshiro128Plus& rng, SamplerState& state) const override {
+        return derived().draw(rng, state);
+    }
+
+    void sample(std::mt19937& rng, SamplerState& state, double* out, size_t count) const override {
+        derived().drawBlock(rng, state, out, count);
+    }
+    void sample(Philox4x32& rng, SamplerState& state, double* out, size_t count) const override {
+        derived().drawBlock(rng, state, out, count);
+    }
+    void sample(Xoshiro256PlusPlus& rng, SamplerState& state, double* out, size_t count) const override {
+        derived().drawBlock(rng, state, out, count);
+    }
+    void sample(Xoroshiro128Plus& rng, SamplerState& state, double* out, size_t count) const override {
+        derived().drawBlock(rng, state, out, count);
+    }
+
+private:
+    const Derived& derived() const { return static_cast<const Derived&>(*this); }
 };
 
 /**
  * @brief Normal (Gaussian) distribution
- * 
+ *
  * Generates samples from a normal distribution with specified mean and
  * standard deviation.
  */
-class NormalDistribution : public Distribution {
+class NormalDistribution : public DistributionBase<NormalDistribution> {
 public:
     /**
      * @brief Construct a normal distribution
      * @param mean The mean (μ) of the distribution
      * @param stddev The standard deviation (σ) of the distribution
+     * @param sampler Sampling method; Default keeps the std::mt19937 stream unchanged
+     */
+    NormalDistribution(double mean, double stddev, NormalSampler sampler = NormalSampler::Default);
+
+    /**
+     * @brief Draw one sample with a concrete engine
+     *
+     * With the default sampler, engines with a fast double conversion use a
+     * Marsaglia polar transform on nextDouble(); others use
+     * std::normal_distribution, so the std::mt19937 stream is unchanged.
+     * Either way the pair's second variate is kept in state.
+     */
+    template <typename Engine>
+    double draw(Engine& rng, SamplerState& state) const {
+        if (sampler_ == NormalSampler::Ziggurat) {
+            return mean_ + stddev_ * drawZiggurat(rng);
+        }
+        if (sampler_ == NormalSampler::BoxMuller) {
+            return drawBoxMuller(rng);
+        }
+        if constexpr (HAS_FAST_DOUBLE<Engine>) {
+            if (state.hasSpare) {
+                state.hasSpare = false;
+                return mean_ + stddev_ * state.spare;
+            }
+            double u, v, s;
+            do {
+                u = 2.0 * rng.nextDouble() - 1.0;
+                v = 2.0 * rng.nextDouble() - 1.0;
+                s = u * u + v * v;
+            } while (s >= 1.0 || s == 0.0);
+            const double factor = std::sqrt(-2.0 * std::log(s) / s);
+            state.spare = v * factor;
+            state.hasSpare = true;
+            return mean_ + stddev_ * (u * factor);
+        } else {
+            // Same arithmetic as std::normal_distribution(mean, stddev)
+            return state.standardNormal(rng) * stddev_ + mean_;
+        }
+    }
+
+    /**
+     * @brief Fill a block of samples with a concrete engine
+     *
+     * std::mt19937 keeps std::normal_distribution. Other engines use
+     * Box-Muller over the block: all uniforms are drawn first, then radius
+     * and angle are computed in branch-free loops over contiguous halves of
+     * the block, which the compiler can vectorize.
+     */
+    template <typename Engine>
+    void drawBlock(Engine& rng, SamplerState& state, double* out, size_t count) const {
+        if (sampler_ == NormalSampler::Ziggurat) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = mean_ + stddev_ * drawZiggurat(rng);
+            }
+        } else if (sampler_ == NormalSampler::BoxMuller) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = drawBoxMuller(rng);
+            }
+        } else if constexpr (std::is_same_v<Engine, std::mt19937>) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = draw(rng, state);
+            }
+        } else {
+            const size_t pairs = count / 2;
+            fillUnitDoubles(rng, out, 2 * pairs);
+            boxMuller(out, pairs);
+            if (count % 2 != 0) {
+                double last[2];
+                fillUnitDoubles(rng, last, 2);
+                boxMuller(last, 1);
+                out[count - 1] = last[0];
+            }
+        }
+    }
+
+    /**
+     * @brief Four std::mt19937 outputs (two 64-bit draws) per sample with
+     *        NormalSampler::BoxMuller; the other samplers use rejection or
+     *        carry a spare variate, so their count varies
+     */
+    size_t getFixedDrawCount() const override {
+        return sampler_ == NormalSampler::BoxMuller ? 4 : 0;
+    }
+
+    using Distribution::inverseCdf;
+    using Distribution::logPdf;
+
+    double cdf(double x) const override;
+    double logPdf(double x) const override;
+    void logPdf(const double* x, double* out, size_t count) const override;
+
+    /**
+     * @brief Normal quantile, accurate to a few ulps
+     *
+     * Acklam's rational approximation refined by one Halley step on erfc().
      */
-    NormalDistribution(double mean, double stddev);
-    
-    double sample(std::mt19937& rng) const override;
-    
+    double inverseCdf(double p) const override;
+
+    /**
+     * @brief Reflect samples about the mean: 2 * mean - x
+     */
+    void antithetic(const double* in, double* out, size_t count) const override;
+
+    std::unique_ptr<Distribution> clone() const override;
+
     double getMean() const { return mean_; }
     double getStddev() const { return stddev_; }
-    
+    NormalSampler getSampler() const { return sampler_; }
+
 private:
+    /**
+     * @brief One standard normal variate from the Ziggurat
+     */
+    template <typename Engine>
+    double drawZiggurat(Engine& rng) const {
+        const ZigguratTables& table = *ziggurat_;
+        for (;;) {
+            // Bits 11-63 give the uniform, bits 4-10 the layer
+            const std::uint64_t bits = nextBits64(rng);
+            const double u = 2.0 * toUnitDouble(bits) - 1.0;
+            const size_t layer = (bits >> 4) & (ZigguratTables::LAYERS - 1);
+            if (std::abs(u) < table.ratio[layer]) {
+                return u * table.x[layer];
+            }
+            if (layer == 0) {
+                return drawZigguratTail(rng, u < 0.0);
+            }
+            // Wedge between the layer's core and the density curve
+            const double x = u * table.x[layer];
+            const double f0 = std::exp(-0.5 * (table.x[layer] * table.x[layer] - x * x));
+            const double f1 = std::exp(-0.5 * (table.x[layer + 1] * table.x[layer + 1] - x * x));
+            if (f1 + toUnitDouble(nextBits64(rng)) * (f0 - f1) < 1.0) {
+                return x;
+            }
+        }
+    }
+
+    // Box-Muller from one pair of uniforms; the sine variate is dropped so
+    // every sample takes the same draws
+    template <typename Engine>
+    double drawBoxMuller(Engine& rng) const {
+        constexpr double TWO_PI = 6.283185307179586476925286766559;
+        const double u = toUnitDouble(nextBits64(rng));
+        const double v = toUnitDouble(nextBits64(rng));
+        // 1 - u lies in (0, 1], so the logarithm is finite
+        const double radius = stddev_ * std::sqrt(-2.0 * std::log(1.0 - u));
+        return mean_ + radius * std::cos(TWO_PI * v);
+    }
+
+    // Marsaglia's exact sampler for |x| > TAIL_START
+    template <typename Engine>
+    double drawZigguratTail(Engine& rng, bool negative) const {
+        constexpr double R = ZigguratTables::TAIL_START;
+        double x, y;
+        do {
+            x = std::log(1.0 - toUnitDouble(nextBits64(rng))) / R;
+            y = std::log(1.0 - toUnitDouble(nextBits64(rng)));
+        } while (-2.0 * y < x * x);
+        return negative ? x - R : R - x;
+    }
+
+    /**
+     * @brief Turn pairs of uniforms into normal samples in place
+     * @param values 2 * pairs uniforms in [0, 1); pair i is values[i] and
+     *        values[i + pairs]
+     * @param pairs Number of pairs
+     */
+    void boxMuller(double* values, size_t pairs) const;
+
     double mean_;
     double stddev_;
-    mutable std::normal_distribution<double> dist_;
+    NormalSampler sampler_;
+    const ZigguratTables* ziggurat_;  // Shared tables, resolved once at construction
 };
 
 /**
  * @brief Uniform distribution over a continuous range
- * 
+ *
  * Generates samples uniformly distributed between min and max (inclusive).
  */
-class UniformDistribution : public Distribution {
+class UniformDistribution : public DistributionBase<UniformDistribution> {
 public:
     /**
      * @brief Construct a uniform distribution
@@ -62,16 +575,68 @@ public:
      * @param max The maximum value of the range (inclusive)
      */
     UniformDistribution(double min, double max);
-    
-    double sample(std::mt19937& rng) const override;
-    
+
+    /**
+     * @brief Draw one sample with a concrete engine
+     */
+    template <typename Engine>
+    double draw(Engine& rng, SamplerState&) const {
+        if constexpr (HAS_FAST_DOUBLE<Engine>) {
+            return min_ + (max_ - min_) * rng.nextDouble();
+        } else {
+            return std::uniform_real_distribution<double>(min_, max_)(rng);
+        }
+    }
+
+    /**
+     * @brief Each sample is one std::generate_canonical<double, 53> call,
+     *        which takes exactly two 32-bit outputs
+     */
+    size_t getFixedDrawCount() const override { return 2; }
+
+    /**
+     * @brief Fill a block of samples with a concrete engine
+     *
+     * std::mt19937 keeps std::uniform_real_distribution; other engines
+     * convert engine bits to doubles directly and scale them in one loop.
+     */
+    template <typename Engine>
+    void drawBlock(Engine& rng, SamplerState&, double* out, size_t count) const {
+        if constexpr (std::is_same_v<Engine, std::mt19937>) {
+            std::uniform_real_distribution<double> dist(min_, max_);
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = dist(rng);
+            }
+        } else {
+            fillUnitDoubles(rng, out, count);
+            const double width = max_ - min_;
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = min_ + width * out[i];
+            }
+        }
+    }
+
+    using Distribution::inverseCdf;
+    using Distribution::logPdf;
+
+    double cdf(double x) const override;
+    double logPdf(double x) const override;
+    double inverseCdf(double p) const override;
+    void inverseCdf(const double* p, double* out, size_t count) const override;
+
+    /**
+     * @brief Reflect samples about the midpoint: min + max - x
+     */
+    void antithetic(const double* in, double* out, size_t count) const override;
+
+    std::unique_ptr<Distribution> clone() const override;
+
     double getMin() const { return min_; }
     double getMax() const { return max_; }
-    
+
 private:
     double min_;
     double max_;
-    mutable std::uniform_real_distribution<double> dist_;
 };
 
 } // namespace tt_int
@@ -23,6 +23,31 @@ public:
      * @return The result of evaluating the expression
      */
     virtual double evaluate(const std::map<std::string, double>& variables) const = 0;
+    
+    /**
+     * @brief Structural hash of the expression
+     * 
+     * Structurally identical expressions hash equally, whether or not they
+     * share nodes. The value is stable across runs and processes.
+     * 
+     * The default hashes the node's address, matching the default equals();
+     * it is not stable across runs.
+     * 
+     * @return Hash of the node kind, its payload and its operands
+     */
+    virtual size_t hash() const;
+    
+    /**
+     * @brief Structural equality
+     * 
+     * The default is identity, so common subexpression elimination never
+     * merges two distinct nodes of a type that does not override it.
+     * 
+     * @param other Expression to compare with
+     * @return true if both expressions have the same shape, operators,
+     *         constants (compared bit for bit) and variable names
+     */
+    virtual bool equals(const Expression& other) const;
 };
 
 /**
@@ -38,6 +63,11 @@ public:
     
     double evaluate(const std::map<std::string, double>& variables) const override;
     
+    size_t hash() const override;
+    bool equals(const Expression& other) const override;
+    
+    double getValue() const { return value_; }
+    
 private:
     double value_;
 };
@@ -55,6 +85,11 @@ public:
     
     double evaluate(const std::map<std::string, double>& variables) const override;
     
+    size_t hash() const override;
+    bool equals(const Expression& other) const override;
+    
+    const std::string& getName() const { return name_; }
+    
 private:
     std::string name_;
 };
@@ -84,12 +119,26 @@ public:
              std::shared_ptr<Expression> right,
              BinaryOperator op);
     
+    /**
+     * @brief Release the operands iteratively, so that tearing down a deep
+     *        operator chain cannot overflow the call stack
+     */
+    ~BinaryOp() override;
+    
     double evaluate(const std::map<std::string, double>& variables) const override;
     
+    size_t hash() const override { return hash_; }
+    bool equals(const Expression& other) const override;
+    
+    const std::shared_ptr<Expression>& getLeft() const { return left_; }
+    const std::shared_ptr<Expression>& getRight() const { return right_; }
+    BinaryOperator getOperator() const { return op_; }
+    
 private:
     std::shared_ptr<Expression> left_;
     std::shared_ptr<Expression> right_;
     BinaryOperator op_;
+    size_t hash_;  // Computed once at construction; nodes are immutable
 };
 
 } // namespace tt_int
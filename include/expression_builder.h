@@ -2,6 +2,7 @@
 #define EXPRESSION_BUILDER_H
 
 #include "expression.h"
+#include "expression_graph.h"
 #include <memory>
 #include <string>
 
@@ -139,6 +140,112 @@ ExpressionBuilder operator*(double lhs, const ExpressionBuilder& rhs);
  */
 ExpressionBuilder operator/(double lhs, const ExpressionBuilder& rhs);
 
+/**
+ * @brief Fluent API for building expressions in an ExpressionGraph arena
+ *
+ * Same syntax as ExpressionBuilder, but every operator appends a tagged node
+ * to the graph instead of allocating a shared Expression node. A builder is
+ * just a graph pointer and a node id, so copying one is free. The graph must
+ * outlive every builder that refers to it.
+ */
+class GraphExpressionBuilder {
+private:
+    ExpressionGraph* graph_;
+    ExpressionGraph::NodeId id_;
+
+public:
+    /**
+     * @brief Construct builder from an existing graph node
+     * @param graph The graph owning the node
+     * @param id The node to wrap
+     */
+    GraphExpressionBuilder(ExpressionGraph& graph, ExpressionGraph::NodeId id);
+
+    /**
+     * @brief Create a constant node
+     * @param graph The graph to add the node to
+     * @param value The constant value
+     * @return GraphExpressionBuilder wrapping the new node
+     */
+    static GraphExpressionBuilder constant(ExpressionGraph& graph, double value);
+
+    /**
+     * @brief Create a variable node
+     * @param graph The graph to add the node to
+     * @param name The variable name
+     * @return GraphExpressionBuilder wrapping the new node
+     */
+    static GraphExpressionBuilder variable(ExpressionGraph& graph, const std::string& name);
+
+    /**
+     * @brief Addition operator
+     * @param other The right-hand operand, from the same graph
+     * @return New GraphExpressionBuilder representing this + other
+     * @throws std::invalid_argument if the operands belong to different graphs
+     */
+    GraphExpressionBuilder operator+(const GraphExpressionBuilder& other) const;
+
+    /**
+     * @brief Subtraction operator
+     * @param other The right-hand operand, from the same graph
+     * @return New GraphExpressionBuilder representing this - other
+     * @throws std::invalid_argument if the operands belong to different graphs
+     */
+    GraphExpressionBuilder operator-(const GraphExpressionBuilder& other) const;
+
+    /**
+     * @brief Multiplication operator
+     * @param other The right-hand operand, from the same graph
+     * @return New GraphExpressionBuilder representing this * other
+     * @throws std::invalid_argument if the operands belong to different graphs
+     */
+    GraphExpressionBuilder operator*(const GraphExpressionBuilder& other) const;
+
+    /**
+     * @brief Division operator
+     * @param other The right-hand operand, from the same graph
+     * @return New GraphExpressionBuilder representing this / other
+     * @throws std::invalid_argument if the operands belong to different graphs
+     */
+    GraphExpressionBuilder operator/(const GraphExpressionBuilder& other) const;
+
+    /**
+     * @brief Get the wrapped node id
+     * @return Id of the node in getGraph()
+     */
+    ExpressionGraph::NodeId getId() const { return id_; }
+
+    /**
+     * @brief Get the graph owning the node
+     * @return The graph
+     */
+    ExpressionGraph& getGraph() const { return *graph_; }
+
+    /**
+     * @brief Convert the wrapped expression to an Expression tree
+     *
+     * Allocates one Expression node per reachable graph node. To evaluate,
+     * pass getGraph() and getId() to MonteCarloEvaluator or CompiledExpression
+     * instead, which read the graph directly.
+     *
+     * @return Shared pointer to the equivalent expression
+     */
+    std::shared_ptr<Expression> get() const { return graph_->toExpression(id_); }
+
+private:
+    GraphExpressionBuilder combine(const GraphExpressionBuilder& other, BinaryOperator op) const;
+};
+
+// Mixed operations between graph builders and constants
+GraphExpressionBuilder operator+(const GraphExpressionBuilder& lhs, double rhs);
+GraphExpressionBuilder operator-(const GraphExpressionBuilder& lhs, double rhs);
+GraphExpressionBuilder operator*(const GraphExpressionBuilder& lhs, double rhs);
+GraphExpressionBuilder operator/(const GraphExpressionBuilder& lhs, double rhs);
+GraphExpressionBuilder operator+(double lhs, const GraphExpressionBuilder& rhs);
+GraphExpressionBuilder operator-(double lhs, const GraphExpressionBuilder& rhs);
+GraphExpressionBuilder operator*(double lhs, const GraphExpressionBuilder& rhs);
+GraphExpressionBuilder operator/(double lhs, const GraphExpressionBuilder& rhs);
+
 } // namespace tt_int
 
 #endif // EXPRESSION_BUILDER_H
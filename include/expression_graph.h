@@ -0,0 +1,150 @@
+#ifndef EXPRESSION_GRAPH_H
+#define EXPRESSION_GRAPH_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "expression.h"
+
+namespace tt_int {
+
+/**
+ * @brief Kind of an ExpressionGraph node
+ */
+enum class NodeKind : std::uint8_t {
+    Constant,   ///< value holds the constant
+    Variable,   ///< lhs indexes the graph's variable name table
+    Add,        ///< lhs + rhs
+    Subtract,   ///< lhs - rhs
+    Multiply,   ///< lhs * rhs
+    Divide      ///< lhs / rhs, NaN when rhs == 0
+};
+
+/**
+ * @brief Arena of tagged expression nodes
+ *
+ * An alternative to the Expression class hierarchy for large models: every
+ * node is a small plain value stored contiguously in one vector and referred
+ * to by index, so building a node is a push_back instead of a shared_ptr
+ * allocation, copying a reference to a node copies an integer, and tearing
+ * down a million-node model frees a handful of buffers. Evaluation switches
+ * on the node tag instead of calling through a vtable.
+ *
+ * Operands are always created before the nodes that use them, so node ids
+ * are a topological order and evaluation is a single forward pass without
+ * recursion. A node may be used by several parents, which makes the graph a
+ * DAG whose shared nodes are evaluated once.
+ */
+class ExpressionGraph {
+public:
+    using NodeId = std::uint32_t;
+
+    /**
+     * @brief A single tagged node
+     */
+    struct Node {
+        NodeKind kind;
+        std::uint32_t lhs;  ///< Left operand id, or variable index for Variable
+        std::uint32_t rhs;  ///< Right operand id; unused for leaves
+        double value;       ///< Constant value; unused otherwise
+    };
+
+    /**
+     * @brief Reserve arena capacity
+     * @param nodeCount Number of nodes the graph is expected to hold
+     */
+    void reserve(size_t nodeCount) { nodes_.reserve(nodeCount); }
+
+    /**
+     * @brief Add a constant node
+     * @param value The constant value
+     * @return Id of the new node
+     */
+    NodeId constant(double value);
+
+    /**
+     * @brief Add a variable node
+     * @param name The variable name
+     * @return Id of the new node
+     */
+    NodeId variable(const std::string& name);
+
+    /**
+     * @brief Add a binary operation node
+     * @param op The operator to apply
+     * @param lhs Id of the left operand
+     * @param rhs Id of the right operand
+     * @return Id of the new node
+     * @throws std::invalid_argument if an operand id is not in this graph
+     */
+    NodeId binary(BinaryOperator op, NodeId lhs, NodeId rhs);
+
+    /**
+     * @brief Evaluate the expression rooted at a node
+     *
+     * Only nodes reachable from root are evaluated, each exactly once.
+     *
+     * @param root Id of the root node
+     * @param variables Map of variable names to their values
+     * @return The result of evaluating the expression
+     * @throws std::invalid_argument if root is not in this graph
+     * @throws std::out_of_range if a referenced variable is missing
+     */
+    double evaluate(NodeId root, const std::map<std::string, double>& variables) const;
+
+    /**
+     * @brief Convert the expression rooted at a node to an Expression tree
+     *
+     * Shared graph nodes become shared Expression nodes, so the result can be
+     * passed to the optimizer, CompiledExpression or MonteCarloEvaluator.
+     *
+     * @param root Id of the root node
+     * @return Root of the equivalent Expression
+     * @throws std::invalid_argument if root is not in this graph
+     */
+    std::shared_ptr<Expression> toExpression(NodeId root) const;
+
+    /**
+     * @brief Get a node by id
+     * @param id Node id
+     * @return The node
+     */
+    const Node& getNode(NodeId id) const { return nodes_[id]; }
+
+    /**
+     * @brief Get the name of a variable node's variable
+     * @param index Variable index (Node::lhs of a Variable node)
+     * @return The variable name
+     */
+    const std::string& getVariableName(std::uint32_t index) const { return variableNames_[index]; }
+
+    /**
+     * @brief Get the number of nodes in the arena
+     * @return Node count
+     */
+    size_t size() const { return nodes_.size(); }
+
+    /**
+     * @brief Remove every node; previously returned ids become invalid
+     */
+    void clear();
+
+private:
+    NodeId push(const Node& node);
+
+    /**
+     * @brief Mark the nodes reachable from root
+     * @return One flag per node id up to and including root
+     */
+    std::vector<bool> reachableFrom(NodeId root) const;
+
+    std::vector<Node> nodes_;
+    std::vector<std::string> variableNames_;
+    std::map<std::string, std::uint32_t> variableIndex_;
+};
+
+} // namespace tt_int
+
+#endif // EXPRESSION_GRAPH_H
@@ -0,0 +1,78 @@
+#ifndef EXPRESSION_OPTIMIZER_H
+#define EXPRESSION_OPTIMIZER_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include "expression.h"
+
+namespace tt_int {
+
+/**
+ * @brief Result of an optimization pass over an expression tree
+ */
+struct OptimizationResult {
+    std::shared_ptr<Expression> expression;  ///< The optimized expression
+    size_t nodesRemoved;                     ///< Distinct nodes eliminated by the pass
+};
+
+/**
+ * @brief Count the distinct nodes of an expression
+ * @param expr Root of the expression
+ * @return Number of distinct nodes; a subtree shared by several parents counts once
+ */
+size_t countNodes(const std::shared_ptr<Expression>& expr);
+
+/**
+ * @brief Collect the free variables of an expression
+ * @param expr Root of the expression
+ * @return Names of all variables the expression references
+ */
+std::set<std::string> collectVariables(const std::shared_ptr<Expression>& expr);
+
+/**
+ * @brief Fold constants and apply safe algebraic identities
+ *
+ * Works bottom-up and never modifies the input; unchanged subtrees are
+ * shared with the original. The pass:
+ * - folds every constant-only subtree into a single Constant, using
+ *   BinaryOp::evaluate so a constant division by zero still folds to NaN;
+ * - rewrites x * 1, 1 * x, x + 0, 0 + x, x - 0 and x / 1 to x;
+ * - rewrites x / c to x * (1 / c) for a constant c whose reciprocal is a
+ *   normal number. Unless c is a power of two this may differ from the
+ *   division in the last bit.
+ *
+ * Identities that would change NaN or infinity results (such as x * 0 -> 0
+ * or x / x -> 1) are not applied, and divisions by a constant zero are kept
+ * so they still yield NaN at evaluation time.
+ *
+ * @param expr Root of the expression to simplify
+ * @return The simplified expression and the number of nodes removed
+ */
+OptimizationResult simplify(const std::shared_ptr<Expression>& expr);
+
+/**
+ * @brief Merge structurally identical subtrees (hash-consing)
+ *
+ * Turns the tree into a DAG in which every distinct subexpression is
+ * represented by exactly one node, using Expression::hash() and
+ * Expression::equals(). CompiledExpression emits each shared node once, so
+ * after this pass every distinct subexpression is computed once per sample.
+ * The input is not modified.
+ *
+ * @param expr Root of the expression
+ * @return The deduplicated expression and the number of nodes removed
+ */
+OptimizationResult eliminateCommonSubexpressions(const std::shared_ptr<Expression>& expr);
+
+/**
+ * @brief Run the full optimization pipeline: simplify(), then
+ *        eliminateCommonSubexpressions()
+ * @param expr Root of the expression
+ * @return The optimized expression and the total number of nodes removed
+ */
+OptimizationResult optimize(const std::shared_ptr<Expression>& expr);
+
+} // namespace tt_int
+
+#endif // EXPRESSION_OPTIMIZER_H
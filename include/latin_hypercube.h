@@ -0,0 +1,43 @@
+#ifndef LATIN_HYPERCUBE_H
+#define LATIN_HYPERCUBE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tt_int {
+
+/**
+ * @brief Element of a pseudo-random permutation of 0..n-1, computed on its own
+ *
+ * Kensler's hashed permutation ("Correlated Multi-Jittered Sampling", 2013):
+ * a bijection on the next power of two, cycle-walked into [0, n). Any
+ * element costs O(1) time and no memory, so a design over billions of
+ * points can be generated in parallel slices.
+ *
+ * @param index Position, below n
+ * @param n Length of the permutation, at least 1
+ * @param seed Selects the permutation
+ * @return The element at index
+ */
+std::uint32_t permuteIndex(std::uint32_t index, std::uint32_t n, std::uint32_t seed);
+
+/**
+ * @brief One coordinate of consecutive points of a Latin hypercube design
+ *
+ * Point i of an n-point design lies in stratum permuteIndex(i, n, seed) of
+ * [0, 1), at a uniformly jittered position inside it. Every stratum of
+ * width 1/n holds exactly one of the n points, and with a different seed
+ * per coordinate the strata are paired at random across coordinates.
+ *
+ * @param start Index of the first point
+ * @param count Number of points; start + count must not exceed n
+ * @param n Points in the design, below 2^32
+ * @param seed Permutation and jitter of this coordinate
+ * @param out Destination for count values in (0, 1)
+ */
+void fillLatinHypercube(std::uint64_t start, size_t count, std::uint64_t n,
+                        std::uint32_t seed, double* out);
+
+} // namespace tt_int
+
+#endif // LATIN_HYPERCUBE_H
@@ -1,11 +1,17 @@
 #ifndef MONTE_CARLO_EVALUATOR_H
 #define MONTE_CARLO_EVALUATOR_H
 
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <memory>
 #include <random>
 #include <optional>
+#include "compiled_expression.h"
 #include "expression.h"
+#include "expression_graph.h"
+#include "native_kernel.h"
+#include "static_expression.h"
 #include "variable_registry.h"
 
 namespace tt_int {
@@ -26,16 +32,137 @@ struct ConvergencePoint {
  * @brief Result of a Monte Carlo simulation
  * 
  * Contains the raw samples and computed statistics from the simulation.
+ * Under importance sampling (MonteCarloEvaluator::setImportanceSampling())
+ * mean, stddev and standardError are weighted by exp(logWeights).
  */
 struct SimulationResult {
     std::vector<double> samples;        ///< All samples including NaN values
-    double mean;                         ///< Mean of valid (non-NaN) samples
+    double mean;                         ///< Mean of valid (non-NaN) samples, or of complete antithetic pairs; corrected by any control variates
     double stddev;                       ///< Standard deviation of valid samples
+    double standardError;                ///< Standard error of mean (see MonteCarloEvaluator::setSamplingMethod())
     double min;                          ///< Minimum of valid samples
     double max;                          ///< Maximum of valid samples
     size_t validSampleCount;            ///< Number of non-NaN samples
     size_t totalSampleCount;            ///< Total number of samples
+    bool usedNativeKernel;              ///< Whether samples were evaluated by a native kernel
+    bool partitionedStream;             ///< Whether a parallel run split the sequential stream (see MonteCarloEvaluator::setPartitionSequentialStream())
     std::vector<ConvergencePoint> convergenceHistory;  ///< Statistics at intervals
+    std::vector<double> replicateMeans; ///< Mean of each randomized replicate; empty for plain Monte Carlo
+    size_t pairCount;                   ///< Antithetic pairs without NaN behind mean; 0 without antithetic variates
+    std::vector<double> controlCoefficients;  ///< Estimated coefficient of each control variate; empty without them
+    std::vector<double> logWeights;     ///< Log-likelihood ratio of each sample; empty without importance sampling
+    double effectiveSampleSize;         ///< sum(w)^2 / sum(w^2) of the weights; validSampleCount without importance sampling
+    
+    /**
+     * @brief Quantiles of the valid samples, weighted by exp(logWeights)
+     *        under importance sampling (see weightedQuantiles())
+     * @param probabilities Probabilities in [0, 1]
+     * @return One quantile per probability; NaN without valid samples
+     * @throws std::invalid_argument if a probability is outside [0, 1]
+     */
+    std::vector<double> quantiles(const std::vector<double>& probabilities) const;
+    
+    /**
+     * @brief A single quantile; see quantiles(), which sorts the samples
+     *        once for any number of probabilities
+     */
+    double quantile(double probability) const;
+};
+
+/**
+ * @brief An expression with a known expectation, evaluated alongside the
+ *        target to reduce its variance
+ *
+ * See MonteCarloEvaluator::addControlVariate().
+ */
+struct ControlVariate {
+    std::shared_ptr<Expression> expression;  ///< The control
+    double expectation;                      ///< Its exact expectation
+};
+
+/**
+ * @brief Block evaluator that replaces the instruction tape of a run
+ *
+ * Used for static expressions (see StaticExpression), whose evaluateBatch()
+ * is one loop fused at compile time. run receives one column per entry of
+ * variableNames holding that variable's samples; entries with an empty
+ * name get a null column.
+ */
+struct BlockKernel {
+    std::function<void(const double* const* columns, size_t count, double* out)> run;
+    std::vector<std::string> variableNames;
+};
+
+/**
+ * @brief Random number engines the evaluator can draw from
+ */
+enum class RandomEngine {
+    Mt19937,             ///< std::mt19937 (default)
+    Philox4x32,          ///< Counter-based Philox4x32-10 (see Philox4x32)
+    Xoshiro256PlusPlus,  ///< xoshiro256++ with jump-ahead streams (see Xoshiro256PlusPlus)
+    Xoroshiro128Plus     ///< xoroshiro128+ with jump-ahead streams (see Xoroshiro128Plus)
+};
+
+/**
+ * @brief How the evaluator turns the registry's distributions into samples
+ */
+enum class SamplingMethod {
+    MonteCarlo,       ///< Independent draws from the selected RandomEngine (default)
+    QuasiMonteCarlo,  ///< Inverse-CDF transforms of Owen-scrambled Sobol points
+    LatinHypercube    ///< Inverse-CDF transforms of Latin hypercube designs
+};
+
+/**
+ * @brief One Monte Carlo run split into chunks that may be evaluated in any
+ *        order, on any threads
+ *
+ * Obtained from MonteCarloEvaluator::prepareChunks(). Every chunk draws from
+ * its own stream and finish() merges the chunks in chunk order, so the result
+ * equals the parallel evaluate() the evaluator would otherwise have run,
+ * however the chunks are scheduled. Used by SimulationScheduler to share a
+ * worker pool between many runs.
+ *
+ * The registry passed to prepareChunks() must outlive this object.
+ */
+class ChunkedEvaluation {
+public:
+    ChunkedEvaluation(ChunkedEvaluation&&) noexcept;
+    ChunkedEvaluation& operator=(ChunkedEvaluation&&) noexcept;
+    ~ChunkedEvaluation();
+    
+    /**
+     * @brief Get the number of chunks
+     * @return Chunks of this run, 16,384 samples each except possibly the last
+     */
+    size_t getChunkCount() const;
+    
+    /**
+     * @brief Evaluate one chunk
+     *
+     * Distinct chunks may run concurrently; each must run exactly once
+     * before finish().
+     *
+     * @param chunk Chunk index, less than getChunkCount()
+     * @throws std::out_of_range if chunk is out of range
+     */
+    void runChunk(size_t chunk);
+    
+    /**
+     * @brief Merge the chunks' statistics into the run's result
+     *
+     * Call once, after every chunk has run.
+     *
+     * @return Simulation results with statistics
+     */
+    SimulationResult finish();
+    
+private:
+    friend class MonteCarloEvaluator;
+    struct State;
+    
+    explicit ChunkedEvaluation(std::unique_ptr<State> state);
+    
+    std::unique_ptr<State> state_;
 };
 
 /**
@@ -43,10 +170,56 @@ struct SimulationResult {
  * 
  * Evaluates an expression multiple times, sampling variables from their
  * distributions each time, and computes statistical properties of the results.
+ *
+ * All per-run buffers (sample storage, variable columns, registers, the
+ * convergence history) are allocated before sampling starts; the sampling
+ * loop itself performs no heap allocations. In parallel runs each worker
+ * allocates its scratch once when it starts; chunks, their random streams
+ * and their convergence records allocate nothing.
+ *
+ * Only the variables the expression references are sampled. They are drawn
+ * in registry slot (name) order, one sample at a time, so for a fixed seed
+ * the results do not depend on which other variables the registry holds.
+ *
+ * Optionally (setNativeCodegen()) the expression is compiled to native code
+ * and loaded at runtime; if that fails the interpreter is used instead.
+ *
+ * By default every sample is drawn on the calling thread from one
+ * std::mt19937 stream. setThreadCount() switches to parallel evaluation (see
+ * there), whose results depend on the seed but not on the thread count.
+ * Chunked runs (parallel, or any engine other than std::mt19937) fill each
+ * variable's column of a block with one Distribution block call.
+ *
+ * Statistics (mean, standard deviation, min, max and the convergence
+ * history) are reduced with a fixed-shape tree: each block of 512 samples is
+ * summarized in two passes and the blocks are merged pairwise (see
+ * PairwiseReducer). The tree depends only on the sample count, so the same
+ * samples always give bit-identical statistics, whether they were produced
+ * sequentially, by stream partitioning or in chunks on any number of threads.
+ *
+ * The registry is only read: distributions hold no sampling state, which
+ * lives with each stream instead (the evaluator's own, or one set per chunk).
+ * Worker threads therefore share the registry's distributions directly.
  */
 class MonteCarloEvaluator {
     size_t numSamples_;
     std::mt19937 rng_;
+    std::uint64_t seed_;      // Base seed of the parallel chunk streams
+    std::uint64_t runCount_;  // Parallel runs so far; each run uses new streams
+    size_t threadCount_;      // 0 = sequential single-stream mode
+    RandomEngine engine_;
+    bool partitionSequentialStream_;
+    bool compensatedSummation_;
+    SamplingMethod samplingMethod_;
+    size_t replicateCount_;   // Independent randomizations of a quasi-random run
+    bool antitheticVariates_;
+    std::vector<ControlVariate> controlVariates_;
+    bool importanceSampling_;
+    bool threadPinning_;
+    std::vector<unsigned> pinCpus_;  // Worker i runs on pinCpus_[i % size]; empty = unpinned
+    bool nativeCodegen_;
+    NativeKernelOptions nativeOptions_;
+    std::vector<SamplerState> samplerStates_;  // Per-slot sampler state on rng_'s stream
     
 public:
     /**
@@ -56,6 +229,285 @@ public:
      */
     MonteCarloEvaluator(size_t numSamples, std::optional<unsigned> seed = std::nullopt);
     
+    /**
+     * @brief Enable or disable the native code generation backend
+     *
+     * When enabled, each evaluated expression is compiled to a native kernel
+     * (see NativeKernel), reusing the on-disk cache when possible. Samples are
+     * identical to the interpreter's; only speed differs. If the kernel cannot
+     * be built or loaded the interpreter is used.
+     *
+     * @param enabled Whether to use native kernels (off by default)
+     * @param options Compiler and cache settings
+     */
+    void setNativeCodegen(bool enabled, const NativeKernelOptions& options = {});
+    
+    /**
+     * @brief Select the random number engine
+     *
+     * With Philox4x32 every chunk of samples draws from its own counter-based
+     * stream (seed, stream = run << 32 | chunk). Results are then identical in
+     * sequential and parallel mode and for every thread count.
+     *
+     * The xoshiro engines split one seeded generator instead: run r starts
+     * r long_jump()s in, and chunk c of that run c jump()s further, so all
+     * chunks are non-overlapping and, as with Philox4x32, results do not
+     * depend on the thread count. These engines also use their own fast
+     * uniform and normal transforms rather than the <random> distributions.
+     *
+     * @param engine Engine used by subsequent evaluate() calls
+     */
+    void setRandomEngine(RandomEngine engine);
+    
+    /**
+     * @brief Get the selected random number engine
+     * @return The engine
+     */
+    RandomEngine getRandomEngine() const { return engine_; }
+    
+    /**
+     * @brief Select how samples are generated
+     *
+     * QuasiMonteCarlo gives each variable the expression references, in
+     * slot order, one dimension of a Sobol sequence (see SobolSequence, at
+     * most 51 variables) and maps its points through the variable's
+     * Distribution::inverseCdf(). The samples are split into
+     * getReplicateCount() replicates of nearly equal size, each an
+     * independently Owen-scrambled copy of the sequence's first points;
+     * replicate sizes that are powers of two integrate best. Scrambles
+     * derive from the seed and the run number, and results do not depend on
+     * the thread count or the RandomEngine.
+     *
+     * For smooth integrands the error of each replicate mean shrinks nearly
+     * as 1/n instead of 1/sqrt(n).
+     *
+     * LatinHypercube makes each replicate of n samples an independent Latin
+     * hypercube design: every variable's marginal is split into n
+     * equiprobable strata, each stratum is sampled exactly once at a random
+     * position inside it, and the strata are paired at random across
+     * variables (see fillLatinHypercube()). Generation is O(n) per variable
+     * and needs no stored permutations. Marginal percentiles, and means of
+     * nearly additive expressions, are much more stable than with
+     * independent draws.
+     *
+     * Since the samples of a design are not independent,
+     * SimulationResult::standardError comes from the spread of
+     * SimulationResult::replicateMeans for both methods; for MonteCarlo it
+     * is stddev / sqrt(validSampleCount).
+     *
+     * @param method Method used by subsequent evaluate() calls
+     */
+    void setSamplingMethod(SamplingMethod method);
+    
+    /**
+     * @brief Get the selected sampling method
+     * @return The method
+     */
+    SamplingMethod getSamplingMethod() const { return samplingMethod_; }
+    
+    /**
+     * @brief Set the number of independent randomizations of a
+     *        quasi-random or Latin hypercube run
+     * @param replicates Replicates, at least 2 for an error estimate (16 by default)
+     * @throws std::invalid_argument if replicates is 0
+     */
+    void setReplicateCount(size_t replicates);
+    
+    /**
+     * @brief Get the number of replicates of quasi-random and Latin
+     *        hypercube runs
+     * @return The replicate count
+     */
+    size_t getReplicateCount() const { return replicateCount_; }
+    
+    /**
+     * @brief Generate samples in antithetic pairs
+     *
+     * Samples 2k and 2k + 1 form a pair: only sample 2k is drawn, and each
+     * variable of sample 2k + 1 is its Distribution::antithetic()
+     * counterpart (2 * mean - x for a normal, min + max - x for a uniform).
+     * Pairs cost one draw, and for expressions that are monotone in their
+     * variables the pair members are negatively correlated, so the mean of
+     * the pair means has a smaller error than as many independent samples.
+     *
+     * SimulationResult::mean and standardError are then those of the pair
+     * means, counted in pairCount. A pair with a NaN member (for example
+     * from division by zero) is left out of them, as is an unpaired last
+     * sample; validSampleCount, stddev, min, max and the convergence
+     * history still describe the individual samples. Runs remain
+     * independent of the thread count. Only SamplingMethod::MonteCarlo
+     * supports pairs.
+     *
+     * @param enabled Whether to pair samples (off by default)
+     */
+    void setAntitheticVariates(bool enabled);
+    
+    /**
+     * @brief Check whether samples are generated in antithetic pairs
+     * @return true if enabled
+     */
+    bool getAntitheticVariates() const { return antitheticVariates_; }
+    
+    /**
+     * @brief Add a control variate: an expression whose expectation is known
+     *
+     * Every control is evaluated on the same samples as the target, in the
+     * same pass; the variables the controls reference are drawn along with
+     * the target's. The coefficients b that minimize the variance of
+     * target - b . (control - expectation) are estimated from co-moments
+     * reduced block by block like the other statistics, and
+     * SimulationResult::mean and standardError become those of the
+     * controlled estimate (see estimateWithControls()), with b in
+     * controlCoefficients. The closer the controls track the target, the
+     * smaller the error: a control that differs from the target only by
+     * noise-free terms removes its variance entirely.
+     *
+     * Only rows where the target and every control are valid (non-NaN)
+     * enter the estimate; validSampleCount, stddev, min, max and the
+     * convergence history still describe the target's samples alone. With
+     * antithetic variates the estimate is formed from pair means. Only
+     * SamplingMethod::MonteCarlo supports control variates.
+     *
+     * @param control Expression of the control
+     * @param expectation Its exact expectation
+     * @throws std::invalid_argument if control is null or expectation is not finite
+     */
+    void addControlVariate(std::shared_ptr<Expression> control, double expectation);
+    
+    /**
+     * @brief Remove all control variates
+     */
+    void clearControlVariates();
+    
+    /**
+     * @brief Get the control variates
+     * @return Controls in the order they were added
+     */
+    const std::vector<ControlVariate>& getControlVariates() const { return controlVariates_; }
+    
+    /**
+     * @brief Draw from the registry's proposal distributions and weigh the
+     *        samples
+     *
+     * Every referenced variable with a proposal (VariableRegistry::setProposal())
+     * is drawn from it, and sample i gets the log-likelihood ratio
+     * SimulationResult::logWeights[i], the sum over those variables of
+     * log f(x) - log g(x) for the registered density f and the proposal g.
+     * A proposal that puts more mass where the expression is large, such
+     * as a normal shifted into a rare tail, estimates tail expectations
+     * with far fewer samples.
+     *
+     * SimulationResult::mean is then the self-normalized weighted mean,
+     * stddev the square root of the weighted variance, standardError its
+     * delta-method error and effectiveSampleSize (sum w)^2 / sum w^2, which
+     * drops far below the sample count when the proposal fits poorly;
+     * quantiles() are weighted too (see summarizeWeighted() and
+     * weightedQuantiles()). validSampleCount, min, max and the convergence
+     * history still describe the drawn samples. Samples with NaN, as from
+     * a division by zero, carry no weight. Runs remain independent of the
+     * thread count. Importance sampling requires SamplingMethod::MonteCarlo
+     * and cannot be combined with antithetic or control variates.
+     *
+     * @param enabled Whether to use the proposals (off by default)
+     */
+    void setImportanceSampling(bool enabled);
+    
+    /**
+     * @brief Check whether runs draw from the proposal distributions
+     * @return true if enabled
+     */
+    bool getImportanceSampling() const { return importanceSampling_; }
+    
+    /**
+     * @brief Evaluate in parallel on a number of threads
+     *
+     * The sample range is split into fixed-size chunks. Each chunk draws from
+     * its own std::mt19937 seeded from (evaluator seed, run number, chunk
+     * index) with fresh sampler state, and the chunks' block reductions
+     * are appended in chunk order. Samples, statistics and
+     * the convergence history are therefore bit-identical for a given seed
+     * whatever the thread count, including 1. They differ from the default
+     * sequential mode, which draws all samples from a single stream, unless
+     * setPartitionSequentialStream() is enabled.
+     *
+     * @param threadCount Worker threads; 0 uses std::thread::hardware_concurrency()
+     */
+    void setThreadCount(size_t threadCount);
+    
+    /**
+     * @brief Make parallel std::mt19937 runs reproduce the sequential stream
+     *
+     * When enabled, parallel runs with RandomEngine::Mt19937 split the
+     * default single stream itself instead of seeding one stream per chunk:
+     * each thread jumps a copy of the evaluator's engine (see Mt19937Jump) to
+     * the start of its contiguous range of samples. Samples, statistics and
+     * the convergence history then equal the sequential mode's bit for bit,
+     * and consecutive runs continue the stream exactly as sequential runs do.
+     *
+     * This needs every referenced distribution to consume a fixed number of
+     * engine outputs per sample (Distribution::getFixedDrawCount()).
+     * NormalDistribution does so only with NormalSampler::BoxMuller; its
+     * default and Ziggurat samplers do not. Runs that reference such a
+     * distribution, or that are too short to be worth splitting, are
+     * evaluated sequentially, which SimulationResult::partitionedStream
+     * reports.
+     *
+     * @param enabled Whether to partition the sequential stream (off by default)
+     */
+    void setPartitionSequentialStream(bool enabled);
+    
+    /**
+     * @brief Use compensated summation inside each statistics block
+     *
+     * Block sums and sums of squared deviations are then accumulated with
+     * Neumaier's algorithm, which removes the rounding error that grows with
+     * the block size. Results stay independent of the thread count either
+     * way; this changes their last bits, not their reproducibility.
+     *
+     * @param enabled Whether to compensate (off by default)
+     */
+    void setCompensatedSummation(bool enabled);
+    
+    /**
+     * @brief Pin parallel workers to CPUs, spread across NUMA nodes
+     *
+     * Worker i of a parallel run (the calling thread is worker 0) is pinned
+     * to the i-th CPU of CpuTopology::spreadOrder(), which alternates between
+     * nodes, and the calling thread's affinity is restored afterwards. Each
+     * worker also releases the pages of its chunks of the sample buffer
+     * before writing them (see releasePages()), so they are placed again on
+     * the node of the worker that evaluates them rather than on the node of
+     * the thread that allocated the buffer. Samples and statistics are
+     * unaffected.
+     *
+     * @param enabled Whether to pin workers (off by default)
+     */
+    void setThreadPinning(bool enabled);
+    
+    /**
+     * @brief Check whether parallel workers are pinned
+     * @return true if enabled
+     */
+    bool getThreadPinning() const { return threadPinning_; }
+    
+    /**
+     * @brief Check whether statistics use compensated summation
+     * @return true if enabled
+     */
+    bool getCompensatedSummation() const { return compensatedSummation_; }
+    
+    /**
+     * @brief Check whether parallel runs partition the sequential stream
+     * @return true if enabled
+     */
+    bool getPartitionSequentialStream() const { return partitionSequentialStream_; }
+    
+    /**
+     * @brief Get the configured thread count
+     * @return Worker threads, or 0 in the default sequential mode
+     */
+    size_t getThreadCount() const { return threadCount_; }
+    
     /**
      * @brief Evaluate an expression using Monte Carlo simulation
      * @param expr Expression to evaluate
@@ -65,11 +517,91 @@ public:
      *        - Positive N: Record every N samples
      *        - Negative: Use smart intervals (logarithmic/percentage-based)
      * @return Simulation results with statistics
+     * @throws std::out_of_range if expr or a control variate references a
+     *         variable missing from registry
+     * @throws std::invalid_argument if antithetic variates, control
+     *         variates or importance sampling are combined with another
+     *         SamplingMethod than MonteCarlo or with each other (antithetic
+     *         and control variates do combine)
      */
     SimulationResult evaluate(std::shared_ptr<Expression> expr,
                              const VariableRegistry& registry,
                              int convergenceInterval = 0);
     
+    /**
+     * @brief Evaluate a static expression with its fused block loop
+     *
+     * Every block of samples runs expr.evaluateBatch(), with the column of
+     * each staticVariable<Index> resolved once to its registry slot. The
+     * runtime form expr.toExpression() is still lowered to decide which
+     * variables are sampled, and the samples equal those of evaluating it.
+     * Native code generation does not apply.
+     *
+     * @param expr Static expression to evaluate
+     * @param registry Variable registry containing distributions
+     * @param convergenceInterval Interval for recording convergence statistics
+     *        (see the Expression overload)
+     * @return Simulation results with statistics
+     * @throws std::invalid_argument if a static variable index is bound to
+     *         two names, or as the Expression overload
+     * @throws std::out_of_range as the Expression overload
+     */
+    template <typename E>
+    SimulationResult evaluate(const StaticExpression<E>& expr,
+                             const VariableRegistry& registry,
+                             int convergenceInterval = 0) {
+        const E& fused = static_cast<const E&>(expr);
+        BlockKernel kernel{[&fused](const double* const* columns, size_t count, double* out) {
+                               fused.evaluateBatch(columns, count, out);
+                           },
+                           fused.getVariableNames()};
+        return evaluateFused(fused.toExpression(), kernel, registry, convergenceInterval);
+    }
+    
+    /**
+     * @brief Evaluate an expression stored in an ExpressionGraph
+     *
+     * The graph is lowered straight to an instruction tape without building
+     * an Expression tree, so graphs of millions of nodes are cheap to run;
+     * shared nodes are evaluated once but no simplification is applied.
+     *
+     * @param graph Graph holding the expression
+     * @param root Id of the expression's root node
+     * @param registry Variable registry containing distributions
+     * @param convergenceInterval Interval for recording convergence statistics
+     *        (see the Expression overload)
+     * @return Simulation results with statistics
+     * @throws std::out_of_range if the expression references a variable missing from registry
+     */
+    SimulationResult evaluate(const ExpressionGraph& graph,
+                             ExpressionGraph::NodeId root,
+                             const VariableRegistry& registry,
+                             int convergenceInterval = 0);
+    
+    /**
+     * @brief Prepare a run as independently schedulable chunks
+     *
+     * Does everything evaluate() does before sampling, then hands the
+     * sampling to the caller (see ChunkedEvaluation). The run uses the
+     * parallel chunk streams of the selected engine (or the design chunks
+     * of the selected SamplingMethod), so finish() yields what
+     * evaluate() would with setThreadCount() set and stream partitioning
+     * off, and it counts as a run: the next evaluate() draws new streams.
+     *
+     * @param expr Expression to evaluate
+     * @param registry Variable registry containing distributions; must
+     *        outlive the returned object
+     * @param convergenceInterval Interval for recording convergence statistics
+     *        (see evaluate())
+     * @return The prepared run
+     * @throws std::out_of_range if expr or a control variate references a
+     *         variable missing from registry
+     * @throws std::invalid_argument as for evaluate()
+     */
+    ChunkedEvaluation prepareChunks(std::shared_ptr<Expression> expr,
+                                    const VariableRegistry& registry,
+                                    int convergenceInterval = 0);
+    
 private:
     /**
      * @brief Compute smart convergence intervals based on total samples
@@ -77,6 +609,66 @@ private:
      * @return Vector of sample counts at which to record statistics
      */
     std::vector<size_t> computeSmartIntervals(size_t totalSamples) const;
+    
+    /**
+     * @brief Run an expression already lowered to a tape
+     * @param source Expression the tape was lowered from, kept alive for its
+     *        interpreted nodes; null for a graph
+     * @param program The unbound tape
+     * @param registry Variable registry containing distributions
+     * @param convergenceInterval As passed to evaluate()
+     * @param fused Kernel run instead of the tape, if any
+     */
+    SimulationResult evaluateProgram(std::shared_ptr<Expression> source,
+                                     CompiledExpression program,
+                                     const VariableRegistry& registry,
+                                     int convergenceInterval,
+                                     const BlockKernel* fused = nullptr);
+    
+    /**
+     * @brief Run an expression whose blocks are evaluated by a caller's kernel
+     * @param expr Runtime form of the expression; decides the sampled variables
+     * @param kernel Computes the same values as expr
+     */
+    SimulationResult evaluateFused(std::shared_ptr<Expression> expr,
+                                   const BlockKernel& kernel,
+                                   const VariableRegistry& registry,
+                                   int convergenceInterval);
+    
+    /**
+     * @brief Sample counts at which a run records convergence statistics
+     * @param convergenceInterval Interval as passed to evaluate()
+     * @return Increasing sample counts; empty when tracking is off
+     */
+    std::vector<size_t> computeRecordPoints(int convergenceInterval) const;
+    
+    /**
+     * @brief Whether runs use antithetic pairs
+     * @throws std::invalid_argument if pairs are enabled with a design-based SamplingMethod
+     */
+    bool checkAntithetic() const;
+    
+    /**
+     * @brief The control variates of a run
+     * @throws std::invalid_argument if controls are set with a design-based SamplingMethod
+     */
+    const std::vector<ControlVariate>& checkControlVariates() const;
+    
+    /**
+     * @brief Whether runs use importance sampling
+     * @throws std::invalid_argument if it is enabled with a design-based
+     *         SamplingMethod, antithetic variates or control variates
+     */
+    bool checkImportanceSampling() const;
+    
+    /**
+     * @brief Sampler state of the sequential stream, one per registry slot
+     *
+     * Part of the stream like rng_ itself: kept across runs, so consecutive
+     * sequential runs continue exactly where the previous one stopped, and
+     * independent of which registry object holds the distributions.
+     */
+    std::vector<SamplerState>& samplerStatesFor(const VariableRegistry& registry);
 };
 
 } // namespace tt_int
@@ -0,0 +1,69 @@
+#ifndef MT19937_JUMP_H
+#define MT19937_JUMP_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace tt_int {
+
+/**
+ * @brief Jump-ahead for std::mt19937
+ *
+ * Advancing a Mersenne Twister by n outputs is multiplication of its state by
+ * T^n, where T is the (linear, over GF(2)) transition. Since the
+ * characteristic polynomial φ of T has degree 19937, T^n equals g(T) with
+ * g = x^n mod φ, and g(T) can be applied with 19937 generator steps and XORs
+ * (Haramoto et al., "Efficient Jump Ahead for F2-Linear Random Number
+ * Generators", 2008). The cost is therefore independent of n, a few
+ * milliseconds, where std::mt19937::discard() is linear in n. Short jumps
+ * fall back to discard().
+ *
+ * A jump computes g once; apply() may then be called on any number of
+ * engines. The result is exactly the state discard(n) would reach, so jumped
+ * engines continue the original sequence bit for bit.
+ */
+class Mt19937Jump {
+public:
+    /**
+     * @brief Prepare a jump by an arbitrary number of outputs
+     * @param steps Number of 32-bit outputs to skip
+     */
+    explicit Mt19937Jump(unsigned long long steps);
+
+    /**
+     * @brief Prepare a jump by 2^exponent outputs
+     * @param exponent Base-2 logarithm of the jump; may exceed 63
+     */
+    static Mt19937Jump powerOfTwo(unsigned exponent);
+
+    /**
+     * @brief Advance an engine by this jump
+     * @param rng Engine to advance
+     */
+    void apply(std::mt19937& rng) const;
+
+private:
+    Mt19937Jump() = default;
+
+    std::vector<std::uint64_t> polynomial_;  // x^(n - 624) mod φ; empty for short jumps
+    unsigned long long directSteps_ = 0;     // Short jumps are applied with discard()
+};
+
+/**
+ * @brief Advance an engine as if steps outputs had been discarded
+ * @param rng Engine to advance
+ * @param steps Number of 32-bit outputs to skip
+ */
+void jumpAhead(std::mt19937& rng, unsigned long long steps);
+
+/**
+ * @brief Advance an engine by 2^exponent outputs
+ * @param rng Engine to advance
+ * @param exponent Base-2 logarithm of the jump; may exceed 63
+ */
+void jumpAheadPow2(std::mt19937& rng, unsigned exponent);
+
+} // namespace tt_int
+
+#endif // MT19937_JUMP_H
@@ -0,0 +1,144 @@
+#ifndef NATIVE_KERNEL_H
+#define NATIVE_KERNEL_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "expression.h"
+
+namespace tt_int {
+
+class CompiledExpression;
+
+/**
+ * @brief Settings for building native kernels
+ */
+struct NativeKernelOptions {
+    /// Directory holding generated sources and shared objects. Empty selects
+    /// $TT_INT_KERNEL_CACHE, then $XDG_CACHE_HOME/tt_int/kernels, then
+    /// $HOME/.cache/tt_int/kernels, then tt_int-kernels-<uid> under the system
+    /// temp dir if it is a directory owned by the user and closed to others
+    /// (mode 0700), else a fresh mkdtemp directory for the process.
+    std::string cacheDirectory;
+
+    /// C++ compiler to invoke. Empty selects $CXX, then the compiler tt_int
+    /// itself was built with.
+    std::string compiler;
+};
+
+/**
+ * @brief An expression compiled to machine code and loaded with dlopen
+ *
+ * The expression is lowered to its instruction tape (see CompiledExpression)
+ * and emitted as a C++ function that evaluates a block of samples in one
+ * fused loop. The function is compiled into a shared object with the system
+ * compiler and loaded at runtime.
+ *
+ * Shared objects are cached on disk, one directory per kernel named by the
+ * expression's structural hash and a digest of the generated source. Each
+ * build runs in a directory unique to the call and is published by renaming
+ * it into place, so the cached source and object always form a pair and a
+ * published entry never changes. The source is compared before a cached
+ * object is reused; on a mismatch the kernel is rebuilt and loaded from its
+ * own unique path, so a collision costs a recompile, never a wrong kernel.
+ * Diagnostics of a failed build are written to a .log file in the cache
+ * directory.
+ *
+ * Kernels are compiled without floating-point contraction or fast-math, so
+ * they return exactly what the interpreter returns, including NaN for
+ * division by zero.
+ */
+class NativeKernel {
+public:
+    /**
+     * @brief Signature of the generated function
+     *
+     * variables[v] is the column of count values of the v-th variable of
+     * CompiledExpression(expr).getVariableNames().
+     */
+    using Function = void (*)(const double* const* variables, size_t count, double* out);
+
+    /**
+     * @brief Build (or reuse from the cache) and load the kernel for an expression
+     * @param expr Expression to compile
+     * @param options Compiler and cache settings
+     * @return The loaded kernel, or nullptr if it could not be built or loaded
+     *         (for example when no compiler is available)
+     * @throws std::invalid_argument if the expression contains a node the tape interprets
+     */
+    static std::shared_ptr<NativeKernel> load(const Expression& expr,
+                                              const NativeKernelOptions& options = {});
+
+    /**
+     * @brief Generate the C++ source of the kernel for an expression
+     * @param expr Expression to translate
+     * @return Source of a translation unit defining the kernel function
+     * @throws std::invalid_argument if the expression contains a node the tape interprets
+     */
+    static std::string generateSource(const Expression& expr);
+
+    /**
+     * @brief Build (or reuse from the cache) and load the kernel for a tape
+     *
+     * Used for expressions that were never Expression trees, such as
+     * ExpressionGraph roots. The cache entry is named by a structural hash
+     * of the tape instead of the expression's.
+     *
+     * @param program Tape to compile; variables[v] of the kernel is the
+     *        v-th name of program.getVariableNames()
+     * @param options Compiler and cache settings
+     * @return The loaded kernel, or nullptr if it could not be built or loaded
+     * @throws std::invalid_argument if the tape has interpreted nodes
+     */
+    static std::shared_ptr<NativeKernel> load(const CompiledExpression& program,
+                                              const NativeKernelOptions& options = {});
+
+    /**
+     * @brief Generate the C++ source of the kernel for a tape
+     * @param program Tape to translate
+     * @return Source of a translation unit defining the kernel function
+     * @throws std::invalid_argument if the tape has interpreted nodes
+     */
+    static std::string generateSource(const CompiledExpression& program);
+
+    ~NativeKernel();
+    NativeKernel(const NativeKernel&) = delete;
+    NativeKernel& operator=(const NativeKernel&) = delete;
+
+    /**
+     * @brief Evaluate the expression over a block of samples
+     * @param variables One column of count values per variable (see Function)
+     * @param count Number of samples
+     * @param out Destination for count results
+     */
+    void run(const double* const* variables, size_t count, double* out) const {
+        function_(variables, count, out);
+    }
+
+    /**
+     * @brief Get the path of the loaded shared object
+     * @return Absolute or cache-relative path
+     */
+    const std::string& getLibraryPath() const { return libraryPath_; }
+
+    /**
+     * @brief Whether the shared object was reused from the disk cache
+     * @return true if no compilation was needed
+     */
+    bool isFromCache() const { return fromCache_; }
+
+private:
+    NativeKernel(void* handle, Function function, std::string libraryPath, bool fromCache);
+
+    static std::shared_ptr<NativeKernel> loadSource(const std::string& source, size_t hash,
+                                                    const NativeKernelOptions& options);
+
+    void* handle_;
+    Function function_;
+    std::string libraryPath_;
+    bool fromCache_;
+};
+
+} // namespace tt_int
+
+#endif // NATIVE_KERNEL_H
@@ -0,0 +1,101 @@
+#ifndef PAIRWISE_STATISTICS_H
+#define PAIRWISE_STATISTICS_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace tt_int {
+
+/**
+ * @brief Count, mean, sum of squared deviations, min and max of the valid
+ *        (non-NaN) values of a range
+ */
+struct SummaryStatistics {
+    size_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;  // Sum of squared differences from mean
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    /**
+     * @brief Append the statistics of the range that follows this one
+     *
+     * Chan et al.'s pairwise combination. The operation is not associative
+     * in floating point, so the order of merges is part of the result.
+     *
+     * @param other Statistics of the following range
+     */
+    void merge(const SummaryStatistics& other);
+
+    /**
+     * @brief Sample standard deviation, or 0 for fewer than two values
+     */
+    double stddev() const;
+};
+
+/**
+ * @brief Statistics of one block of values, computed in two passes
+ * @param values The block
+ * @param count Number of values; NaNs are skipped
+ * @param compensated Accumulate the sum and the squared deviations with
+ *        Neumaier's compensated summation
+ * @return The block's statistics
+ */
+SummaryStatistics summarizeBlock(const double* values, size_t count, bool compensated = false);
+
+/**
+ * @brief Reduces a sequence of block statistics with a fixed-shape pairwise tree
+ *
+ * Blocks are combined like the digits of a binary counter: whenever the two
+ * most recent nodes cover the same number of blocks they are merged, so
+ * block i always ends up in the same aligned, power-of-two subtree. The
+ * total folds the remaining nodes from oldest to newest. The shape depends
+ * only on the number of blocks, never on how the work was split, and the
+ * rounding error grows with the logarithm of the block count rather than
+ * linearly as in a running accumulator.
+ *
+ * A reducer for a contiguous run of blocks can be appended to the reducer of
+ * the blocks before it. When the earlier run covers a multiple of 2^k blocks
+ * and the later one at most 2^k, this gives exactly what adding the blocks
+ * one by one would, which is how chunks reduced on different threads are
+ * combined bit for bit.
+ */
+class PairwiseReducer {
+public:
+    PairwiseReducer();
+
+    /**
+     * @brief Add the statistics of the next block
+     */
+    void add(const SummaryStatistics& block);
+
+    /**
+     * @brief Add the nodes of a reducer over the blocks that follow, in order
+     */
+    void append(const PairwiseReducer& later);
+
+    /**
+     * @brief Statistics of all blocks added so far
+     */
+    SummaryStatistics total() const;
+
+    /**
+     * @brief Number of blocks added so far
+     */
+    size_t getBlockCount() const;
+
+private:
+    struct Node {
+        SummaryStatistics stats;
+        size_t blocks;
+    };
+
+    void push(const Node& node);
+
+    std::vector<Node> nodes_;  // Oldest first
+};
+
+} // namespace tt_int
+
+#endif // PAIRWISE_STATISTICS_H
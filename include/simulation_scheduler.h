@@ -0,0 +1,119 @@
+#ifndef SIMULATION_SCHEDULER_H
+#define SIMULATION_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "expression.h"
+#include "monte_carlo_evaluator.h"
+#include "variable_registry.h"
+
+namespace tt_int {
+
+/**
+ * @brief One simulation to run on a SimulationScheduler
+ *
+ * The same parameters a fresh MonteCarloEvaluator would be given.
+ */
+struct SimulationJob {
+    std::shared_ptr<Expression> expression;          ///< Expression to evaluate
+    std::shared_ptr<const VariableRegistry> registry; ///< Distributions; shared, only read
+    size_t numSamples = 0;                           ///< Number of samples to generate
+    unsigned seed = 0;                               ///< Seed of the job's chunk streams
+    int convergenceInterval = 0;                     ///< As for MonteCarloEvaluator::evaluate()
+    RandomEngine engine = RandomEngine::Mt19937;     ///< Engine of the chunk streams
+    bool compensatedSummation = false;               ///< See MonteCarloEvaluator::setCompensatedSummation()
+    SamplingMethod samplingMethod = SamplingMethod::MonteCarlo;  ///< See MonteCarloEvaluator::setSamplingMethod()
+    size_t replicateCount = 16;                      ///< Replicates of a quasi-random or Latin hypercube job
+    bool antitheticVariates = false;                 ///< See MonteCarloEvaluator::setAntitheticVariates()
+    std::vector<ControlVariate> controlVariates;     ///< See MonteCarloEvaluator::addControlVariate()
+    bool importanceSampling = false;                 ///< See MonteCarloEvaluator::setImportanceSampling()
+};
+
+/**
+ * @brief Runs many simulations concurrently on a fixed pool of worker threads
+ *
+ * Every job is split into the chunks of MonteCarloEvaluator::prepareChunks(),
+ * and chunks of all jobs are balanced across the workers by work stealing.
+ * Each worker owns a deque of tasks: a submitted job first becomes one
+ * preparation task (simplify, compile, bind) on some worker's deque, and the
+ * worker that runs it pushes the job's chunks onto its own deque. Workers
+ * take their oldest task first, so jobs finish roughly in submission order;
+ * a worker whose deque is empty steals the newest task of another worker.
+ * Large jobs thus spread over all idle cores while small jobs run on one,
+ * and no thread is created per job.
+ *
+ * A job's result is bit-identical to that of
+ * `MonteCarloEvaluator(numSamples, seed)` with the job's engine and
+ * setThreadCount() of any value: it does not depend on the pool size or on
+ * which worker ran which chunk.
+ */
+class SimulationScheduler {
+public:
+    /**
+     * @brief Start the worker pool
+     * @param threadCount Worker threads; 0 uses std::thread::hardware_concurrency()
+     */
+    explicit SimulationScheduler(size_t threadCount = 0);
+
+    /**
+     * @brief Finish every submitted job, then stop the workers
+     */
+    ~SimulationScheduler();
+
+    SimulationScheduler(const SimulationScheduler&) = delete;
+    SimulationScheduler& operator=(const SimulationScheduler&) = delete;
+
+    /**
+     * @brief Queue a simulation
+     * @param job The simulation; expression and registry must be set
+     * @return The job's result. Errors of the run, such as std::out_of_range
+     *         for a variable missing from the registry, are rethrown by get().
+     * @throws std::invalid_argument if job has no expression or registry
+     */
+    std::future<SimulationResult> submit(SimulationJob job);
+
+    /**
+     * @brief Get the number of worker threads
+     * @return Size of the pool
+     */
+    size_t getThreadCount() const { return workers_.size(); }
+
+private:
+    struct Job;
+
+    // A job's preparation (chunk == PREPARE) or one of its chunks
+    struct Task {
+        std::shared_ptr<Job> job;
+        size_t chunk;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t worker);
+    bool takeTask(size_t worker, Task& task);
+    void push(size_t worker, std::vector<Task> tasks);
+    void runTask(size_t worker, const Task& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> nextQueue_{0};   // Round-robin target of submit()
+
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+    size_t queuedTasks_ = 0;             // Tasks in all deques; guarded by sleepMutex_
+    bool stopping_ = false;              // Guarded by sleepMutex_
+};
+
+} // namespace tt_int
+
+#endif // SIMULATION_SCHEDULER_H
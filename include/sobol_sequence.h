@@ -0,0 +1,84 @@
+#ifndef SOBOL_SEQUENCE_H
+#define SOBOL_SEQUENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tt_int {
+
+/**
+ * @brief Sobol low-discrepancy sequence with 32-bit resolution
+ *
+ * Dimension 0 is the van der Corput sequence; dimensions 1 to 50 use the
+ * primitive polynomials and initial direction numbers of Joe and Kuo
+ * ("Constructing Sobol sequences with better two-dimensional projections",
+ * 2008, new-joe-kuo-6.21201).
+ *
+ * Points are produced in Gray-code order, so consecutive points differ by
+ * one direction number and a run of points costs one XOR each. The first
+ * 2^m points are the same set as in natural order: every dimension puts
+ * exactly one of them into each interval [j / 2^m, (j + 1) / 2^m).
+ *
+ * Values are 32-bit binary fractions; point(n, d) / 2^32 lies in [0, 1).
+ * Indices must be below 2^32.
+ */
+class SobolSequence {
+public:
+    /// Dimensions with direction numbers
+    static constexpr size_t MAX_DIMENSIONS = 51;
+
+    /**
+     * @brief Prepare the direction numbers of the first dimensions
+     * @param dimensions Number of dimensions, at most MAX_DIMENSIONS
+     * @throws std::invalid_argument if dimensions exceeds MAX_DIMENSIONS
+     */
+    explicit SobolSequence(size_t dimensions);
+
+    /**
+     * @brief Get the number of dimensions
+     */
+    size_t getDimensions() const { return dimensions_; }
+
+    /**
+     * @brief One coordinate of one point
+     * @param index Position in the sequence, below 2^32
+     * @param dimension Coordinate, below getDimensions()
+     * @return The coordinate as a 32-bit binary fraction
+     */
+    std::uint32_t point(std::uint64_t index, size_t dimension) const;
+
+    /**
+     * @brief One coordinate of consecutive points
+     * @param start Index of the first point; start + count must not exceed 2^32
+     * @param count Number of points
+     * @param dimension Coordinate, below getDimensions()
+     * @param out Destination for count coordinates
+     */
+    void fill(std::uint64_t start, size_t count, size_t dimension, std::uint32_t* out) const;
+
+private:
+    static constexpr int BITS = 32;
+
+    size_t dimensions_;
+    std::vector<std::uint32_t> directions_;  // BITS direction numbers per dimension
+};
+
+/**
+ * @brief Owen-scramble a 32-bit binary fraction
+ *
+ * Hash-based nested uniform scrambling (Burley, "Practical Hash-based Owen
+ * Scrambling", 2020): each bit is flipped depending on the seed and on all
+ * more significant bits only. Applied to every point of a (t, m, s)-net with
+ * one seed per dimension, it keeps the net property while making each point
+ * uniformly distributed, so averages over scrambled points are unbiased.
+ *
+ * @param value Binary fraction to scramble
+ * @param seed Scramble of this dimension
+ * @return The scrambled fraction
+ */
+std::uint32_t owenScramble(std::uint32_t value, std::uint32_t seed);
+
+} // namespace tt_int
+
+#endif // SOBOL_SEQUENCE_H
@@ -0,0 +1,244 @@
+#ifndef STATIC_EXPRESSION_H
+#define STATIC_EXPRESSION_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "expression.h"
+
+namespace tt_int {
+
+/**
+ * @brief Compile-time flavour of ExpressionBuilder (expression templates)
+ *
+ * Each operator returns a small value whose type encodes the whole
+ * expression, e.g. StaticBinaryOp<Add, StaticVariable<0>, StaticConstant>.
+ * evaluate() and evaluateBatch() are therefore fully known to the compiler
+ * and inline into one fused loop body: no virtual calls, no heap nodes, no
+ * instruction tape. This is intended for formulas fixed in C++ source.
+ *
+ * Variables are bound to a position in the value array at compile time with
+ * staticVariable<Index>(name). The name is kept so that toExpression() (or the
+ * implicit conversion to std::shared_ptr<Expression>) can produce an ordinary
+ * runtime expression for MonteCarloEvaluator and the other tools.
+ *
+ * @code
+ * auto x = staticVariable<0>("x");
+ * auto y = staticVariable<1>("y");
+ * auto f = (x + y) * 0.5;
+ * double values[] = {1.0, 3.0};
+ * f.evaluate(values);                    // 2.0, fully inlined
+ * evaluator.evaluate(f, registry);       // runs f.evaluateBatch() per block
+ * @endcode
+ */
+template <typename Derived>
+class StaticExpression {
+public:
+    /**
+     * @brief Convert to an equivalent runtime expression tree
+     * @return Root of the expression tree
+     */
+    std::shared_ptr<Expression> toExpression() const {
+        return static_cast<const Derived&>(*this).buildExpression();
+    }
+
+    /**
+     * @brief Implicit conversion for APIs taking a runtime expression
+     */
+    operator std::shared_ptr<Expression>() const { return toExpression(); }
+
+    /**
+     * @brief Evaluate the expression over a block of samples stored column-wise
+     * @param columns One column of count values per variable index
+     * @param count Number of samples
+     * @param out Destination for count results
+     */
+    void evaluateBatch(const double* const* columns, size_t count, double* out) const {
+        const auto& self = static_cast<const Derived&>(*this);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = self.evaluateAt(columns, i);
+        }
+    }
+
+    /**
+     * @brief Get the variable name bound to each index
+     * @return names[Index] is the name of staticVariable<Index>; indices the
+     *         expression does not use hold an empty name
+     * @throws std::invalid_argument if one index is bound to two names
+     */
+    std::vector<std::string> getVariableNames() const {
+        std::vector<std::string> names;
+        static_cast<const Derived&>(*this).collectNames(names);
+        return names;
+    }
+};
+
+/**
+ * @brief Constant leaf of a static expression
+ */
+class StaticConstant : public StaticExpression<StaticConstant> {
+public:
+    explicit StaticConstant(double value) : value_(value) {}
+
+    double evaluate(const double* /*values*/) const { return value_; }
+    double evaluateAt(const double* const* /*columns*/, size_t /*i*/) const { return value_; }
+    std::shared_ptr<Expression> buildExpression() const { return std::make_shared<Constant>(value_); }
+    void collectNames(std::vector<std::string>& /*names*/) const {}
+
+    double getValue() const { return value_; }
+
+private:
+    double value_;
+};
+
+/**
+ * @brief Variable leaf of a static expression, read from values[Index]
+ */
+template <size_t Index>
+class StaticVariable : public StaticExpression<StaticVariable<Index>> {
+public:
+    explicit StaticVariable(std::string name) : name_(std::move(name)) {}
+
+    double evaluate(const double* values) const { return values[Index]; }
+    double evaluateAt(const double* const* columns, size_t i) const { return columns[Index][i]; }
+    std::shared_ptr<Expression> buildExpression() const { return std::make_shared<Variable>(name_); }
+
+    void collectNames(std::vector<std::string>& names) const {
+        if (names.size() <= Index) {
+            names.resize(Index + 1);
+        }
+        if (!names[Index].empty() && names[Index] != name_) {
+            throw std::invalid_argument("Static variable index " + std::to_string(Index) +
+                                        " is bound to both '" + names[Index] + "' and '" + name_ + "'");
+        }
+        names[Index] = name_;
+    }
+
+    const std::string& getName() const { return name_; }
+
+private:
+    std::string name_;
+};
+
+/**
+ * @brief Binary operation node of a static expression
+ */
+template <BinaryOperator Op, typename Left, typename Right>
+class StaticBinaryOp : public StaticExpression<StaticBinaryOp<Op, Left, Right>> {
+public:
+    StaticBinaryOp(const Left& left, const Right& right) : left_(left), right_(right) {}
+
+    double evaluate(const double* values) const {
+        return apply(left_.evaluate(values), right_.evaluate(values));
+    }
+
+    double evaluateAt(const double* const* columns, size_t i) const {
+        return apply(left_.evaluateAt(columns, i), right_.evaluateAt(columns, i));
+    }
+
+    std::shared_ptr<Expression> buildExpression() const {
+        return std::make_shared<BinaryOp>(left_.buildExpression(), right_.buildExpression(), Op);
+    }
+
+    void collectNames(std::vector<std::string>& names) const {
+        left_.collectNames(names);
+        right_.collectNames(names);
+    }
+
+private:
+    // Same semantics as BinaryOp::evaluate, resolved at compile time
+    static double apply(double lhs, double rhs) {
+        if constexpr (Op == BinaryOperator::Add) {
+            return lhs + rhs;
+        } else if constexpr (Op == BinaryOperator::Subtract) {
+            return lhs - rhs;
+        } else if constexpr (Op == BinaryOperator::Multiply) {
+            return lhs * rhs;
+        } else {
+            return rhs == 0.0 ? std::numeric_limits<double>::quiet_NaN() : lhs / rhs;
+        }
+    }
+
+    Left left_;
+    Right right_;
+};
+
+/**
+ * @brief Create a static variable read from position Index of the value array
+ * @param name Variable name used when converting to a runtime expression
+ * @return The variable leaf
+ */
+template <size_t Index>
+StaticVariable<Index> staticVariable(const std::string& name) {
+    return StaticVariable<Index>(name);
+}
+
+/**
+ * @brief Create a static constant
+ * @param value The constant value
+ * @return The constant leaf
+ */
+inline StaticConstant staticConstant(double value) {
+    return StaticConstant(value);
+}
+
+/**
+ * @brief True for the static expression node types
+ */
+template <typename T>
+constexpr bool IS_STATIC_EXPRESSION = std::is_base_of_v<StaticExpression<T>, T>;
+
+namespace detail {
+
+template <typename T>
+auto asStaticOperand(const T& operand) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return StaticConstant(static_cast<double>(operand));
+    } else {
+        return operand;
+    }
+}
+
+// Enabled when at least one operand is a static expression and the other is
+// a static expression or a number, so ExpressionBuilder's operators are unaffected
+template <typename L, typename R>
+using EnableStaticOperator = std::enable_if_t<
+    (IS_STATIC_EXPRESSION<L> && (IS_STATIC_EXPRESSION<R> || std::is_arithmetic_v<R>)) ||
+    (std::is_arithmetic_v<L> && IS_STATIC_EXPRESSION<R>)>;
+
+template <BinaryOperator Op, typename L, typename R>
+auto makeStaticBinary(const L& lhs, const R& rhs) {
+    auto left = asStaticOperand(lhs);
+    auto right = asStaticOperand(rhs);
+    return StaticBinaryOp<Op, decltype(left), decltype(right)>(left, right);
+}
+
+} // namespace detail
+
+template <typename L, typename R, typename = detail::EnableStaticOperator<L, R>>
+auto operator+(const L& lhs, const R& rhs) {
+    return detail::makeStaticBinary<BinaryOperator::Add>(lhs, rhs);
+}
+
+template <typename L, typename R, typename = detail::EnableStaticOperator<L, R>>
+auto operator-(const L& lhs, const R& rhs) {
+    return detail::makeStaticBinary<BinaryOperator::Subtract>(lhs, rhs);
+}
+
+template <typename L, typename R, typename = detail::EnableStaticOperator<L, R>>
+auto operator*(const L& lhs, const R& rhs) {
+    return detail::makeStaticBinary<BinaryOperator::Multiply>(lhs, rhs);
+}
+
+template <typename L, typename R, typename = detail::EnableStaticOperator<L, R>>
+auto operator/(const L& lhs, const R& rhs) {
+    return detail::makeStaticBinary<BinaryOperator::Divide>(lhs, rhs);
+}
+
+} // namespace tt_int
+
+#endif // STATIC_EXPRESSION_H
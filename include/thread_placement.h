@@ -0,0 +1,111 @@
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tt_int {
+
+/**
+ * @brief Parse a Linux CPU list such as "0-3,8,10-11"
+ * @param list Comma-separated CPU numbers and inclusive ranges
+ * @return The CPUs in the order listed
+ * @throws std::invalid_argument if the list is malformed
+ */
+std::vector<unsigned> parseCpuList(const std::string& list);
+
+/**
+ * @brief The NUMA nodes of this machine and the CPUs this process may use on each
+ *
+ * Read from /sys/devices/system/node on Linux and restricted to the
+ * process's CPU affinity mask, so that containers and taskset are respected.
+ * Where the topology is unavailable, everything is one node holding CPUs
+ * 0 to hardware_concurrency() - 1.
+ */
+class CpuTopology {
+public:
+    /**
+     * @brief Detect the topology of the running machine
+     */
+    static CpuTopology detect();
+
+    /**
+     * @brief Build a topology from explicit per-node CPU lists
+     * @param nodes CPUs of each node; empty nodes are dropped
+     */
+    explicit CpuTopology(std::vector<std::vector<unsigned>> nodes);
+
+    /**
+     * @brief Get the number of nodes with usable CPUs
+     */
+    size_t getNodeCount() const { return nodes_.size(); }
+
+    /**
+     * @brief Get the usable CPUs of a node
+     * @param node Node index, less than getNodeCount()
+     */
+    const std::vector<unsigned>& getCpus(size_t node) const { return nodes_[node]; }
+
+    /**
+     * @brief CPUs in the order workers should be pinned to them
+     *
+     * Alternates between nodes (first CPU of every node, then the second of
+     * every node, ...), so that n workers spread their memory traffic over
+     * all nodes rather than filling one socket first.
+     *
+     * @return Every usable CPU exactly once
+     */
+    std::vector<unsigned> spreadOrder() const;
+
+private:
+    std::vector<std::vector<unsigned>> nodes_;
+};
+
+/**
+ * @brief Pins the calling thread to one CPU for the lifetime of the object
+ *
+ * The thread's previous affinity is restored on destruction, so the calling
+ * thread of an evaluation can work as a pinned worker without staying pinned
+ * afterwards. Pinning is best effort: on platforms without thread affinity,
+ * or if the CPU is not allowed, the thread simply runs unpinned.
+ */
+class ScopedThreadPin {
+public:
+    /**
+     * @brief Pin the calling thread
+     * @param cpu CPU to run on
+     */
+    explicit ScopedThreadPin(unsigned cpu);
+    ~ScopedThreadPin();
+
+    ScopedThreadPin(const ScopedThreadPin&) = delete;
+    ScopedThreadPin& operator=(const ScopedThreadPin&) = delete;
+
+    /**
+     * @brief Check whether the thread was actually pinned
+     */
+    bool isPinned() const { return pinned_; }
+
+private:
+    bool pinned_ = false;
+    std::vector<unsigned char> previousMask_;  // Saved affinity, platform specific
+};
+
+/**
+ * @brief Return the whole pages of a buffer to the operating system
+ *
+ * The pages read as zero afterwards and are mapped again on first touch, on
+ * the NUMA node of the thread that touches them. A worker calling this on its
+ * slice of a buffer that another thread allocated and zero-filled thereby
+ * moves the slice next to itself. Partial pages at either end are left alone,
+ * since they may hold a neighbouring slice. A no-op outside Linux.
+ *
+ * @param data Start of the slice, in heap memory (private anonymous pages)
+ * @param count Number of doubles in the slice; those on released pages become 0.0
+ */
+void releasePages(double* data, size_t count);
+
+} // namespace tt_int
+
+#endif // THREAD_PLACEMENT_H
@@ -5,6 +5,7 @@
 #include <memory>
 #include <random>
 #include <string>
+#include <vector>
 #include "distribution.h"
 
 namespace tt_int {
@@ -14,6 +15,14 @@ namespace tt_int {
  * 
  * The VariableRegistry stores mappings from variable names to their distributions
  * and provides functionality to sample all variables at once.
+ *
+ * Each variable also has an integer slot: its position in name order. Slots
+ * let hot loops exchange samples through flat arrays instead of maps. Slots
+ * are stable until a new variable name is registered.
+ *
+ * A variable may additionally have a proposal distribution, which
+ * importance sampling draws from instead (see
+ * MonteCarloEvaluator::setImportanceSampling()).
  */
 class VariableRegistry {
 public:
@@ -22,17 +31,220 @@ public:
      * @param name The name of the variable
      * @param dist The probability distribution for this variable
      * 
-     * If a variable with this name already exists, it will be replaced.
+     * If a variable with this name already exists, it will be replaced,
+     * and its proposal removed.
      */
     void registerVariable(const std::string& name,
                          std::shared_ptr<Distribution> dist);
     
+    /**
+     * @brief Give a registered variable a proposal distribution
+     *
+     * Importance sampling draws the variable from the proposal and weighs
+     * each sample by the likelihood ratio of the registered distribution.
+     * The proposal must be positive wherever the registered distribution
+     * is, for example a NormalDistribution with a shifted mean that puts
+     * more samples into a rare tail.
+     *
+     * @param name The name of the variable
+     * @param proposal Distribution to draw from; null removes the proposal
+     * @throws std::out_of_range if the variable is not registered
+     */
+    void setProposal(const std::string& name, std::shared_ptr<Distribution> proposal);
+    
+    /**
+     * @brief Get the proposal of the variable in a slot
+     * @param slot Slot index, less than getVariableCount()
+     * @return The proposal, or nullptr if the variable has none
+     */
+    const Distribution* getProposal(size_t slot) const { return proposalSlots_[slot].get(); }
+    
+    /**
+     * @brief A registry whose variables have their proposals as distributions
+     * @return Copy of this registry with every variable that has a proposal
+     *         registered with the proposal instead; it has no proposals
+     *         itself, and the same slots
+     */
+    VariableRegistry withProposals() const;
+    
     /**
      * @brief Sample all registered variables once
+     * @param rng Random number generator to use for sampling (any engine
+     *        Distribution::sample accepts)
+     * @return Map of variable names to their sampled values
+     *
+     * Continues each distribution's own sampling state (see
+     * Distribution::sample(std::mt19937&)), so it must not run concurrently
+     * with other sampling of the same distributions; pass the states of
+     * makeSamplerStates() to share the registry across threads.
+     */
+    template <typename Engine>
+    std::map<std::string, double> sampleAll(Engine& rng) const {
+        std::map<std::string, double> samples;
+        for (const auto& pair : variables_) {
+            samples[pair.first] = pair.second->sample(rng);
+        }
+        return samples;
+    }
+    
+    /**
+     * @brief Sample all registered variables once, continuing their sampling state
      * @param rng Random number generator to use for sampling
+     * @param states Per-slot sampling state on rng's stream, from makeSamplerStates()
      * @return Map of variable names to their sampled values
      */
-    std::map<std::string, double> sampleAll(std::mt19937& rng) const;
+    template <typename Engine>
+    std::map<std::string, double> sampleAll(Engine& rng, std::vector<SamplerState>& states) const {
+        std::map<std::string, double> samples;
+        size_t slot = 0;
+        for (const auto& pair : variables_) {
+            samples[pair.first] = pair.second->sample(rng, states[slot++]);
+        }
+        return samples;
+    }
+    
+    /**
+     * @brief Sample all registered variables once into a flat array
+     * @param rng Random number generator to use for sampling
+     * @param values Destination; the sample for slot s is written to values[s * stride]
+     * @param stride Distance between consecutive slots in values
+     * 
+     * Variables are drawn in slot order, which consumes the random stream
+     * exactly like the map-returning overload, continuing the same
+     * per-distribution state. Allocates nothing.
+     */
+    template <typename Engine>
+    void sampleAll(Engine& rng, double* values, size_t stride = 1) const {
+        for (size_t slot = 0; slot < slots_.size(); ++slot) {
+            values[slot * stride] = slots_[slot]->sample(rng);
+        }
+    }
+    
+    /**
+     * @brief Sample all registered variables once into a flat array, continuing their sampling state
+     * @param rng Random number generator to use for sampling
+     * @param states Per-slot sampling state on rng's stream, from makeSamplerStates()
+     * @param values Destination; the sample for slot s is written to values[s * stride]
+     * @param stride Distance between consecutive slots in values
+     *
+     * Allocates nothing; consumes the stream like the map-returning
+     * overload with the same states.
+     */
+    template <typename Engine>
+    void sampleAll(Engine& rng, std::vector<SamplerState>& states,
+                   double* values, size_t stride = 1) const {
+        for (size_t slot = 0; slot < slots_.size(); ++slot) {
+            values[slot * stride] = slots_[slot]->sample(rng, states[slot]);
+        }
+    }
+    
+    /**
+     * @brief Sample a subset of the registered variables once into a flat array
+     * @param rng Random number generator to use for sampling
+     * @param slots Slots to sample, in the order they are drawn
+     * @param values Destination; the sample for slots[k] is written to values[k * stride]
+     * @param stride Distance between consecutive entries in values
+     * 
+     * Unlisted variables are not sampled and consume nothing from the random
+     * stream, so the draws depend only on the listed slots and the seed.
+     * Continues each distribution's own sampling state and allocates nothing.
+     */
+    template <typename Engine>
+    void sampleSlots(Engine& rng, const std::vector<size_t>& slots,
+                     double* values, size_t stride = 1) const {
+        for (size_t k = 0; k < slots.size(); ++k) {
+            values[k * stride] = slots_[slots[k]]->sample(rng);
+        }
+    }
+    
+    /**
+     * @brief Sample a subset of the registered variables, continuing their sampling state
+     * @param rng Random number generator to use for sampling
+     * @param states Per-slot sampling state on rng's stream, from makeSamplerStates()
+     * @param slots Slots to sample, in the order they are drawn
+     * @param values Destination; the sample for slots[k] is written to values[k * stride]
+     * @param stride Distance between consecutive entries in values
+     */
+    template <typename Engine>
+    void sampleSlots(Engine& rng, std::vector<SamplerState>& states,
+                     const std::vector<size_t>& slots, double* values, size_t stride = 1) const {
+        for (size_t k = 0; k < slots.size(); ++k) {
+            values[k * stride] = slots_[slots[k]]->sample(rng, states[slots[k]]);
+        }
+    }
+    
+    /**
+     * @brief Sample a subset of the registered variables count times, column by column
+     * @param rng Random number generator to use for sampling
+     * @param slots Slots to sample, in the order their columns are filled
+     * @param columns Destination; sample i of slots[k] is written to columns[k * stride + i]
+     * @param stride Distance between consecutive columns, at least count
+     * @param count Number of samples per variable
+     * 
+     * Makes one Distribution block call per variable. All samples of slots[0]
+     * are drawn before those of slots[1], so with several variables the
+     * random stream is consumed in a different order than by count calls of
+     * sampleSlots(). Continues each distribution's own sampling state and
+     * allocates nothing.
+     */
+    template <typename Engine>
+    void sampleColumns(Engine& rng, const std::vector<size_t>& slots,
+                       double* columns, size_t stride, size_t count) const {
+        for (size_t k = 0; k < slots.size(); ++k) {
+            slots_[slots[k]]->sample(rng, columns + k * stride, count);
+        }
+    }
+    
+    /**
+     * @brief Column-by-column sampling that continues the slots' sampling state
+     * @param rng Random number generator to use for sampling
+     * @param states Per-slot sampling state on rng's stream, from makeSamplerStates()
+     * @param slots Slots to sample, in the order their columns are filled
+     * @param columns Destination; sample i of slots[k] is written to columns[k * stride + i]
+     * @param stride Distance between consecutive columns, at least count
+     * @param count Number of samples per variable
+     */
+    template <typename Engine>
+    void sampleColumns(Engine& rng, std::vector<SamplerState>& states,
+                       const std::vector<size_t>& slots, double* columns,
+                       size_t stride, size_t count) const {
+        for (size_t k = 0; k < slots.size(); ++k) {
+            slots_[slots[k]]->sample(rng, states[slots[k]], columns + k * stride, count);
+        }
+    }
+    
+    /**
+     * @brief Fresh sampling state for every slot, for one random stream
+     * @return One SamplerState per slot, indexed by slot
+     *
+     * The registry itself is never modified by sampling, so threads can
+     * share it as long as each uses its own engine and states.
+     */
+    std::vector<SamplerState> makeSamplerStates() const {
+        return std::vector<SamplerState>(slots_.size());
+    }
+    
+    /**
+     * @brief Resolve a variable name to its slot
+     * @param name The name of the variable
+     * @return The variable's slot index
+     * @throws std::out_of_range if the variable is not registered
+     */
+    size_t getSlot(const std::string& name) const;
+    
+    /**
+     * @brief Get the name of the variable in a slot
+     * @param slot Slot index, less than getVariableCount()
+     * @return The variable's name
+     */
+    const std::string& getVariableName(size_t slot) const { return names_[slot]; }
+    
+    /**
+     * @brief Get the distribution of the variable in a slot
+     * @param slot Slot index, less than getVariableCount()
+     * @return The variable's distribution
+     */
+    const Distribution& getDistribution(size_t slot) const { return *slots_[slot]; }
     
     /**
      * @brief Check if a variable is registered
@@ -49,6 +261,12 @@ public:
     
 private:
     std::map<std::string, std::shared_ptr<Distribution>> variables_;
+    std::vector<std::shared_ptr<Distribution>> slots_;  // variables_ in name order
+    std::vector<std::string> names_;                    // Parallel to slots_
+    std::map<std::string, std::shared_ptr<Distribution>> proposals_;
+    std::vector<std::shared_ptr<Distribution>> proposalSlots_;  // Per slot; null without a proposal
+    
+    void rebuildSlots();
 };
 
 } // namespace tt_int
@@ -0,0 +1,64 @@
+#ifndef WEIGHTED_STATISTICS_H
+#define WEIGHTED_STATISTICS_H
+
+#include <cstddef>
+#include <vector>
+
+namespace tt_int {
+
+/**
+ * @brief Self-normalized statistics of values with importance weights
+ */
+struct WeightedSummary {
+    size_t count = 0;                  ///< Rows with a non-NaN value and log weight
+    double mean;                       ///< sum(w * y) / sum(w)
+    double variance;                   ///< Weighted variance, corrected for reliability weights
+    double standardError;              ///< Delta-method error of mean
+    double effectiveSampleSize;        ///< sum(w)^2 / sum(w^2)
+};
+
+/**
+ * @brief Weighted mean, variance and effective sample size of values whose
+ *        weights are given as logarithms
+ *
+ * Weights are exp(logWeights[i] - max), so any range of log weights is
+ * representable; the common factor cancels in every statistic. Rows whose
+ * value or log weight is NaN are skipped, and a log weight of -infinity is
+ * a weight of zero. Sums run over blocks of 512 rows combined along a fixed
+ * binary tree, so the result depends only on the data.
+ *
+ * The variance is sum(w * (y - mean)^2) / (sum(w) - sum(w^2) / sum(w)), which
+ * is the sample variance for equal weights. The squared standard error is
+ * the delta-method sum(w^2 * (y - mean)^2) / sum(w)^2, scaled by
+ * ess / (ess - 1) for the effective sample size ess so that equal weights
+ * give stddev / sqrt(n).
+ *
+ * @param values count values
+ * @param logWeights count natural logarithms of the weights
+ * @param count Number of rows
+ * @return The statistics; NaN (and an effective sample size of 0) when no
+ *         row has a positive weight
+ */
+WeightedSummary summarizeWeighted(const double* values, const double* logWeights, size_t count);
+
+/**
+ * @brief Quantiles of the weighted empirical distribution
+ *
+ * The p-quantile is the smallest value whose cumulative normalized weight,
+ * in ascending order of values, reaches p; p = 0 gives the smallest value
+ * with a positive weight. Rows are skipped as in summarizeWeighted().
+ *
+ * @param values count values
+ * @param logWeights count natural logarithms of the weights, or nullptr
+ *        for equal weights
+ * @param count Number of rows
+ * @param probabilities Probabilities in [0, 1]
+ * @return One quantile per probability; NaN when no row has a positive weight
+ * @throws std::invalid_argument if a probability is outside [0, 1]
+ */
+std::vector<double> weightedQuantiles(const double* values, const double* logWeights, size_t count,
+                                      const std::vector<double>& probabilities);
+
+} // namespace tt_int
+
+#endif // WEIGHTED_STATISTICS_H
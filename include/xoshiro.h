@@ -0,0 +1,241 @@
+#ifndef XOSHIRO_H
+#define XOSHIRO_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace tt_int {
+
+/**
+ * @brief Convert 64 random bits to a double uniformly distributed in [0, 1)
+ *
+ * Uses the top 53 bits, so every representable multiple of 2^-53 is equally
+ * likely; one shift and one multiply, no division.
+ */
+inline double toUnitDouble(std::uint64_t bits) {
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+}
+
+namespace detail {
+
+inline std::uint64_t rotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64, the recommended way to expand a 64-bit seed into xoshiro state
+inline std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace detail
+
+/**
+ * @brief xoshiro256++ 1.0 (Blackman and Vigna)
+ *
+ * 256-bit state, period 2^256 - 1. jump() advances by 2^128 draws and
+ * long_jump() by 2^192, so one seed can be split into 2^64 non-overlapping
+ * streams of 2^128 draws each, or 2^64 groups of such streams.
+ */
+class Xoshiro256PlusPlus {
+public:
+    using result_type = std::uint64_t;
+    using State = std::array<std::uint64_t, 4>;
+
+    /**
+     * @brief Seed by expanding a 64-bit value with splitmix64
+     * @param seed Seed value
+     */
+    explicit Xoshiro256PlusPlus(std::uint64_t seed = 0) { this->seed(seed); }
+
+    /**
+     * @brief Construct from a raw state, which must not be all zero
+     * @param state Engine state
+     */
+    explicit Xoshiro256PlusPlus(const State& state) : state_(state) {}
+
+    void seed(std::uint64_t seed) {
+        for (auto& word : state_) {
+            word = detail::splitmix64(seed);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const std::uint64_t result = detail::rotl(state_[0] + state_[3], 23) + state_[0];
+        const std::uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = detail::rotl(state_[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief Draw a double uniformly distributed in [0, 1)
+     */
+    double nextDouble() { return toUnitDouble((*this)()); }
+
+    void discard(unsigned long long count) {
+        for (; count > 0; --count) {
+            (*this)();
+        }
+    }
+
+    /**
+     * @brief Advance by 2^128 draws
+     */
+    void jump() {
+        static constexpr State JUMP = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                       0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        apply(JUMP);
+    }
+
+    /**
+     * @brief Advance by 2^192 draws
+     */
+    void long_jump() {
+        static constexpr State LONG_JUMP = {0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+                                            0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+        apply(LONG_JUMP);
+    }
+
+    const State& getState() const { return state_; }
+
+    friend bool operator==(const Xoshiro256PlusPlus& lhs, const Xoshiro256PlusPlus& rhs) {
+        return lhs.state_ == rhs.state_;
+    }
+
+    friend bool operator!=(const Xoshiro256PlusPlus& lhs, const Xoshiro256PlusPlus& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    // Multiply the state by a polynomial in the transition matrix
+    void apply(const State& polynomial) {
+        State result = {0, 0, 0, 0};
+        for (std::uint64_t word : polynomial) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (word & (std::uint64_t{1} << bit)) {
+                    for (size_t i = 0; i < result.size(); ++i) {
+                        result[i] ^= state_[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        state_ = result;
+    }
+
+    State state_;
+};
+
+/**
+ * @brief xoroshiro128+ 1.0 (Blackman and Vigna)
+ *
+ * 128-bit state, period 2^128 - 1; the fastest generator here, intended for
+ * floating-point output (its lowest bits are weak, which toUnitDouble()
+ * discards). jump() advances by 2^64 draws and long_jump() by 2^96.
+ */
+class Xoroshiro128Plus {
+public:
+    using result_type = std::uint64_t;
+    using State = std::array<std::uint64_t, 2>;
+
+    /**
+     * @brief Seed by expanding a 64-bit value with splitmix64
+     * @param seed Seed value
+     */
+    explicit Xoroshiro128Plus(std::uint64_t seed = 0) { this->seed(seed); }
+
+    /**
+     * @brief Construct from a raw state, which must not be all zero
+     * @param state Engine state
+     */
+    explicit Xoroshiro128Plus(const State& state) : state_(state) {}
+
+    void seed(std::uint64_t seed) {
+        for (auto& word : state_) {
+            word = detail::splitmix64(seed);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const std::uint64_t s0 = state_[0];
+        std::uint64_t s1 = state_[1];
+        const std::uint64_t result = s0 + s1;
+        s1 ^= s0;
+        state_[0] = detail::rotl(s0, 24) ^ s1 ^ (s1 << 16);
+        state_[1] = detail::rotl(s1, 37);
+        return result;
+    }
+
+    /**
+     * @brief Draw a double uniformly distributed in [0, 1)
+     */
+    double nextDouble() { return toUnitDouble((*this)()); }
+
+    void discard(unsigned long long count) {
+        for (; count > 0; --count) {
+            (*this)();
+        }
+    }
+
+    /**
+     * @brief Advance by 2^64 draws
+     */
+    void jump() {
+        static constexpr State JUMP = {0xdf900294d8f554a5ULL, 0x170865df4b3201fcULL};
+        apply(JUMP);
+    }
+
+    /**
+     * @brief Advance by 2^96 draws
+     */
+    void long_jump() {
+        static constexpr State LONG_JUMP = {0xd2a98b26625eee7bULL, 0xdddf9b1090aa7ac1ULL};
+        apply(LONG_JUMP);
+    }
+
+    const State& getState() const { return state_; }
+
+    friend bool operator==(const Xoroshiro128Plus& lhs, const Xoroshiro128Plus& rhs) {
+        return lhs.state_ == rhs.state_;
+    }
+
+    friend bool operator!=(const Xoroshiro128Plus& lhs, const Xoroshiro128Plus& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    // Multiply the state by a polynomial in the transition matrix
+    void apply(const State& polynomial) {
+        State result = {0, 0};
+        for (std::uint64_t word : polynomial) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (word & (std::uint64_t{1} << bit)) {
+                    result[0] ^= state_[0];
+                    result[1] ^= state_[1];
+                }
+                (*this)();
+            }
+        }
+        state_ = result;
+    }
+
+    State state_;
+};
+
+} // namespace tt_int
+
+#endif // XOSHIRO_H
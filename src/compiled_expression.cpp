@@ -0,0 +1,452 @@
+#include "compiled_expression.h"
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include "variable_registry.h"
+
+namespace tt_int {
+
+namespace {
+
+struct Frame {
+    const Expression* node;
+    bool expanded;
+};
+
+OpCode toOpCode(BinaryOperator op) {
+    switch (op) {
+        case BinaryOperator::Add:      return OpCode::Add;
+        case BinaryOperator::Subtract: return OpCode::Subtract;
+        case BinaryOperator::Multiply: return OpCode::Multiply;
+        case BinaryOperator::Divide:   return OpCode::Divide;
+    }
+    throw std::logic_error("Unknown binary operator");
+}
+
+OpCode toOpCode(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::Add:      return OpCode::Add;
+        case NodeKind::Subtract: return OpCode::Subtract;
+        case NodeKind::Multiply: return OpCode::Multiply;
+        case NodeKind::Divide:   return OpCode::Divide;
+        default:                 break;
+    }
+    throw std::logic_error("Node is not a binary operation");
+}
+
+} // namespace
+
+CompiledExpression::CompiledExpression(const Expression& expr)
+    : referencedCount_(0), registerCount_(0), resultSlot_(0) {
+    // Count how many operand references each distinct node has. A node shared
+    // by several parents (a DAG, e.g. after common-subexpression elimination)
+    // is emitted once and its register stays live until its last use.
+    std::unordered_map<const Expression*, size_t> remainingUses;
+    {
+        std::vector<const Expression*> pending = {&expr};
+        remainingUses[&expr] = 1;  // The result itself is never released
+        while (!pending.empty()) {
+            const auto* binary = dynamic_cast<const BinaryOp*>(pending.back());
+            pending.pop_back();
+            if (binary == nullptr) {
+                continue;
+            }
+            for (const Expression* child : {binary->getLeft().get(), binary->getRight().get()}) {
+                if (remainingUses[child]++ == 0) {
+                    pending.push_back(child);
+                }
+            }
+        }
+    }
+
+    std::map<std::string, std::uint32_t> variableIndex;
+    std::unordered_map<const Expression*, std::uint32_t> emittedSlot;
+    std::vector<std::uint32_t> freeSlots;  // Registers whose value has been fully consumed
+
+    auto allocateSlot = [&]() {
+        if (!freeSlots.empty()) {
+            std::uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        return static_cast<std::uint32_t>(registerCount_++);
+    };
+    auto consume = [&](const Expression* node) {
+        std::uint32_t slot = emittedSlot.at(node);
+        if (--remainingUses.at(node) == 0) {
+            freeSlots.push_back(slot);
+        }
+        return slot;
+    };
+
+    // Iterative post-order walk so that deep (e.g. left-leaning) trees built
+    // by chaining operators cannot overflow the call stack
+    std::vector<Frame> stack = {{&expr, false}};
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        stack.pop_back();
+        if (emittedSlot.count(frame.node) != 0) {
+            continue;  // Shared node already computed
+        }
+
+        if (const auto* binary = dynamic_cast<const BinaryOp*>(frame.node)) {
+            if (!frame.expanded) {
+                stack.push_back({frame.node, true});
+                stack.push_back({binary->getRight().get(), false});
+                stack.push_back({binary->getLeft().get(), false});
+                continue;
+            }
+            // Operand registers whose last use is this node are recycled
+            // for the result
+            std::uint32_t lhs = consume(binary->getLeft().get());
+            std::uint32_t rhs = consume(binary->getRight().get());
+            std::uint32_t dest = allocateSlot();
+            code_.push_back({toOpCode(binary->getOperator()), dest, lhs, rhs});
+            emittedSlot[frame.node] = dest;
+        } else if (const auto* constant = dynamic_cast<const Constant*>(frame.node)) {
+            std::uint32_t dest = allocateSlot();
+            auto index = static_cast<std::uint32_t>(constants_.size());
+            constants_.push_back(constant->getValue());
+            code_.push_back({OpCode::LoadConstant, dest, index, 0});
+            emittedSlot[frame.node] = dest;
+        } else if (const auto* variable = dynamic_cast<const Variable*>(frame.node)) {
+            auto inserted = variableIndex.emplace(
+                variable->getName(), static_cast<std::uint32_t>(variableNames_.size()));
+            if (inserted.second) {
+                variableNames_.push_back(variable->getName());
+            }
+            std::uint32_t dest = allocateSlot();
+            code_.push_back({OpCode::LoadVariable, dest, inserted.first->second, 0});
+            emittedSlot[frame.node] = dest;
+        } else if (frame.node != nullptr) {
+            // Another Expression subclass: evaluated through its own evaluate()
+            std::uint32_t dest = allocateSlot();
+            auto index = static_cast<std::uint32_t>(interpreted_.size());
+            interpreted_.push_back(frame.node);
+            code_.push_back({OpCode::Interpret, dest, index, 0});
+            emittedSlot[frame.node] = dest;
+        } else {
+            throw std::invalid_argument("Cannot compile null expression node");
+        }
+    }
+
+    finish(emittedSlot.at(&expr));
+}
+
+CompiledExpression::CompiledExpression(const ExpressionGraph& graph, ExpressionGraph::NodeId root)
+    : referencedCount_(0), registerCount_(0), resultSlot_(0) {
+    if (root >= graph.size()) {
+        throw std::invalid_argument("Root is not a node of this expression graph");
+    }
+
+    // Operands always precede their users, so one backward sweep from the
+    // root counts the uses of every reachable node; unreachable nodes keep 0
+    std::vector<std::uint32_t> remainingUses(static_cast<size_t>(root) + 1, 0);
+    remainingUses[root] = 1;  // The result itself is never released
+    for (size_t id = root + 1; id-- > 0;) {
+        const ExpressionGraph::Node& node = graph.getNode(static_cast<ExpressionGraph::NodeId>(id));
+        if (remainingUses[id] == 0 || node.kind == NodeKind::Constant ||
+            node.kind == NodeKind::Variable) {
+            continue;
+        }
+        ++remainingUses[node.lhs];
+        ++remainingUses[node.rhs];
+    }
+
+    const std::uint32_t unassigned = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> variableIndex;  // Graph variable index to tape variable index
+    std::vector<std::uint32_t> emittedSlot(remainingUses.size(), unassigned);
+    std::vector<std::uint32_t> freeSlots;
+
+    auto allocateSlot = [&]() {
+        if (!freeSlots.empty()) {
+            std::uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        return static_cast<std::uint32_t>(registerCount_++);
+    };
+    auto consume = [&](std::uint32_t id) {
+        std::uint32_t slot = emittedSlot[id];
+        if (--remainingUses[id] == 0) {
+            freeSlots.push_back(slot);
+        }
+        return slot;
+    };
+
+    // Node ids are a topological order, so a forward pass emits every
+    // operand before its users
+    for (size_t id = 0; id < remainingUses.size(); ++id) {
+        if (remainingUses[id] == 0) {
+            continue;
+        }
+        const ExpressionGraph::Node& node = graph.getNode(static_cast<ExpressionGraph::NodeId>(id));
+        switch (node.kind) {
+            case NodeKind::Constant: {
+                std::uint32_t dest = allocateSlot();
+                auto index = static_cast<std::uint32_t>(constants_.size());
+                constants_.push_back(node.value);
+                code_.push_back({OpCode::LoadConstant, dest, index, 0});
+                emittedSlot[id] = dest;
+                break;
+            }
+
+            case NodeKind::Variable: {
+                if (node.lhs >= variableIndex.size()) {
+                    variableIndex.resize(static_cast<size_t>(node.lhs) + 1, unassigned);
+                }
+                if (variableIndex[node.lhs] == unassigned) {
+                    variableIndex[node.lhs] = static_cast<std::uint32_t>(variableNames_.size());
+                    variableNames_.push_back(graph.getVariableName(node.lhs));
+                }
+                std::uint32_t dest = allocateSlot();
+                code_.push_back({OpCode::LoadVariable, dest, variableIndex[node.lhs], 0});
+                emittedSlot[id] = dest;
+                break;
+            }
+
+            default: {
+                std::uint32_t lhs = consume(node.lhs);
+                std::uint32_t rhs = consume(node.rhs);
+                std::uint32_t dest = allocateSlot();
+                code_.push_back({toOpCode(node.kind), dest, lhs, rhs});
+                emittedSlot[id] = dest;
+                break;
+            }
+        }
+    }
+
+    finish(emittedSlot[root]);
+}
+
+void CompiledExpression::finish(std::uint32_t resultSlot) {
+    resultSlot_ = resultSlot;
+    referencedCount_ = variableNames_.size();
+    resolveBatchSources();
+
+    // Unbound: each variable is read from its own table index
+    for (size_t v = 0; v < variableNames_.size(); ++v) {
+        variableSlots_.push_back(v);
+    }
+}
+
+void CompiledExpression::bind(const VariableRegistry& registry) {
+    variableNames_.resize(referencedCount_);
+    if (!interpreted_.empty()) {
+        // An interpreted node may read any variable, so the tape reads them all
+        std::set<std::string> referenced(variableNames_.begin(), variableNames_.end());
+        for (size_t slot = 0; slot < registry.getVariableCount(); ++slot) {
+            if (referenced.count(registry.getVariableName(slot)) == 0) {
+                variableNames_.push_back(registry.getVariableName(slot));
+            }
+        }
+    }
+
+    std::vector<size_t> slots;
+    slots.reserve(variableNames_.size());
+    for (const auto& name : variableNames_) {
+        slots.push_back(registry.getSlot(name));
+    }
+    variableSlots_ = std::move(slots);
+}
+
+void CompiledExpression::resolveBatchSources() {
+    // In batch mode a variable load does not copy its column into the
+    // register file; operands that would read that register read the column
+    // directly instead. Track what each slot holds while replaying the tape.
+    std::vector<BatchSource> slotSource(registerCount_);
+    batchOperands_.clear();
+    batchOperands_.reserve(code_.size());
+
+    for (const Instruction& ins : code_) {
+        BatchOperands operands = {};
+        switch (ins.op) {
+            case OpCode::LoadVariable:
+                slotSource[ins.dest] = {true, ins.lhs};
+                break;
+
+            case OpCode::LoadConstant:
+            case OpCode::Interpret:
+                slotSource[ins.dest] = {false, ins.dest};
+                break;
+
+            default:
+                operands = {slotSource[ins.lhs], slotSource[ins.rhs]};
+                slotSource[ins.dest] = {false, ins.dest};
+                break;
+        }
+        batchOperands_.push_back(operands);
+    }
+
+    batchResult_ = slotSource[resultSlot_];
+}
+
+double CompiledExpression::evaluate(const double* values, double* registers) const {
+    return run(values, registers, nullptr);
+}
+
+std::map<std::string, double> CompiledExpression::makeVariableMap(const double* values) const {
+    std::map<std::string, double> variables;
+    for (size_t v = 0; v < variableNames_.size(); ++v) {
+        variables[variableNames_[v]] = values[variableSlots_[v]];
+    }
+    return variables;
+}
+
+double CompiledExpression::run(const double* values, double* registers,
+                               const std::map<std::string, double>* variables) const {
+    std::map<std::string, double> sampleVariables;
+    if (variables == nullptr && !interpreted_.empty()) {
+        sampleVariables = makeVariableMap(values);
+        variables = &sampleVariables;
+    }
+
+    for (const Instruction& ins : code_) {
+        switch (ins.op) {
+            case OpCode::LoadConstant:
+                registers[ins.dest] = constants_[ins.lhs];
+                break;
+
+            case OpCode::LoadVariable:
+                registers[ins.dest] = values[variableSlots_[ins.lhs]];
+                break;
+
+            case OpCode::Add:
+                registers[ins.dest] = registers[ins.lhs] + registers[ins.rhs];
+                break;
+
+            case OpCode::Subtract:
+                registers[ins.dest] = registers[ins.lhs] - registers[ins.rhs];
+                break;
+
+            case OpCode::Multiply:
+                registers[ins.dest] = registers[ins.lhs] * registers[ins.rhs];
+                break;
+
+            case OpCode::Divide: {
+                // Same divide-by-zero semantics as BinaryOp::evaluate
+                double divisor = registers[ins.rhs];
+                registers[ins.dest] = divisor == 0.0
+                    ? std::numeric_limits<double>::quiet_NaN()
+                    : registers[ins.lhs] / divisor;
+                break;
+            }
+
+            case OpCode::Interpret:
+                registers[ins.dest] = interpreted_[ins.lhs]->evaluate(*variables);
+                break;
+        }
+    }
+    return registers[resultSlot_];
+}
+
+void CompiledExpression::evaluateBatch(const double* const* columns, size_t count,
+                                       double* out, double* registers) const {
+    auto resolve = [&](BatchSource source) -> const double* {
+        return source.isColumn ? columns[variableSlots_[source.index]]
+                               : registers + static_cast<size_t>(source.index) * count;
+    };
+
+    // Interpreted nodes share one map, updated in place for every sample
+    std::map<std::string, double> variables;
+    std::vector<double*> variableValues;
+    if (!interpreted_.empty()) {
+        for (const auto& name : variableNames_) {
+            variableValues.push_back(&variables[name]);
+        }
+    }
+
+    for (size_t k = 0; k < code_.size(); ++k) {
+        const Instruction& ins = code_[k];
+        double* dest = registers + static_cast<size_t>(ins.dest) * count;
+
+        switch (ins.op) {
+            case OpCode::LoadConstant: {
+                double value = constants_[ins.lhs];
+                for (size_t i = 0; i < count; ++i) {
+                    dest[i] = value;
+                }
+                break;
+            }
+
+            case OpCode::LoadVariable:
+                // Operands read the column in place (see resolveBatchSources)
+                break;
+
+            case OpCode::Add: {
+                const double* lhs = resolve(batchOperands_[k].lhs);
+                const double* rhs = resolve(batchOperands_[k].rhs);
+                for (size_t i = 0; i < count; ++i) {
+                    dest[i] = lhs[i] + rhs[i];
+                }
+                break;
+            }
+
+            case OpCode::Subtract: {
+                const double* lhs = resolve(batchOperands_[k].lhs);
+                const double* rhs = resolve(batchOperands_[k].rhs);
+                for (size_t i = 0; i < count; ++i) {
+                    dest[i] = lhs[i] - rhs[i];
+                }
+                break;
+            }
+
+            case OpCode::Multiply: {
+                const double* lhs = resolve(batchOperands_[k].lhs);
+                const double* rhs = resolve(batchOperands_[k].rhs);
+                for (size_t i = 0; i < count; ++i) {
+                    dest[i] = lhs[i] * rhs[i];
+                }
+                break;
+            }
+
+            case OpCode::Divide: {
+                const double* lhs = resolve(batchOperands_[k].lhs);
+                const double* rhs = resolve(batchOperands_[k].rhs);
+                const double nan = std::numeric_limits<double>::quiet_NaN();
+                for (size_t i = 0; i < count; ++i) {
+                    dest[i] = rhs[i] == 0.0 ? nan : lhs[i] / rhs[i];
+                }
+                break;
+            }
+
+            case OpCode::Interpret: {
+                const Expression& node = *interpreted_[ins.lhs];
+                for (size_t i = 0; i < count; ++i) {
+                    for (size_t v = 0; v < variableValues.size(); ++v) {
+                        *variableValues[v] = columns[variableSlots_[v]][i];
+                    }
+                    dest[i] = node.evaluate(variables);
+                }
+                break;
+            }
+        }
+    }
+
+    const double* result = resolve(batchResult_);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = result[i];
+    }
+}
+
+double CompiledExpression::evaluate(const std::map<std::string, double>& variables) const {
+    size_t slotCount = 0;
+    for (size_t slot : variableSlots_) {
+        slotCount = std::max(slotCount, slot + 1);
+    }
+    std::vector<double> values(slotCount);
+    // Interpreted nodes read the caller's map itself
+    for (size_t v = 0; v < referencedCount_; ++v) {
+        auto it = variables.find(variableNames_[v]);
+        if (it == variables.end()) {
+            throw std::out_of_range("Variable '" + variableNames_[v] + "' not found in variable map");
+        }
+        values[variableSlots_[v]] = it->second;
+    }
+    std::vector<double> registers(registerCount_);
+    return run(values.data(), registers.data(), &variables);
+}
+
+} // namespace tt_int
@@ -0,0 +1,246 @@
+#include "control_variates.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tt_int {
+
+namespace {
+
+// A control whose variance left after the controls before it is below this
+// fraction of its own variance is treated as linearly dependent
+constexpr double DEPENDENT_CONTROL = 1e-12;
+
+bool isValidRow(const double* columns, size_t stride, size_t dimensions, size_t row) {
+    for (size_t k = 0; k < dimensions; ++k) {
+        if (std::isnan(columns[k * stride + row])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Append the co-moments of following rows, given as raw arrays
+ *
+ * Shared by ComomentStatistics::merge() and ComomentReducer, so both
+ * combine in exactly the same arithmetic.
+ */
+void mergeComoments(size_t dimensions, size_t& count, double* mean, double* comoment,
+                    size_t otherCount, const double* otherMean, const double* otherComoment) {
+    if (otherCount == 0) {
+        return;
+    }
+    if (count == 0) {
+        count = otherCount;
+        std::copy(otherMean, otherMean + dimensions, mean);
+        std::copy(otherComoment, otherComoment + dimensions * dimensions, comoment);
+        return;
+    }
+    const double n = static_cast<double>(count + otherCount);
+    const double weight = static_cast<double>(count) * static_cast<double>(otherCount) / n;
+    for (size_t i = 0; i < dimensions; ++i) {
+        const double deltaI = otherMean[i] - mean[i];
+        for (size_t j = 0; j < dimensions; ++j) {
+            const double deltaJ = otherMean[j] - mean[j];
+            comoment[i * dimensions + j] += otherComoment[i * dimensions + j] + deltaI * deltaJ * weight;
+        }
+    }
+    for (size_t i = 0; i < dimensions; ++i) {
+        mean[i] += (otherMean[i] - mean[i]) * (static_cast<double>(otherCount) / n);
+    }
+    count += otherCount;
+}
+
+} // namespace
+
+ComomentStatistics::ComomentStatistics(size_t dimensions)
+    : mean(dimensions, 0.0), comoment(dimensions * dimensions, 0.0) {}
+
+void ComomentStatistics::merge(const ComomentStatistics& other) {
+    mergeComoments(getDimensions(), count, mean.data(), comoment.data(),
+                   other.count, other.mean.data(), other.comoment.data());
+}
+
+void summarizeComoments(const double* columns, size_t stride, size_t count, ComomentStatistics& out) {
+    const size_t dimensions = out.getDimensions();
+    std::fill(out.mean.begin(), out.mean.end(), 0.0);
+    std::fill(out.comoment.begin(), out.comoment.end(), 0.0);
+    out.count = 0;
+    for (size_t row = 0; row < count; ++row) {
+        if (!isValidRow(columns, stride, dimensions, row)) {
+            continue;
+        }
+        out.count++;
+        for (size_t k = 0; k < dimensions; ++k) {
+            out.mean[k] += columns[k * stride + row];
+        }
+    }
+    if (out.count == 0) {
+        return;
+    }
+    for (size_t k = 0; k < dimensions; ++k) {
+        out.mean[k] /= static_cast<double>(out.count);
+    }
+
+    // Second pass: products of deviations from the block means
+    for (size_t row = 0; row < count; ++row) {
+        if (!isValidRow(columns, stride, dimensions, row)) {
+            continue;
+        }
+        for (size_t i = 0; i < dimensions; ++i) {
+            const double deviationI = columns[i * stride + row] - out.mean[i];
+            for (size_t j = i; j < dimensions; ++j) {
+                out.comoment[i * dimensions + j] += deviationI * (columns[j * stride + row] - out.mean[j]);
+            }
+        }
+    }
+    for (size_t i = 0; i < dimensions; ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            out.comoment[i * dimensions + j] = out.comoment[j * dimensions + i];
+        }
+    }
+}
+
+ComomentReducer::ComomentReducer(size_t dimensions, size_t maxBlocks) : dimensions_(dimensions) {
+    // A binary counter of n blocks holds one node per bit of n, plus the
+    // one being pushed
+    size_t nodes = 2;
+    for (size_t blocks = maxBlocks; blocks > 1; blocks /= 2) {
+        nodes++;
+    }
+    counts_.reserve(nodes);
+    blocks_.reserve(nodes);
+    values_.reserve(nodes * (dimensions + dimensions * dimensions));
+}
+
+void ComomentReducer::add(const ComomentStatistics& block) {
+    push(block.count, 1, block.mean.data(), block.comoment.data());
+}
+
+void ComomentReducer::append(const ComomentReducer& later) {
+    const size_t stride = dimensions_ + dimensions_ * dimensions_;
+    for (size_t k = 0; k < later.counts_.size(); ++k) {
+        const double* node = later.values_.data() + k * stride;
+        push(later.counts_[k], later.blocks_[k], node, node + dimensions_);
+    }
+}
+
+void ComomentReducer::push(size_t count, size_t blocks, const double* mean, const double* comoment) {
+    const size_t stride = dimensions_ + dimensions_ * dimensions_;
+    counts_.push_back(count);
+    blocks_.push_back(blocks);
+    values_.insert(values_.end(), mean, mean + dimensions_);
+    values_.insert(values_.end(), comoment, comoment + dimensions_ * dimensions_);
+    while (counts_.size() >= 2 && blocks_[blocks_.size() - 2] == blocks_.back()) {
+        const size_t right = counts_.size() - 1;
+        double* left = values_.data() + (right - 1) * stride;
+        const double* node = values_.data() + right * stride;
+        mergeComoments(dimensions_, counts_[right - 1], left, left + dimensions_,
+                       counts_[right], node, node + dimensions_);
+        blocks_[right - 1] *= 2;
+        counts_.pop_back();
+        blocks_.pop_back();
+        values_.resize(right * stride);
+    }
+}
+
+ComomentStatistics ComomentReducer::total() const {
+    const size_t stride = dimensions_ + dimensions_ * dimensions_;
+    ComomentStatistics result(dimensions_);
+    for (size_t k = 0; k < counts_.size(); ++k) {
+        const double* node = values_.data() + k * stride;
+        mergeComoments(dimensions_, result.count, result.mean.data(), result.comoment.data(),
+                       counts_[k], node, node + dimensions_);
+    }
+    return result;
+}
+
+size_t ComomentReducer::getBlockCount() const {
+    size_t blocks = 0;
+    for (size_t count : blocks_) {
+        blocks += count;
+    }
+    return blocks;
+}
+
+ControlVariateEstimate estimateWithControls(const ComomentStatistics& stats,
+                                            const std::vector<double>& expectations) {
+    const size_t dimensions = stats.getDimensions();
+    const size_t controls = expectations.size();
+    ControlVariateEstimate estimate;
+    estimate.coefficients.assign(controls, std::numeric_limits<double>::quiet_NaN());
+    estimate.mean = std::numeric_limits<double>::quiet_NaN();
+    estimate.standardError = std::numeric_limits<double>::quiet_NaN();
+    if (stats.count == 0) {
+        return estimate;
+    }
+    // S_cc is stats.comoment at (1 + i, 1 + j), S_cy at (1 + i, 0)
+    auto comoment = [&stats, dimensions](size_t i, size_t j) {
+        return stats.comoment[i * dimensions + j];
+    };
+
+    // Cholesky factor L of S_cc; a dependent control keeps a zero column
+    std::vector<double> lower(controls * controls, 0.0);
+    std::vector<bool> used(controls, false);
+    size_t usedCount = 0;
+    for (size_t j = 0; j < controls; ++j) {
+        double pivot = comoment(1 + j, 1 + j);
+        for (size_t k = 0; k < j; ++k) {
+            pivot -= lower[j * controls + k] * lower[j * controls + k];
+        }
+        if (!(pivot > DEPENDENT_CONTROL * comoment(1 + j, 1 + j))) {
+            continue;
+        }
+        used[j] = true;
+        usedCount++;
+        const double diagonal = std::sqrt(pivot);
+        lower[j * controls + j] = diagonal;
+        for (size_t i = j + 1; i < controls; ++i) {
+            double value = comoment(1 + i, 1 + j);
+            for (size_t k = 0; k < j; ++k) {
+                value -= lower[i * controls + k] * lower[j * controls + k];
+            }
+            lower[i * controls + j] = value / diagonal;
+        }
+    }
+
+    // Solve L z = S_cy, then L^T b = z
+    std::vector<double> z(controls, 0.0);
+    for (size_t j = 0; j < controls; ++j) {
+        if (!used[j]) {
+            continue;
+        }
+        double value = comoment(1 + j, 0);
+        for (size_t k = 0; k < j; ++k) {
+            value -= lower[j * controls + k] * z[k];
+        }
+        z[j] = value / lower[j * controls + j];
+    }
+    for (size_t j = controls; j-- > 0;) {
+        if (!used[j]) {
+            estimate.coefficients[j] = 0.0;
+            continue;
+        }
+        double value = z[j];
+        for (size_t k = j + 1; k < controls; ++k) {
+            value -= lower[k * controls + j] * estimate.coefficients[k];
+        }
+        estimate.coefficients[j] = value / lower[j * controls + j];
+    }
+
+    // Controlled mean and the variance of the regression residuals
+    estimate.mean = stats.mean[0];
+    double residual = comoment(0, 0);
+    for (size_t j = 0; j < controls; ++j) {
+        estimate.mean -= estimate.coefficients[j] * (stats.mean[1 + j] - expectations[j]);
+        residual -= estimate.coefficients[j] * comoment(1 + j, 0);
+    }
+    if (stats.count > usedCount + 1) {
+        const double variance = std::max(residual, 0.0) / static_cast<double>(stats.count - usedCount - 1);
+        estimate.standardError = std::sqrt(variance / static_cast<double>(stats.count));
+    }
+    return estimate;
+}
+
+} // namespace tt_int
@@ -1,21 +1,230 @@
 #include "distribution.h"
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 namespace tt_int {
 
+namespace {
+
+constexpr double LOG_SQRT_TWO_PI = 0.91893853320467274178032973640562;
+
+[[noreturn]] void throwNotImplemented(const char* member) {
+    throw std::logic_error(std::string("Distribution does not implement ") + member);
+}
+
+template <typename Engine>
+void sampleEach(const Distribution& dist, Engine& rng, SamplerState& state,
+                double* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = dist.sample(rng, state);
+    }
+}
+
+} // namespace
+
+// Distribution defaults, for subclasses of the original interface
+double Distribution::sample(std::mt19937& rng, SamplerState&) const {
+    return sample(rng);
+}
+
+double Distribution::sample(Philox4x32&, SamplerState&) const {
+    throwNotImplemented("sample() for Philox4x32");
+}
+
+double Distribution::sample(Xoshiro256PlusPlus&, SamplerState&) const {
+    throwNotImplemented("sample() for Xoshiro256PlusPlus");
+}
+
+double Distribution::sample(Xoroshiro128Plus&, SamplerState&) const {
+    throwNotImplemented("sample() for Xoroshiro128Plus");
+}
+
+void Distribution::sample(std::mt19937& rng, SamplerState& state, double* out, size_t count) const {
+    sampleEach(*this, rng, state, out, count);
+}
+
+void Distribution::sample(Philox4x32& rng, SamplerState& state, double* out, size_t count) const {
+    sampleEach(*this, rng, state, out, count);
+}
+
+void Distribution::sample(Xoshiro256PlusPlus& rng, SamplerState& state, double* out, size_t count) const {
+    sampleEach(*this, rng, state, out, count);
+}
+
+void Distribution::sample(Xoroshiro128Plus& rng, SamplerState& state, double* out, size_t count) const {
+    sampleEach(*this, rng, state, out, count);
+}
+
+double Distribution::cdf(double) const {
+    throwNotImplemented("cdf()");
+}
+
+double Distribution::logPdf(double) const {
+    throwNotImplemented("logPdf()");
+}
+
+double Distribution::inverseCdf(double) const {
+    throwNotImplemented("inverseCdf()");
+}
+
+std::unique_ptr<Distribution> Distribution::clone() const {
+    throwNotImplemented("clone()");
+}
+
+const ZigguratTables& ZigguratTables::get() {
+    static const ZigguratTables tables = [] {
+        ZigguratTables result;
+        double f = std::exp(-0.5 * TAIL_START * TAIL_START);
+        result.x[0] = LAYER_AREA / f;
+        result.x[1] = TAIL_START;
+        result.x[LAYERS] = 0.0;
+        for (size_t i = 2; i < LAYERS; ++i) {
+            result.x[i] = std::sqrt(-2.0 * std::log(LAYER_AREA / result.x[i - 1] + f));
+            f = std::exp(-0.5 * result.x[i] * result.x[i]);
+        }
+        for (size_t i = 0; i < LAYERS; ++i) {
+            result.ratio[i] = result.x[i + 1] / result.x[i];
+        }
+        return result;
+    }();
+    return tables;
+}
+
 // NormalDistribution implementation
-NormalDistribution::NormalDistribution(double mean, double stddev)
-    : mean_(mean), stddev_(stddev), dist_(mean, stddev) {}
+NormalDistribution::NormalDistribution(double mean, double stddev, NormalSampler sampler)
+    : mean_(mean), stddev_(stddev), sampler_(sampler),
+      ziggurat_(&ZigguratTables::get()) {}
+
+std::unique_ptr<Distribution> NormalDistribution::clone() const {
+    return std::make_unique<NormalDistribution>(mean_, stddev_, sampler_);
+}
 
-double NormalDistribution::sample(std::mt19937& rng) const {
-    return dist_(rng);
+double NormalDistribution::cdf(double x) const {
+    return 0.5 * std::erfc((mean_ - x) / (stddev_ * std::sqrt(2.0)));
+}
+
+double NormalDistribution::logPdf(double x) const {
+    const double z = (x - mean_) / stddev_;
+    return (-std::log(stddev_) - LOG_SQRT_TWO_PI) - 0.5 * z * z;
+}
+
+void NormalDistribution::logPdf(const double* x, double* out, size_t count) const {
+    // Same arithmetic as the scalar form, with the logarithm hoisted
+    const double offset = -std::log(stddev_) - LOG_SQRT_TWO_PI;
+    for (size_t i = 0; i < count; ++i) {
+        const double z = (x[i] - mean_) / stddev_;
+        out[i] = offset - 0.5 * z * z;
+    }
+}
+
+double NormalDistribution::inverseCdf(double p) const {
+    if (p <= 0.0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    if (p >= 1.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    static constexpr double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                                   -2.759285104469687e+02, 1.383577518672690e+02,
+                                   -3.066479806614716e+01, 2.506628277459239e+00};
+    static constexpr double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                                   -1.556989798598866e+02, 6.680131188771972e+01,
+                                   -1.328068155288572e+01};
+    static constexpr double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                                   -2.400758277161838e+00, -2.549732539343734e+00,
+                                   4.374664141464968e+00, 2.938163982698783e+00};
+    static constexpr double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                                   2.445134137142996e+00, 3.754408661907416e+00};
+    constexpr double P_LOW = 0.02425;
+    
+    // Rational approximation, relative error below 1.2e-9
+    double z;
+    if (p < P_LOW || p > 1.0 - P_LOW) {
+        const double q = std::sqrt(-2.0 * std::log(p < P_LOW ? p : 1.0 - p));
+        z = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        if (p > P_LOW) {
+            z = -z;
+        }
+    } else {
+        const double q = p - 0.5;
+        const double r = q * q;
+        z = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+    
+    // One Halley step on Phi(z) - p brings it to full double precision
+    constexpr double SQRT_TWO_PI = 2.506628274631000502415765284811;
+    const double e = 0.5 * std::erfc(-z / std::sqrt(2.0)) - p;
+    const double u = e * SQRT_TWO_PI * std::exp(0.5 * z * z);
+    if (std::isfinite(u)) {  // exp() overflows only for p near the smallest doubles
+        z -= u / (1.0 + 0.5 * z * u);
+    }
+    return mean_ + stddev_ * z;
+}
+
+void NormalDistribution::antithetic(const double* in, double* out, size_t count) const {
+    const double twiceMean = 2.0 * mean_;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = twiceMean - in[i];
+    }
+}
+
+void NormalDistribution::boxMuller(double* values, size_t pairs) const {
+    constexpr double TWO_PI = 6.283185307179586476925286766559;
+    double* first = values;
+    double* second = values + pairs;
+    for (size_t i = 0; i < pairs; ++i) {
+        // 1 - u lies in (0, 1], so the logarithm is finite
+        const double radius = stddev_ * std::sqrt(-2.0 * std::log(1.0 - first[i]));
+        const double angle = TWO_PI * second[i];
+        first[i] = mean_ + radius * std::cos(angle);
+        second[i] = mean_ + radius * std::sin(angle);
+    }
 }
 
 // UniformDistribution implementation
 UniformDistribution::UniformDistribution(double min, double max)
-    : min_(min), max_(max), dist_(min, max) {}
+    : min_(min), max_(max) {}
+
+std::unique_ptr<Distribution> UniformDistribution::clone() const {
+    return std::make_unique<UniformDistribution>(min_, max_);
+}
+
+double UniformDistribution::cdf(double x) const {
+    if (x <= min_) {
+        return 0.0;
+    }
+    if (x >= max_) {
+        return 1.0;
+    }
+    return (x - min_) / (max_ - min_);
+}
+
+double UniformDistribution::logPdf(double x) const {
+    if (x < min_ || x > max_) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return -std::log(max_ - min_);
+}
+
+double UniformDistribution::inverseCdf(double p) const {
+    return min_ + (max_ - min_) * p;
+}
+
+void UniformDistribution::inverseCdf(const double* p, double* out, size_t count) const {
+    const double width = max_ - min_;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = min_ + width * p[i];
+    }
+}
 
-double UniformDistribution::sample(std::mt19937& rng) const {
-    return dist_(rng);
+void UniformDistribution::antithetic(const double* in, double* out, size_t count) const {
+    const double sum = min_ + max_;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = sum - in[i];
+    }
 }
 
 } // namespace tt_int
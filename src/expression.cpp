@@ -1,10 +1,61 @@
 #include "expression.h"
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <limits>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace tt_int {
 
+namespace {
+
+// Node kind tags mixed into structural hashes
+constexpr std::uint64_t CONSTANT_TAG = 0x436f6e7374616e74ULL;
+constexpr std::uint64_t VARIABLE_TAG = 0x5661726961626c65ULL;
+constexpr std::uint64_t BINARY_OP_TAG = 0x42696e6172794f70ULL;
+
+// splitmix64 finalizer: cheap, well-distributed and identical on every platform
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t combine(std::uint64_t seed, std::uint64_t value) {
+    return mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+std::uint64_t doubleBits(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// FNV-1a; unlike std::hash it is specified, so hashes are stable across builds
+std::uint64_t hashString(const std::string& text) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+// Expression defaults: identity
+size_t Expression::hash() const {
+    return std::hash<const Expression*>()(this);
+}
+
+bool Expression::equals(const Expression& other) const {
+    return this == &other;
+}
+
 // Constant implementation
 Constant::Constant(double value) : value_(value) {}
 
@@ -13,6 +64,15 @@ double Constant::evaluate(const std::map<std::string, double>& variables) const
     return value_;
 }
 
+size_t Constant::hash() const {
+    return static_cast<size_t>(combine(CONSTANT_TAG, doubleBits(value_)));
+}
+
+bool Constant::equals(const Expression& other) const {
+    const auto* constant = dynamic_cast<const Constant*>(&other);
+    return constant != nullptr && doubleBits(constant->value_) == doubleBits(value_);
+}
+
 // Variable implementation
 Variable::Variable(const std::string& name) : name_(name) {}
 
@@ -24,11 +84,75 @@ double Variable::evaluate(const std::map<std::string, double>& variables) const
     return it->second;
 }
 
+size_t Variable::hash() const {
+    return static_cast<size_t>(combine(VARIABLE_TAG, hashString(name_)));
+}
+
+bool Variable::equals(const Expression& other) const {
+    const auto* variable = dynamic_cast<const Variable*>(&other);
+    return variable != nullptr && variable->name_ == name_;
+}
+
 // BinaryOp implementation
 BinaryOp::BinaryOp(std::shared_ptr<Expression> left,
                    std::shared_ptr<Expression> right,
                    BinaryOperator op)
-    : left_(left), right_(right), op_(op) {}
+    : left_(left), right_(right), op_(op) {
+    std::uint64_t hash = combine(BINARY_OP_TAG, static_cast<std::uint64_t>(op_));
+    hash = combine(hash, left_ ? left_->hash() : 0);
+    hash_ = static_cast<size_t>(combine(hash, right_ ? right_->hash() : 0));
+}
+
+BinaryOp::~BinaryOp() {
+    // Operands owned only by this node are moved out and destroyed one at a
+    // time, after their own operands have been moved out in turn
+    std::vector<std::shared_ptr<Expression>> pending;
+    auto release = [&pending](std::shared_ptr<Expression>& operand) {
+        if (operand && operand.use_count() == 1) {
+            pending.push_back(std::move(operand));
+        }
+    };
+    release(left_);
+    release(right_);
+    while (!pending.empty()) {
+        std::shared_ptr<Expression> node = std::move(pending.back());
+        pending.pop_back();
+        if (auto* binary = dynamic_cast<BinaryOp*>(node.get())) {
+            release(binary->left_);
+            release(binary->right_);
+        }
+    }
+}
+
+bool BinaryOp::equals(const Expression& other) const {
+    // Iterative so that comparing long operator chains cannot overflow the stack
+    std::vector<std::pair<const Expression*, const Expression*>> pending = {{this, &other}};
+    while (!pending.empty()) {
+        auto [a, b] = pending.back();
+        pending.pop_back();
+        if (a == b) {
+            continue;  // Shared subtree
+        }
+        if (a == nullptr || b == nullptr || a->hash() != b->hash()) {
+            return false;
+        }
+        
+        const auto* binaryA = dynamic_cast<const BinaryOp*>(a);
+        const auto* binaryB = dynamic_cast<const BinaryOp*>(b);
+        if (binaryA == nullptr || binaryB == nullptr) {
+            if (binaryA != nullptr || binaryB != nullptr || !a->equals(*b)) {
+                return false;
+            }
+            continue;
+        }
+        if (binaryA->op_ != binaryB->op_) {
+            return false;
+        }
+        pending.push_back({binaryA->left_.get(), binaryB->left_.get()});
+        pending.push_back({binaryA->right_.get(), binaryB->right_.get()});
+    }
+    return true;
+}
 
 double BinaryOp::evaluate(const std::map<std::string, double>& variables) const {
     double leftValue = left_->evaluate(variables);
@@ -1,4 +1,5 @@
 #include "expression_builder.h"
+#include <stdexcept>
 
 namespace tt_int {
 
@@ -71,4 +72,72 @@ ExpressionBuilder operator/(double lhs, const ExpressionBuilder& rhs) {
     return ExpressionBuilder::constant(lhs) / rhs;
 }
 
+// GraphExpressionBuilder implementation
+GraphExpressionBuilder::GraphExpressionBuilder(ExpressionGraph& graph, ExpressionGraph::NodeId id)
+    : graph_(&graph), id_(id) {}
+
+GraphExpressionBuilder GraphExpressionBuilder::constant(ExpressionGraph& graph, double value) {
+    return GraphExpressionBuilder(graph, graph.constant(value));
+}
+
+GraphExpressionBuilder GraphExpressionBuilder::variable(ExpressionGraph& graph, const std::string& name) {
+    return GraphExpressionBuilder(graph, graph.variable(name));
+}
+
+GraphExpressionBuilder GraphExpressionBuilder::combine(const GraphExpressionBuilder& other,
+                                                       BinaryOperator op) const {
+    if (graph_ != other.graph_) {
+        throw std::invalid_argument("Cannot combine nodes from different expression graphs");
+    }
+    return GraphExpressionBuilder(*graph_, graph_->binary(op, id_, other.id_));
+}
+
+GraphExpressionBuilder GraphExpressionBuilder::operator+(const GraphExpressionBuilder& other) const {
+    return combine(other, BinaryOperator::Add);
+}
+
+GraphExpressionBuilder GraphExpressionBuilder::operator-(const GraphExpressionBuilder& other) const {
+    return combine(other, BinaryOperator::Subtract);
+}
+
+GraphExpressionBuilder GraphExpressionBuilder::operator*(const GraphExpressionBuilder& other) const {
+    return combine(other, BinaryOperator::Multiply);
+}
+
+GraphExpressionBuilder GraphExpressionBuilder::operator/(const GraphExpressionBuilder& other) const {
+    return combine(other, BinaryOperator::Divide);
+}
+
+GraphExpressionBuilder operator+(const GraphExpressionBuilder& lhs, double rhs) {
+    return lhs + GraphExpressionBuilder::constant(lhs.getGraph(), rhs);
+}
+
+GraphExpressionBuilder operator-(const GraphExpressionBuilder& lhs, double rhs) {
+    return lhs - GraphExpressionBuilder::constant(lhs.getGraph(), rhs);
+}
+
+GraphExpressionBuilder operator*(const GraphExpressionBuilder& lhs, double rhs) {
+    return lhs * GraphExpressionBuilder::constant(lhs.getGraph(), rhs);
+}
+
+GraphExpressionBuilder operator/(const GraphExpressionBuilder& lhs, double rhs) {
+    return lhs / GraphExpressionBuilder::constant(lhs.getGraph(), rhs);
+}
+
+GraphExpressionBuilder operator+(double lhs, const GraphExpressionBuilder& rhs) {
+    return GraphExpressionBuilder::constant(rhs.getGraph(), lhs) + rhs;
+}
+
+GraphExpressionBuilder operator-(double lhs, const GraphExpressionBuilder& rhs) {
+    return GraphExpressionBuilder::constant(rhs.getGraph(), lhs) - rhs;
+}
+
+GraphExpressionBuilder operator*(double lhs, const GraphExpressionBuilder& rhs) {
+    return GraphExpressionBuilder::constant(rhs.getGraph(), lhs) * rhs;
+}
+
+GraphExpressionBuilder operator/(double lhs, const GraphExpressionBuilder& rhs) {
+    return GraphExpressionBuilder::constant(rhs.getGraph(), lhs) / rhs;
+}
+
 } // namespace tt_int
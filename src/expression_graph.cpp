@@ -0,0 +1,159 @@
+#include "expression_graph.h"
+#include <limits>
+#include <stdexcept>
+
+namespace tt_int {
+
+namespace {
+
+NodeKind toNodeKind(BinaryOperator op) {
+    switch (op) {
+        case BinaryOperator::Add:      return NodeKind::Add;
+        case BinaryOperator::Subtract: return NodeKind::Subtract;
+        case BinaryOperator::Multiply: return NodeKind::Multiply;
+        case BinaryOperator::Divide:   return NodeKind::Divide;
+    }
+    throw std::logic_error("Unknown binary operator");
+}
+
+BinaryOperator toBinaryOperator(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::Add:      return BinaryOperator::Add;
+        case NodeKind::Subtract: return BinaryOperator::Subtract;
+        case NodeKind::Multiply: return BinaryOperator::Multiply;
+        case NodeKind::Divide:   return BinaryOperator::Divide;
+        default:                 break;
+    }
+    throw std::logic_error("Node is not a binary operation");
+}
+
+} // namespace
+
+ExpressionGraph::NodeId ExpressionGraph::push(const Node& node) {
+    if (nodes_.size() >= std::numeric_limits<NodeId>::max()) {
+        throw std::length_error("Expression graph node limit exceeded");
+    }
+    nodes_.push_back(node);
+    return static_cast<NodeId>(nodes_.size() - 1);
+}
+
+ExpressionGraph::NodeId ExpressionGraph::constant(double value) {
+    return push({NodeKind::Constant, 0, 0, value});
+}
+
+ExpressionGraph::NodeId ExpressionGraph::variable(const std::string& name) {
+    auto inserted = variableIndex_.emplace(name, static_cast<std::uint32_t>(variableNames_.size()));
+    if (inserted.second) {
+        variableNames_.push_back(name);
+    }
+    return push({NodeKind::Variable, inserted.first->second, 0, 0.0});
+}
+
+ExpressionGraph::NodeId ExpressionGraph::binary(BinaryOperator op, NodeId lhs, NodeId rhs) {
+    if (lhs >= nodes_.size() || rhs >= nodes_.size()) {
+        throw std::invalid_argument("Operand is not a node of this expression graph");
+    }
+    return push({toNodeKind(op), lhs, rhs, 0.0});
+}
+
+void ExpressionGraph::clear() {
+    nodes_.clear();
+    variableNames_.clear();
+    variableIndex_.clear();
+}
+
+std::vector<bool> ExpressionGraph::reachableFrom(NodeId root) const {
+    if (root >= nodes_.size()) {
+        throw std::invalid_argument("Root is not a node of this expression graph");
+    }
+    // Operands always precede their users, so one backward sweep suffices
+    std::vector<bool> reachable(static_cast<size_t>(root) + 1, false);
+    reachable[root] = true;
+    for (size_t id = root + 1; id-- > 0;) {
+        const Node& node = nodes_[id];
+        if (!reachable[id] || node.kind == NodeKind::Constant || node.kind == NodeKind::Variable) {
+            continue;
+        }
+        reachable[node.lhs] = true;
+        reachable[node.rhs] = true;
+    }
+    return reachable;
+}
+
+double ExpressionGraph::evaluate(NodeId root, const std::map<std::string, double>& variables) const {
+    std::vector<bool> reachable = reachableFrom(root);
+    std::vector<double> results(reachable.size());
+
+    for (size_t id = 0; id < reachable.size(); ++id) {
+        if (!reachable[id]) {
+            continue;
+        }
+        const Node& node = nodes_[id];
+        switch (node.kind) {
+            case NodeKind::Constant:
+                results[id] = node.value;
+                break;
+
+            case NodeKind::Variable: {
+                const std::string& name = variableNames_[node.lhs];
+                auto it = variables.find(name);
+                if (it == variables.end()) {
+                    throw std::out_of_range("Variable '" + name + "' not found in variable map");
+                }
+                results[id] = it->second;
+                break;
+            }
+
+            case NodeKind::Add:
+                results[id] = results[node.lhs] + results[node.rhs];
+                break;
+
+            case NodeKind::Subtract:
+                results[id] = results[node.lhs] - results[node.rhs];
+                break;
+
+            case NodeKind::Multiply:
+                results[id] = results[node.lhs] * results[node.rhs];
+                break;
+
+            case NodeKind::Divide: {
+                // Same divide-by-zero semantics as BinaryOp::evaluate
+                double divisor = results[node.rhs];
+                results[id] = divisor == 0.0
+                    ? std::numeric_limits<double>::quiet_NaN()
+                    : results[node.lhs] / divisor;
+                break;
+            }
+        }
+    }
+    return results[root];
+}
+
+std::shared_ptr<Expression> ExpressionGraph::toExpression(NodeId root) const {
+    std::vector<bool> reachable = reachableFrom(root);
+    std::vector<std::shared_ptr<Expression>> converted(reachable.size());
+
+    for (size_t id = 0; id < reachable.size(); ++id) {
+        if (!reachable[id]) {
+            continue;
+        }
+        const Node& node = nodes_[id];
+        switch (node.kind) {
+            case NodeKind::Constant:
+                converted[id] = std::make_shared<Constant>(node.value);
+                break;
+
+            case NodeKind::Variable:
+                converted[id] = std::make_shared<Variable>(variableNames_[node.lhs]);
+                break;
+
+            default:
+                converted[id] = std::make_shared<BinaryOp>(
+                    converted[node.lhs], converted[node.rhs], toBinaryOperator(node.kind));
+                break;
+        }
+    }
+    return converted[root];
+}
+
+} // namespace tt_int
@@ -0,0 +1,227 @@
+#include "expression_optimizer.h"
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tt_int {
+
+namespace {
+
+const Constant* asConstant(const std::shared_ptr<Expression>& expr) {
+    return dynamic_cast<const Constant*>(expr.get());
+}
+
+bool isConstantValue(const std::shared_ptr<Expression>& expr, double value) {
+    const Constant* constant = asConstant(expr);
+    return constant != nullptr && constant->getValue() == value;
+}
+
+/**
+ * @brief Build the simplified form of left (op) right
+ * @param original The node being rewritten, reused when nothing changes
+ */
+std::shared_ptr<Expression> rewriteBinary(const std::shared_ptr<Expression>& original,
+                                          const std::shared_ptr<Expression>& left,
+                                          const std::shared_ptr<Expression>& right,
+                                          BinaryOperator op) {
+    // Constant-only subtree: evaluate it once, with the exact runtime semantics
+    if (asConstant(left) != nullptr && asConstant(right) != nullptr) {
+        BinaryOp folded(left, right, op);
+        return std::make_shared<Constant>(folded.evaluate({}));
+    }
+
+    switch (op) {
+        case BinaryOperator::Add:
+            if (isConstantValue(right, 0.0)) return left;
+            if (isConstantValue(left, 0.0)) return right;
+            break;
+
+        case BinaryOperator::Subtract:
+            if (isConstantValue(right, 0.0)) return left;
+            break;
+
+        case BinaryOperator::Multiply:
+            if (isConstantValue(right, 1.0)) return left;
+            if (isConstantValue(left, 1.0)) return right;
+            break;
+
+        case BinaryOperator::Divide:
+            if (const Constant* divisor = asConstant(right)) {
+                double reciprocal = 1.0 / divisor->getValue();
+                if (std::isnormal(reciprocal)) {
+                    return rewriteBinary(nullptr, left,
+                                         std::make_shared<Constant>(reciprocal),
+                                         BinaryOperator::Multiply);
+                }
+            }
+            break;
+    }
+
+    if (original != nullptr) {
+        const auto* node = static_cast<const BinaryOp*>(original.get());
+        if (node->getLeft() == left && node->getRight() == right) {
+            return original;
+        }
+    }
+    return std::make_shared<BinaryOp>(left, right, op);
+}
+
+} // namespace
+
+size_t countNodes(const std::shared_ptr<Expression>& expr) {
+    std::unordered_set<const Expression*> visited;
+    std::vector<const Expression*> stack = {expr.get()};
+    while (!stack.empty()) {
+        const Expression* node = stack.back();
+        stack.pop_back();
+        if (node == nullptr || !visited.insert(node).second) {
+            continue;
+        }
+        if (const auto* binary = dynamic_cast<const BinaryOp*>(node)) {
+            stack.push_back(binary->getLeft().get());
+            stack.push_back(binary->getRight().get());
+        }
+    }
+    return visited.size();
+}
+
+std::set<std::string> collectVariables(const std::shared_ptr<Expression>& expr) {
+    std::set<std::string> names;
+    std::unordered_set<const Expression*> visited;
+    std::vector<const Expression*> stack = {expr.get()};
+    while (!stack.empty()) {
+        const Expression* node = stack.back();
+        stack.pop_back();
+        if (node == nullptr || !visited.insert(node).second) {
+            continue;
+        }
+        if (const auto* variable = dynamic_cast<const Variable*>(node)) {
+            names.insert(variable->getName());
+        } else if (const auto* binary = dynamic_cast<const BinaryOp*>(node)) {
+            stack.push_back(binary->getLeft().get());
+            stack.push_back(binary->getRight().get());
+        }
+    }
+    return names;
+}
+
+OptimizationResult simplify(const std::shared_ptr<Expression>& expr) {
+    // Rewritten form of every visited node; shared subtrees are simplified
+    // once and stay shared in the output
+    std::unordered_map<const Expression*, std::shared_ptr<Expression>> rewritten;
+
+    // Iterative post-order walk so deep operator chains cannot overflow the stack
+    std::vector<std::pair<std::shared_ptr<Expression>, bool>> stack = {{expr, false}};
+    while (!stack.empty()) {
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+        if (rewritten.count(node.get()) != 0) {
+            continue;
+        }
+
+        const auto* binary = dynamic_cast<const BinaryOp*>(node.get());
+        if (binary == nullptr) {
+            // Leaves (and unknown node types) are kept as they are
+            rewritten[node.get()] = node;
+            continue;
+        }
+        if (!expanded) {
+            stack.push_back({node, true});
+            stack.push_back({binary->getRight(), false});
+            stack.push_back({binary->getLeft(), false});
+            continue;
+        }
+
+        rewritten[node.get()] = rewriteBinary(node,
+                                              rewritten.at(binary->getLeft().get()),
+                                              rewritten.at(binary->getRight().get()),
+                                              binary->getOperator());
+    }
+
+    OptimizationResult result;
+    result.expression = rewritten.at(expr.get());
+    size_t before = countNodes(expr);
+    size_t after = countNodes(result.expression);
+    result.nodesRemoved = before > after ? before - after : 0;
+    return result;
+}
+
+OptimizationResult eliminateCommonSubexpressions(const std::shared_ptr<Expression>& expr) {
+    // Canonical node for every visited node, and canonical nodes by hash.
+    // Children are canonicalized first, so two nodes are identical exactly
+    // when they have the same operator and the same canonical children.
+    std::unordered_map<const Expression*, std::shared_ptr<Expression>> canonical;
+    std::unordered_map<size_t, std::vector<std::shared_ptr<Expression>>> buckets;
+
+    std::vector<std::pair<std::shared_ptr<Expression>, bool>> stack = {{expr, false}};
+    while (!stack.empty()) {
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+        if (canonical.count(node.get()) != 0) {
+            continue;
+        }
+        if (node == nullptr) {
+            canonical[nullptr] = nullptr;
+            continue;
+        }
+
+        auto& bucket = buckets[node->hash()];
+        const auto* binary = dynamic_cast<const BinaryOp*>(node.get());
+        if (binary == nullptr) {
+            std::shared_ptr<Expression> match = node;
+            for (const auto& candidate : bucket) {
+                if (candidate->equals(*node)) {
+                    match = candidate;
+                    break;
+                }
+            }
+            if (match == node) {
+                bucket.push_back(node);
+            }
+            canonical[node.get()] = match;
+            continue;
+        }
+        if (!expanded) {
+            stack.push_back({node, true});
+            stack.push_back({binary->getRight(), false});
+            stack.push_back({binary->getLeft(), false});
+            continue;
+        }
+
+        const auto& left = canonical.at(binary->getLeft().get());
+        const auto& right = canonical.at(binary->getRight().get());
+        std::shared_ptr<Expression> match;
+        for (const auto& candidate : bucket) {
+            const auto* other = dynamic_cast<const BinaryOp*>(candidate.get());
+            if (other != nullptr && other->getOperator() == binary->getOperator() &&
+                other->getLeft() == left && other->getRight() == right) {
+                match = candidate;
+                break;
+            }
+        }
+        if (match == nullptr) {
+            match = (binary->getLeft() == left && binary->getRight() == right)
+                ? node
+                : std::make_shared<BinaryOp>(left, right, binary->getOperator());
+            bucket.push_back(match);
+        }
+        canonical[node.get()] = match;
+    }
+
+    OptimizationResult result;
+    result.expression = canonical.at(expr.get());
+    size_t before = countNodes(expr);
+    size_t after = countNodes(result.expression);
+    result.nodesRemoved = before > after ? before - after : 0;
+    return result;
+}
+
+OptimizationResult optimize(const std::shared_ptr<Expression>& expr) {
+    OptimizationResult simplified = simplify(expr);
+    OptimizationResult deduplicated = eliminateCommonSubexpressions(simplified.expression);
+    deduplicated.nodesRemoved += simplified.nodesRemoved;
+    return deduplicated;
+}
+
+} // namespace tt_int
@@ -0,0 +1,56 @@
+#include "latin_hypercube.h"
+#include "xoshiro.h"
+
+namespace tt_int {
+
+std::uint32_t permuteIndex(std::uint32_t index, std::uint32_t n, std::uint32_t seed) {
+    // Every step is a bijection modulo the next power of two: XOR with a
+    // constant, multiplication by an odd number, and XOR with bits shifted
+    // down from within the mask. Values that land outside [0, n) are
+    // permuted again until they fall inside.
+    std::uint32_t mask = n - 1;
+    mask |= mask >> 1;
+    mask |= mask >> 2;
+    mask |= mask >> 4;
+    mask |= mask >> 8;
+    mask |= mask >> 16;
+    std::uint32_t i = index;
+    do {
+        i ^= seed;
+        i *= 0xe170893du;
+        i ^= seed >> 16;
+        i ^= (i & mask) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929eb3fu;
+        i ^= seed >> 23;
+        i ^= (i & mask) >> 1;
+        i *= 1 | seed >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & mask) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & mask) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & mask) >> 2;
+        i *= 0xc860a3dfu;
+        i &= mask;
+        i ^= i >> 5;
+    } while (i >= n);
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(i) + seed) % n);
+}
+
+void fillLatinHypercube(std::uint64_t start, size_t count, std::uint64_t n,
+                        std::uint32_t seed, double* out) {
+    const double width = 1.0 / static_cast<double>(n);
+    for (size_t i = 0; i < count; ++i) {
+        const std::uint64_t index = start + i;
+        const std::uint32_t stratum = permuteIndex(static_cast<std::uint32_t>(index),
+                                                   static_cast<std::uint32_t>(n), seed);
+        // Jitter from a hash of (seed, index), offset by half an ulp so
+        // that it lies in (0, 1)
+        std::uint64_t state = (static_cast<std::uint64_t>(seed) << 32) ^ index;
+        const double jitter = ((detail::splitmix64(state) >> 11) + 0.5) * 0x1p-53;
+        out[i] = (static_cast<double>(stratum) + jitter) * width;
+    }
+}
+
+} // namespace tt_int
@@ -1,19 +1,1275 @@
 #include "monte_carlo_evaluator.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <set>
+#include <stdexcept>
+#include <thread>
+#include "compiled_expression.h"
+#include "control_variates.h"
+#include "expression_optimizer.h"
+#include "mt19937_jump.h"
+#include "pairwise_statistics.h"
+#include "latin_hypercube.h"
+#include "sobol_sequence.h"
+#include "thread_placement.h"
+#include "weighted_statistics.h"
 
 namespace tt_int {
 
+namespace {
+
+// Samples are generated and evaluated in blocks of this size: large enough to
+// amortize per-instruction dispatch, small enough that the variable columns
+// and register blocks stay cache resident
+constexpr size_t SAMPLE_BLOCK_SIZE = 512;
+
+// Parallel evaluation hands out work in chunks of this many samples; every
+// chunk has its own random stream, so the chunk size is part of the result
+constexpr size_t SAMPLE_CHUNK_SIZE = 32 * SAMPLE_BLOCK_SIZE;
+
+// Statistics are reduced per evaluation block, and chunks must be aligned,
+// power-of-two subtrees of the reduction (see PairwiseReducer)
+static_assert((SAMPLE_CHUNK_SIZE / SAMPLE_BLOCK_SIZE & (SAMPLE_CHUNK_SIZE / SAMPLE_BLOCK_SIZE - 1)) == 0,
+              "a chunk must hold a power-of-two number of blocks");
+
+/**
+ * @brief std::seed_seq over a fixed number of words, without its heap buffer
+ *
+ * generate() is the algorithm the standard specifies for std::seed_seq, so
+ * an engine seeded from it starts in exactly the same state.
+ */
+template <size_t N>
+class FixedSeedSequence {
+public:
+    using result_type = std::uint32_t;
+
+    explicit FixedSeedSequence(const std::array<std::uint32_t, N>& words) : words_(words) {}
+
+    size_t size() const { return N; }
+
+    template <typename Iterator>
+    void generate(Iterator begin, Iterator end) const {
+        const size_t n = static_cast<size_t>(end - begin);
+        if (n == 0) {
+            return;
+        }
+        auto at = [&](size_t k) -> std::uint32_t& {
+            return reinterpret_cast<std::uint32_t&>(begin[k % n]);
+        };
+        auto mix = [](std::uint32_t x) { return x ^ (x >> 27); };
+        for (size_t k = 0; k < n; ++k) {
+            at(k) = 0x8b8b8b8bu;
+        }
+        const size_t t = n >= 623 ? 11 : n >= 68 ? 7 : n >= 39 ? 5 : n >= 7 ? 3 : (n - 1) / 2;
+        const size_t p = (n - t) / 2;
+        const size_t q = p + t;
+        const size_t m = std::max(N + 1, n);
+        for (size_t k = 0; k < m; ++k) {
+            const std::uint32_t r1 = 1664525u * mix(at(k) ^ at(k + p) ^ at(k + n - 1));
+            const std::uint32_t r2 = r1 + static_cast<std::uint32_t>(
+                k == 0 ? N : k <= N ? k % n + words_[k - 1] : k % n);
+            at(k + p) += r1;
+            at(k + q) += r2;
+            at(k) = r2;
+        }
+        for (size_t k = m; k < m + n; ++k) {
+            const std::uint32_t r3 = 1566083941u * mix(at(k) + at(k + p) + at(k + n - 1));
+            const std::uint32_t r4 = r3 - static_cast<std::uint32_t>(k % n);
+            at(k + p) ^= r3;
+            at(k + q) ^= r4;
+            at(k) = r4;
+        }
+    }
+
+private:
+    std::array<std::uint32_t, N> words_;
+};
+
+ConvergencePoint toPoint(const SummaryStatistics& stats, size_t sampleCount) {
+    ConvergencePoint point;
+    point.sampleCount = sampleCount;
+    point.validCount = stats.count;
+    if (stats.count > 0) {
+        point.mean = stats.mean;
+        point.stddev = stats.stddev();
+    } else {
+        point.mean = std::numeric_limits<double>::quiet_NaN();
+        point.stddev = std::numeric_limits<double>::quiet_NaN();
+    }
+    return point;
+}
+
+/**
+ * @brief Add one evaluated block to a reducer, reporting the record points
+ *        that fall inside it
+ *
+ * A record point inside the block is reported with the reducer over the
+ * earlier blocks plus the statistics of the block's prefix; one at the end
+ * of the block with the reducer that includes it. This is the same
+ * computation whichever thread reduces the block.
+ *
+ * @param onRecord Called as onRecord(point, reducer, partial)
+ */
+template <typename OnRecord>
+void reduceBlock(PairwiseReducer& reducer, const double* values, size_t blockStart, size_t blockSize,
+                 std::vector<size_t>::const_iterator& record,
+                 std::vector<size_t>::const_iterator recordEnd,
+                 bool compensated, const OnRecord& onRecord) {
+    const size_t blockEnd = blockStart + blockSize;
+    for (; record != recordEnd && *record < blockEnd; ++record) {
+        onRecord(*record, reducer, summarizeBlock(values, *record - blockStart, compensated));
+    }
+    reducer.add(summarizeBlock(values, blockSize, compensated));
+    if (record != recordEnd && *record == blockEnd) {
+        onRecord(*record, reducer, SummaryStatistics());
+        ++record;
+    }
+}
+
+/**
+ * @brief Statistics of a range of any length, reduced block by block
+ */
+SummaryStatistics summarizeRange(const double* values, size_t count, bool compensated) {
+    PairwiseReducer reducer;
+    for (size_t start = 0; start < count; start += SAMPLE_BLOCK_SIZE) {
+        reducer.add(summarizeBlock(values + start, std::min(SAMPLE_BLOCK_SIZE, count - start), compensated));
+    }
+    return reducer.total();
+}
+
+/**
+ * @brief Record a convergence point from a prefix reducer and a partial block
+ */
+void recordPoint(SimulationResult& result, size_t point,
+                 const PairwiseReducer& prefix, const SummaryStatistics& partial) {
+    SummaryStatistics stats = prefix.total();
+    stats.merge(partial);
+    result.convergenceHistory.push_back(toPoint(stats, point));
+}
+
+/**
+ * @brief A record point inside a chunk, kept until the chunks before it are known
+ */
+struct ChunkRecord {
+    size_t point;
+    PairwiseReducer prefix;     // The chunk's blocks before the point
+    SummaryStatistics partial;  // The point's partial block
+};
+
+/**
+ * @brief What every worker evaluates: the tape (or native kernel), the
+ *        control variates' tapes and the registry slots they sample
+ */
+struct BlockProgram {
+    const CompiledExpression& program;
+    const NativeKernel* kernel;            // Used instead of program when set
+    const BlockKernel* fused;              // Used instead of both when set
+    const std::vector<size_t>& fusedSlots; // Slot of each fused column; NO_SLOT if unused
+    const std::vector<CompiledExpression>& controls;
+    const std::vector<size_t>& sampledSlots;
+    size_t slotCount;                      // Variables in the registry
+};
+
+constexpr size_t NO_SLOT = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief Per-thread scratch for evaluating blocks of samples
+ *
+ * Column k holds the samples of BlockProgram::sampledSlots[k].
+ */
+class BlockWorkspace {
+public:
+    explicit BlockWorkspace(const BlockProgram& blockProgram)
+        : blockProgram_(blockProgram),
+          columnStorage_(blockProgram.sampledSlots.size() * SAMPLE_BLOCK_SIZE),
+          columns_(blockProgram.slotCount, nullptr),
+          registers_(blockProgram.program.getRegisterCount() * SAMPLE_BLOCK_SIZE) {
+        if (!blockProgram.controls.empty()) {
+            size_t controlRegisters = 0;
+            for (const auto& control : blockProgram.controls) {
+                controlRegisters = std::max(controlRegisters, control.getRegisterCount());
+            }
+            controlStorage_.resize((blockProgram.controls.size() + 1) * SAMPLE_BLOCK_SIZE);
+            controlRegisters_.resize(controlRegisters * SAMPLE_BLOCK_SIZE);
+            comoments_ = ComomentStatistics(blockProgram.controls.size() + 1);
+        }
+        for (size_t k = 0; k < blockProgram.sampledSlots.size(); ++k) {
+            columns_[blockProgram.sampledSlots[k]] = columnStorage_.data() + k * SAMPLE_BLOCK_SIZE;
+        }
+        // A native kernel reads its variables in the tape's variable order,
+        // a fused kernel in its own
+        if (blockProgram.fused != nullptr) {
+            for (size_t slot : blockProgram.fusedSlots) {
+                kernelColumns_.push_back(slot == NO_SLOT ? nullptr : columns_[slot]);
+            }
+        } else if (blockProgram.kernel != nullptr) {
+            for (size_t slot : blockProgram.program.getVariableSlots()) {
+                kernelColumns_.push_back(columns_[slot]);
+            }
+        }
+    }
+    
+    /**
+     * @brief Column storage; the sample of variable k for row i goes to
+     *        columnData()[k * SAMPLE_BLOCK_SIZE + i]
+     */
+    double* columnData() { return columnStorage_.data(); }
+    
+    void evaluate(size_t count, double* out) {
+        if (blockProgram_.fused != nullptr) {
+            blockProgram_.fused->run(kernelColumns_.data(), count, out);
+        } else if (blockProgram_.kernel != nullptr) {
+            blockProgram_.kernel->run(kernelColumns_.data(), count, out);
+        } else {
+            blockProgram_.program.evaluateBatch(columns_.data(), count, out, registers_.data());
+        }
+    }
+    
+    /**
+     * @brief Evaluate the control variates on the current columns
+     * @return Control storage: control j in column j + 1, SAMPLE_BLOCK_SIZE
+     *         apart; column 0 is left for the target
+     */
+    double* evaluateControls(size_t count) {
+        const auto& controls = blockProgram_.controls;
+        for (size_t j = 0; j < controls.size(); ++j) {
+            controls[j].evaluateBatch(columns_.data(), count,
+                                      controlStorage_.data() + (j + 1) * SAMPLE_BLOCK_SIZE,
+                                      controlRegisters_.data());
+        }
+        return controlStorage_.data();
+    }
+    
+    /**
+     * @brief Scratch co-moments of one block of target and controls
+     */
+    ComomentStatistics& comoments() { return comoments_; }
+    
+private:
+    const BlockProgram& blockProgram_;
+    std::vector<double> columnStorage_;
+    std::vector<const double*> columns_;
+    std::vector<const double*> kernelColumns_;
+    std::vector<double> registers_;
+    std::vector<double> controlStorage_;
+    std::vector<double> controlRegisters_;
+    ComomentStatistics comoments_;
+};
+
+/**
+ * @brief Everything a run prepares before sampling
+ *
+ * Holds the expression's tape (and native kernel), the tapes
+ * of the control variates, the slots they sample, the record points and
+ * the result being filled. Under importance sampling, registry is a copy
+ * of the caller's with the proposals in place of the distributions, so all
+ * samplers draw from the proposals unchanged. Chunked runs
+ * additionally keep per-chunk statistics and the function that evaluates a
+ * chunk from its own stream. blockProgram refers to the plan's own members,
+ * so a plan is never copied or moved.
+ */
+struct RunPlan {
+    /**
+     * @brief Bind a lowered expression, lower its controls, and size all buffers
+     * @param source Expression lowered is compiled from; null if none
+     * @param lowered The unbound tape
+     * @param fused Kernel that evaluates blocks instead of the tape; may be null
+     * @throws std::out_of_range if the tape, the fused kernel or a control
+     *         references a variable missing from registry
+     */
+    RunPlan(std::shared_ptr<Expression> source,
+            CompiledExpression lowered,
+            const BlockKernel* fused,
+            const VariableRegistry& registry,
+            const std::vector<ControlVariate>& controls,
+            bool importanceSampling,
+            size_t numSamples,
+            std::vector<size_t> recordPoints,
+            bool nativeCodegen,
+            const NativeKernelOptions& nativeOptions,
+            bool compensatedSummation)
+        : proposals(importanceSampling ? std::make_shared<const VariableRegistry>(registry.withProposals())
+                                       : nullptr),
+          registry(proposals ? *proposals : registry),
+          source(std::move(source)),
+          program(std::move(lowered)),
+          optimizedControls(optimizeControls(controls)),
+          controlPrograms(compileControls(optimizedControls, registry)),
+          fused(fused),
+          fusedSlots(bindFused(fused, registry)),
+          sampledSlots(bindSlots(program, controlPrograms, fused, registry)),
+          // A kernel cannot call back into interpreted nodes
+          kernel(nativeCodegen && fused == nullptr && !program.hasInterpretedNodes()
+                     ? NativeKernel::load(program, nativeOptions) : nullptr),
+          blockProgram{program, kernel.get(), fused, fusedSlots, controlPrograms, sampledSlots,
+                       registry.getVariableCount()},
+          numSamples(numSamples),
+          recordPoints(std::move(recordPoints)),
+          compensatedSummation(compensatedSummation),
+          importanceSampling(importanceSampling) {
+        // All buffers are sized here so that sampling performs no heap
+        // allocations. Pinned workers move their chunks' pages next to
+        // themselves (see releaseSamplePages()).
+        result.samples.resize(numSamples);
+        result.totalSampleCount = numSamples;
+        result.convergenceHistory.reserve(this->recordPoints.size());
+        result.usedNativeKernel = kernel != nullptr;
+        result.partitionedStream = false;
+        if (importanceSampling) {
+            // registry here is the caller's, which knows the proposals
+            result.logWeights.resize(numSamples);
+            for (size_t k = 0; k < sampledSlots.size(); ++k) {
+                if (const Distribution* proposal = registry.getProposal(sampledSlots[k])) {
+                    weightedColumns.push_back({k, &registry.getDistribution(sampledSlots[k]), proposal});
+                }
+            }
+        }
+        if (!controls.empty()) {
+            for (const auto& control : controls) {
+                controlExpectations.push_back(control.expectation);
+            }
+            const size_t blockCount = (numSamples + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
+            controlTotal = ComomentReducer(controls.size() + 1, blockCount);
+        }
+    }
+    
+    RunPlan(const RunPlan&) = delete;
+    RunPlan& operator=(const RunPlan&) = delete;
+    
+    /**
+     * @brief A sampled column drawn from a proposal, with the densities of its
+     *        log-likelihood ratio
+     */
+    struct WeightedColumn {
+        size_t column;
+        const Distribution* target;
+        const Distribution* proposal;
+    };
+    
+    std::shared_ptr<const VariableRegistry> proposals;  // Importance sampling only
+    const VariableRegistry& registry;                   // What the samplers draw from
+    std::shared_ptr<Expression> source;  // Kept alive for interpreted nodes
+    CompiledExpression program;
+    std::vector<std::shared_ptr<Expression>> optimizedControls;  // Kept alive for interpreted nodes
+    std::vector<CompiledExpression> controlPrograms;
+    const BlockKernel* fused;
+    std::vector<size_t> fusedSlots;
+    std::vector<size_t> sampledSlots;
+    std::shared_ptr<NativeKernel> kernel;
+    BlockProgram blockProgram;
+    size_t numSamples;
+    std::vector<size_t> recordPoints;
+    bool compensatedSummation;
+    bool importanceSampling;
+    std::vector<WeightedColumn> weightedColumns;
+    size_t replicateCount = 0;  // Randomized replicates of a design; 0 = independent draws
+    bool antithetic = false;    // Odd samples mirror the draws of the even ones
+    std::vector<double> controlExpectations;
+    ComomentReducer controlTotal;  // Block co-moments of target and controls
+    SimulationResult result;
+    
+    // Chunked runs only: per chunk, the reduction of its blocks (and of their
+    // co-moments with controls) plus the record points that fall inside it,
+    // and the chunk evaluator
+    std::vector<PairwiseReducer> chunkReducers;
+    std::vector<ComomentReducer> chunkControls;
+    std::vector<std::vector<ChunkRecord>> chunkRecords;
+    std::function<void(size_t chunk, BlockWorkspace& workspace, std::vector<SamplerState>& states)> runChunk;
+    
+private:
+    // Simplify each control variate
+    static std::vector<std::shared_ptr<Expression>> optimizeControls(const std::vector<ControlVariate>& controls) {
+        std::vector<std::shared_ptr<Expression>> optimized;
+        for (const auto& control : controls) {
+            optimized.push_back(optimize(control.expression).expression);
+        }
+        return optimized;
+    }
+    
+    // Lower and bind each simplified control variate
+    static std::vector<CompiledExpression> compileControls(const std::vector<std::shared_ptr<Expression>>& controls,
+                                                           const VariableRegistry& registry) {
+        std::vector<CompiledExpression> programs;
+        programs.reserve(controls.size());
+        for (const auto& control : controls) {
+            programs.emplace_back(*control);
+            programs.back().bind(registry);
+        }
+        return programs;
+    }
+    
+    // Resolve each column of a fused kernel to its registry slot
+    static std::vector<size_t> bindFused(const BlockKernel* fused, const VariableRegistry& registry) {
+        std::vector<size_t> slots;
+        if (fused != nullptr) {
+            for (const auto& name : fused->variableNames) {
+                slots.push_back(name.empty() ? NO_SLOT : registry.getSlot(name));
+            }
+        }
+        return slots;
+    }
+    
+    // Resolve the tape's variables to registry slots; a missing variable is
+    // reported here rather than in the sampling loop. Only the variables the
+    // expression, its fused kernel and its controls reference are sampled
+    // (all of them if a tape has interpreted nodes), in slot order.
+    static std::vector<size_t> bindSlots(CompiledExpression& program,
+                                         const std::vector<CompiledExpression>& controls,
+                                         const BlockKernel* fused,
+                                         const VariableRegistry& registry) {
+        program.bind(registry);
+        std::set<std::string> names(program.getVariableNames().begin(), program.getVariableNames().end());
+        for (const auto& control : controls) {
+            names.insert(control.getVariableNames().begin(), control.getVariableNames().end());
+        }
+        if (fused != nullptr) {
+            for (const auto& name : fused->variableNames) {
+                if (!name.empty()) {
+                    names.insert(name);
+                }
+            }
+        }
+        std::vector<size_t> slots;
+        for (const auto& name : names) {
+            slots.push_back(registry.getSlot(name));
+        }
+        return slots;
+    }
+};
+
+/**
+ * @brief Rows of a block drawn from the stream: half of them, rounded up,
+ *        with antithetic pairs
+ */
+size_t drawnRows(const RunPlan& plan, size_t blockSize) {
+    return plan.antithetic ? (blockSize + 1) / 2 : blockSize;
+}
+
+/**
+ * @brief Turn a block's drawnRows() into antithetic pairs, in place
+ *
+ * Draw i moves to row 2i and its Distribution::antithetic() counterpart to
+ * row 2i + 1; an odd last row keeps its draw unpaired. Blocks start at even
+ * samples, so pairs are (2k, 2k + 1) over the whole run.
+ */
+void mirrorPairs(const RunPlan& plan, double* columnData, size_t blockSize) {
+    const size_t drawn = drawnRows(plan, blockSize);
+    double mirrored[SAMPLE_BLOCK_SIZE / 2 + 1];
+    for (size_t k = 0; k < plan.sampledSlots.size(); ++k) {
+        double* column = columnData + k * SAMPLE_BLOCK_SIZE;
+        plan.registry.getDistribution(plan.sampledSlots[k]).antithetic(column, mirrored, drawn);
+        // From the back, so no draw is overwritten before it moves
+        for (size_t i = drawn; i-- > 0;) {
+            column[2 * i] = column[i];
+            if (2 * i + 1 < blockSize) {
+                column[2 * i + 1] = mirrored[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Evaluate the control variates of an evaluated block and add the
+ *        block's co-moments to a reducer
+ *
+ * With antithetic pairs, the rows are the means of the block's complete
+ * pairs, as for the pair statistics in finishRun().
+ */
+void summarizeControls(const RunPlan& plan, BlockWorkspace& workspace, ComomentReducer& reducer,
+                       size_t blockSize, const double* blockValues) {
+    if (plan.controlPrograms.empty()) {
+        return;
+    }
+    double* columns = workspace.evaluateControls(blockSize);
+    std::copy(blockValues, blockValues + blockSize, columns);
+    size_t rows = blockSize;
+    if (plan.antithetic) {
+        rows = blockSize / 2;
+        for (size_t k = 0; k <= plan.controlPrograms.size(); ++k) {
+            double* column = columns + k * SAMPLE_BLOCK_SIZE;
+            for (size_t i = 0; i < rows; ++i) {
+                column[i] = 0.5 * (column[2 * i] + column[2 * i + 1]);
+            }
+        }
+    }
+    summarizeComoments(columns, SAMPLE_BLOCK_SIZE, rows, workspace.comoments());
+    reducer.add(workspace.comoments());
+}
+
+/**
+ * @brief Store the log-likelihood ratios of a block's samples under
+ *        importance sampling
+ */
+void weighSamples(RunPlan& plan, const double* columnData, size_t blockStart, size_t blockSize) {
+    if (!plan.importanceSampling) {
+        return;
+    }
+    double* logWeights = plan.result.logWeights.data() + blockStart;
+    std::fill(logWeights, logWeights + blockSize, 0.0);
+    double target[SAMPLE_BLOCK_SIZE];
+    double proposal[SAMPLE_BLOCK_SIZE];
+    for (const auto& weighted : plan.weightedColumns) {
+        const double* column = columnData + weighted.column * SAMPLE_BLOCK_SIZE;
+        weighted.target->logPdf(column, target, blockSize);
+        weighted.proposal->logPdf(column, proposal, blockSize);
+        for (size_t i = 0; i < blockSize; ++i) {
+            logWeights[i] += target[i] - proposal[i];
+        }
+    }
+}
+
+/**
+ * @brief Draw every sample from one stream on the calling thread
+ */
+SummaryStatistics runSequential(RunPlan& plan,
+                                std::mt19937& rng,
+                                std::vector<SamplerState>& samplerStates) {
+    const BlockProgram& blockProgram = plan.blockProgram;
+    const std::vector<size_t>& recordPoints = plan.recordPoints;
+    SimulationResult& result = plan.result;
+    BlockWorkspace workspace(blockProgram);
+    PairwiseReducer reducer;
+    auto record = recordPoints.begin();
+    auto onRecord = [&result](size_t point, const PairwiseReducer& prefix,
+                              const SummaryStatistics& partial) {
+        recordPoint(result, point, prefix, partial);
+    };
+    
+    // Generate all samples, one block at a time
+    for (size_t blockStart = 0; blockStart < plan.numSamples; blockStart += SAMPLE_BLOCK_SIZE) {
+        const size_t blockSize = std::min(SAMPLE_BLOCK_SIZE, plan.numSamples - blockStart);
+        const size_t drawn = drawnRows(plan, blockSize);
+        
+        // Draw variables sample by sample so the random stream is consumed in
+        // the same order as evaluating one sample at a time. With a single
+        // variable, filling its column with one block call is the same order.
+        if (blockProgram.sampledSlots.size() == 1) {
+            plan.registry.sampleColumns(rng, samplerStates, blockProgram.sampledSlots,
+                                        workspace.columnData(), SAMPLE_BLOCK_SIZE, drawn);
+        } else {
+            for (size_t i = 0; i < drawn; ++i) {
+                plan.registry.sampleSlots(rng, samplerStates, blockProgram.sampledSlots,
+                                          workspace.columnData() + i, SAMPLE_BLOCK_SIZE);
+            }
+        }
+        if (plan.antithetic) {
+            mirrorPairs(plan, workspace.columnData(), blockSize);
+        }
+        
+        double* blockValues = result.samples.data() + blockStart;
+        workspace.evaluate(blockSize, blockValues);
+        summarizeControls(plan, workspace, plan.controlTotal, blockSize, blockValues);
+        weighSamples(plan, workspace.columnData(), blockStart, blockSize);
+        reduceBlock(reducer, blockValues, blockStart, blockSize, record, recordPoints.end(),
+                    plan.compensatedSummation, onRecord);
+    }
+    return reducer.total();
+}
+
+/**
+ * @brief Give a plan fixed-size chunks whose variable columns are filled by
+ *        a per-chunk source
+ * @param makeFill Called as makeFill(chunk, states); returns the chunk's
+ *        fill(blockStart, blockSize, columnData), which writes column k of
+ *        the block for plan.sampledSlots[k]
+ */
+template <typename MakeFill>
+void setChunkBlocks(RunPlan& plan, MakeFill makeFill) {
+    const size_t chunkCount = (plan.numSamples + SAMPLE_CHUNK_SIZE - 1) / SAMPLE_CHUNK_SIZE;
+    // Reducers are constructed in place, not copied from one prototype: a
+    // copy does not keep the node capacity they reserve
+    plan.chunkReducers = std::vector<PairwiseReducer>(chunkCount);
+    plan.chunkControls.clear();
+    if (!plan.controlPrograms.empty()) {
+        plan.chunkControls.reserve(chunkCount);
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            plan.chunkControls.emplace_back(plan.controlPrograms.size() + 1,
+                                            SAMPLE_CHUNK_SIZE / SAMPLE_BLOCK_SIZE);
+        }
+    }
+    // One record per record point inside the chunk, each with its reducer's
+    // nodes reserved, so recording in the chunk only copies into them
+    plan.chunkRecords.resize(chunkCount);
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        const size_t chunkStart = chunk * SAMPLE_CHUNK_SIZE;
+        const size_t chunkEnd = std::min(chunkStart + SAMPLE_CHUNK_SIZE, plan.numSamples);
+        const auto first = std::lower_bound(plan.recordPoints.begin(), plan.recordPoints.end(), chunkStart + 1);
+        const auto last = std::upper_bound(first, plan.recordPoints.end(), chunkEnd);
+        plan.chunkRecords[chunk] = std::vector<ChunkRecord>(static_cast<size_t>(last - first));
+    }
+    plan.runChunk = [&plan, makeFill](size_t chunk, BlockWorkspace& workspace,
+                                      std::vector<SamplerState>& states) {
+        const std::vector<size_t>& recordPoints = plan.recordPoints;
+        const size_t chunkStart = chunk * SAMPLE_CHUNK_SIZE;
+        const size_t chunkEnd = std::min(chunkStart + SAMPLE_CHUNK_SIZE, plan.numSamples);
+        auto fill = makeFill(chunk, states);
+        
+        auto record = std::lower_bound(recordPoints.begin(), recordPoints.end(), chunkStart + 1);
+        PairwiseReducer& reducer = plan.chunkReducers[chunk];
+        ChunkRecord* nextRecord = plan.chunkRecords[chunk].data();
+        auto onRecord = [&nextRecord](size_t point, const PairwiseReducer& prefix,
+                                      const SummaryStatistics& partial) {
+            nextRecord->point = point;
+            nextRecord->prefix = prefix;
+            nextRecord->partial = partial;
+            ++nextRecord;
+        };
+        for (size_t blockStart = chunkStart; blockStart < chunkEnd; blockStart += SAMPLE_BLOCK_SIZE) {
+            const size_t blockSize = std::min(SAMPLE_BLOCK_SIZE, chunkEnd - blockStart);
+            fill(blockStart, blockSize, workspace.columnData());
+            
+            double* blockValues = plan.result.samples.data() + blockStart;
+            workspace.evaluate(blockSize, blockValues);
+            if (!plan.chunkControls.empty()) {
+                summarizeControls(plan, workspace, plan.chunkControls[chunk], blockSize, blockValues);
+            }
+            weighSamples(plan, workspace.columnData(), blockStart, blockSize);
+            reduceBlock(reducer, blockValues, blockStart, blockSize, record, recordPoints.end(),
+                        plan.compensatedSummation, onRecord);
+        }
+    };
+}
+
+/**
+ * @brief Give a plan fixed-size chunks, each evaluated from its own stream
+ * @param makeEngine Returns the engine of a chunk given its index
+ */
+template <typename MakeEngine>
+void setChunkStreams(RunPlan& plan, MakeEngine makeEngine) {
+    setChunkBlocks(plan, [&plan, makeEngine](size_t chunk, std::vector<SamplerState>& states) {
+        // The chunk's stream and sampler state depend only on the chunk
+        // index (and what makeEngine derives it from)
+        std::fill(states.begin(), states.end(), SamplerState());
+        return [&plan, &states, rng = makeEngine(static_cast<std::uint64_t>(chunk))](
+                   size_t, size_t blockSize, double* columnData) mutable {
+            // One block call per variable fills its whole column
+            const std::vector<size_t>& slots = plan.sampledSlots;
+            const size_t drawn = drawnRows(plan, blockSize);
+            for (size_t k = 0; k < slots.size(); ++k) {
+                plan.registry.getDistribution(slots[k]).sample(
+                    rng, states[k], columnData + k * SAMPLE_BLOCK_SIZE, drawn);
+            }
+            if (plan.antithetic) {
+                mirrorPairs(plan, columnData, blockSize);
+            }
+        };
+    });
+}
+
+/**
+ * @brief First sample of a replicate when numSamples are split into
+ *        replicates as evenly as possible (the first ones one larger)
+ */
+size_t replicateStart(size_t numSamples, size_t replicates, size_t replicate) {
+    return numSamples / replicates * replicate + std::min(replicate, numSamples % replicates);
+}
+
+/**
+ * @brief Replicate that a sample belongs to (see replicateStart())
+ */
+size_t replicateOf(size_t numSamples, size_t replicates, size_t sample) {
+    const size_t size = numSamples / replicates;
+    const size_t larger = numSamples % replicates;  // Replicates of size + 1
+    const size_t largeSamples = larger * (size + 1);
+    return sample < largeSamples ? sample / (size + 1) : larger + (sample - largeSamples) / size;
+}
+
+/**
+ * @brief Give a plan chunks of a randomized design, one per replicate
+ *
+ * The samples are split into plan.replicateCount replicates. Sample i of
+ * replicate r takes, for each referenced variable k, the design's uniform
+ * fillUniforms(i, count, replicateSize, k, seed of (r, k), out) and maps it
+ * through the variable's inverse CDF. Seeds derive from (seed, run), and
+ * uniforms are a function of their index alone, so chunks can run anywhere.
+ */
+template <typename FillUniforms>
+void setReplicatedChunks(RunPlan& plan, std::uint64_t seed, std::uint64_t run, FillUniforms fillUniforms) {
+    const size_t replicates = plan.replicateCount;
+    if (plan.numSamples > 0 && (plan.numSamples - 1) / replicates >= 0xffffffffu) {
+        throw std::invalid_argument("Replicates are limited to 2^32 - 1 samples");
+    }
+    auto seeds = std::make_shared<std::vector<std::uint32_t>>(replicates * plan.sampledSlots.size());
+    std::uint64_t state = seed ^ (run * 0xd1b54a32d192ed03ULL);
+    for (auto& value : *seeds) {
+        value = static_cast<std::uint32_t>(detail::splitmix64(state));
+    }
+    
+    setChunkBlocks(plan, [&plan, seeds, fillUniforms](size_t, std::vector<SamplerState>&) {
+        return [&plan, seeds, fillUniforms](size_t blockStart, size_t blockSize, double* columnData) {
+            const std::vector<size_t>& slots = plan.sampledSlots;
+            const size_t replicates = plan.replicateCount;
+            // A block may span replicates; fill it one replicate's run at a time
+            size_t row = 0;
+            while (row < blockSize) {
+                const size_t sample = blockStart + row;
+                const size_t replicate = replicateOf(plan.numSamples, replicates, sample);
+                const size_t first = replicateStart(plan.numSamples, replicates, replicate);
+                const size_t end = replicateStart(plan.numSamples, replicates, replicate + 1);
+                const size_t count = std::min(blockSize - row, end - sample);
+                for (size_t k = 0; k < slots.size(); ++k) {
+                    double* column = columnData + k * SAMPLE_BLOCK_SIZE + row;
+                    fillUniforms(sample - first, count, end - first, k,
+                                 (*seeds)[replicate * slots.size() + k], column);
+                    plan.registry.getDistribution(slots[k]).inverseCdf(column, column, count);
+                }
+                row += count;
+            }
+        };
+    });
+}
+
+/**
+ * @brief Give a plan chunks of scrambled Sobol points
+ *
+ * Replicate r uses the first points of the Sobol sequence, each dimension
+ * Owen-scrambled with its own seed.
+ */
+void setQuasiRandomChunks(RunPlan& plan, std::uint64_t seed, std::uint64_t run) {
+    auto sobol = std::make_shared<const SobolSequence>(plan.sampledSlots.size());
+    setReplicatedChunks(plan, seed, run, [sobol](size_t start, size_t count, size_t, size_t dimension,
+                                                 std::uint32_t scramble, double* out) {
+        std::uint32_t bits[SAMPLE_BLOCK_SIZE];
+        sobol->fill(start, count, dimension, bits);
+        for (size_t i = 0; i < count; ++i) {
+            // Midpoint of the 2^-32 cell keeps u inside (0, 1)
+            out[i] = (owenScramble(bits[i], scramble) + 0.5) * 0x1p-32;
+        }
+    });
+}
+
+/**
+ * @brief Give a plan chunks of Latin hypercube designs
+ *
+ * Each replicate is an independent design with one stratum per sample in
+ * every variable (see fillLatinHypercube()).
+ */
+void setLatinHypercubeChunks(RunPlan& plan, std::uint64_t seed, std::uint64_t run) {
+    setReplicatedChunks(plan, seed, run, [](size_t start, size_t count, size_t size, size_t,
+                                            std::uint32_t permutation, double* out) {
+        fillLatinHypercube(start, count, size, permutation, out);
+    });
+}
+
+/**
+ * @brief Split one jump-ahead engine into the chunk streams of a run
+ *
+ * Run r starts r long_jump()s after the seeded state and chunk c a further
+ * c jump()s in, so no two chunks of any run overlap.
+ */
+template <typename Engine>
+std::vector<Engine> makeJumpStreams(std::uint64_t seed, std::uint64_t run, size_t numSamples) {
+    const size_t chunkCount = (numSamples + SAMPLE_CHUNK_SIZE - 1) / SAMPLE_CHUNK_SIZE;
+    Engine engine(seed);
+    for (std::uint64_t r = 0; r < run; ++r) {
+        engine.long_jump();
+    }
+    std::vector<Engine> streams;
+    streams.reserve(chunkCount);
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        streams.push_back(engine);
+        engine.jump();
+    }
+    return streams;
+}
+
+/**
+ * @brief Select the chunk streams of run number run for an engine
+ */
+void assignChunkStreams(RunPlan& plan, RandomEngine engine, std::uint64_t seed, std::uint64_t run) {
+    if (engine == RandomEngine::Philox4x32) {
+        // Counter-based streams: chunk c of run r is stream (r << 32 | c)
+        setChunkStreams(plan, [seed, run](std::uint64_t chunk) {
+            return Philox4x32(seed, (run << 32) | chunk);
+        });
+    } else if (engine == RandomEngine::Xoshiro256PlusPlus) {
+        auto streams = makeJumpStreams<Xoshiro256PlusPlus>(seed, run, plan.numSamples);
+        setChunkStreams(plan, [streams](std::uint64_t chunk) { return streams[chunk]; });
+    } else if (engine == RandomEngine::Xoroshiro128Plus) {
+        auto streams = makeJumpStreams<Xoroshiro128Plus>(seed, run, plan.numSamples);
+        setChunkStreams(plan, [streams](std::uint64_t chunk) { return streams[chunk]; });
+    } else {
+        // Each chunk's mt19937 is seeded from the seed, the run and the chunk
+        setChunkStreams(plan, [seed, run](std::uint64_t chunk) {
+            // Same state as std::seed_seq of these words, without allocating
+            FixedSeedSequence<6> seeds({
+                static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                static_cast<std::uint32_t>(run), static_cast<std::uint32_t>(run >> 32),
+                static_cast<std::uint32_t>(chunk), static_cast<std::uint32_t>(chunk >> 32)});
+            return std::mt19937(seeds);
+        });
+    }
+}
+
+/**
+ * @brief Give a plan the chunks of run number run for a sampling method
+ *        and engine
+ */
+void assignChunkSources(RunPlan& plan, SamplingMethod method, RandomEngine engine,
+                        std::uint64_t seed, std::uint64_t run) {
+    if (method == SamplingMethod::QuasiMonteCarlo) {
+        setQuasiRandomChunks(plan, seed, run);
+    } else if (method == SamplingMethod::LatinHypercube) {
+        setLatinHypercubeChunks(plan, seed, run);
+    } else {
+        assignChunkStreams(plan, engine, seed, run);
+    }
+}
+
+/**
+ * @brief Append the chunks' reductions in chunk order and record the
+ *        convergence history
+ *
+ * Chunks are aligned subtrees of the block reduction, so the result is the
+ * one a single thread reducing every block in order would get, whichever
+ * thread ran which chunk. The chunks' control co-moments go to
+ * plan.controlTotal the same way.
+ */
+SummaryStatistics mergeChunks(RunPlan& plan) {
+    PairwiseReducer total;
+    for (size_t chunk = 0; chunk < plan.chunkReducers.size(); ++chunk) {
+        for (const ChunkRecord& local : plan.chunkRecords[chunk]) {
+            PairwiseReducer prefix = total;
+            prefix.append(local.prefix);
+            recordPoint(plan.result, local.point, prefix, local.partial);
+        }
+        total.append(plan.chunkReducers[chunk]);
+        if (!plan.chunkControls.empty()) {
+            plan.controlTotal.append(plan.chunkControls[chunk]);
+        }
+    }
+    return total.total();
+}
+
+/**
+ * @brief Release the pages of samples [begin, end) of the result buffers, so
+ *        that the calling worker places them on its own node as it writes them
+ */
+void releaseSamplePages(RunPlan& plan, size_t begin, size_t end) {
+    releasePages(plan.result.samples.data() + begin, end - begin);
+    if (!plan.result.logWeights.empty()) {
+        releasePages(plan.result.logWeights.data() + begin, end - begin);
+    }
+}
+
+/**
+ * @brief Pin the calling thread as worker number worker, if cpus is non-empty
+ */
+void pinWorker(std::optional<ScopedThreadPin>& pin, const std::vector<unsigned>& cpus, size_t worker) {
+    if (!cpus.empty()) {
+        pin.emplace(cpus[worker % cpus.size()]);
+    }
+}
+
+/**
+ * @brief Evaluate a plan's chunks on threadCount threads
+ * @param pinCpus CPUs to pin the workers to; empty leaves them unpinned
+ */
+SummaryStatistics runChunked(RunPlan& plan, size_t threadCount, const std::vector<unsigned>& pinCpus) {
+    const size_t chunkCount = plan.chunkReducers.size();
+    std::atomic<size_t> nextChunk{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    
+    auto worker = [&](size_t index) {
+        try {
+            // Pinned before the workspace is allocated, so that it is local too
+            std::optional<ScopedThreadPin> pin;
+            pinWorker(pin, pinCpus, index);
+            BlockWorkspace workspace(plan.blockProgram);
+            std::vector<SamplerState> states(plan.sampledSlots.size());
+            for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+                if (pin) {
+                    const size_t chunkStart = chunk * SAMPLE_CHUNK_SIZE;
+                    releaseSamplePages(plan, chunkStart, std::min(chunkStart + SAMPLE_CHUNK_SIZE, plan.numSamples));
+                }
+                plan.runChunk(chunk, workspace, states);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+    
+    const size_t workerCount = std::min(threadCount, chunkCount);
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workerCount; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);  // The calling thread works too
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return mergeChunks(plan);
+}
+
+/**
+ * @brief Reducer for a block's co-moments within a range of runPartitioned()
+ *
+ * A segment starting at block b holds at most the largest power of two
+ * dividing b (any number for block 0). Appending the segments in order
+ * then gives the reduction of adding every block one by one (see
+ * PairwiseReducer), wherever the ranges start.
+ */
+ComomentReducer& controlSegment(const RunPlan& plan, std::vector<ComomentReducer>& segments,
+                                size_t blockStart, size_t rangeEnd) {
+    const size_t block = blockStart / SAMPLE_BLOCK_SIZE;
+    if (!segments.empty()) {
+        // The current segment is full once it reaches the alignment of its start
+        const size_t blocks = segments.back().getBlockCount();
+        const size_t start = block - blocks;
+        if (start == 0 || blocks < (start & (~start + 1))) {
+            return segments.back();
+        }
+    }
+    const size_t remaining = (rangeEnd - blockStart + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
+    const size_t limit = block == 0 ? remaining : std::min(remaining, block & (~block + 1));
+    segments.emplace_back(plan.controlPrograms.size() + 1, limit);
+    return segments.back();
+}
+
+// Below this many samples per thread, jumping to the start of each range
+// costs more than drawing the range sequentially
+constexpr size_t PARTITION_MIN_SAMPLES = 1 << 18;
+
+/**
+ * @brief Split the sequential stream into one contiguous range per thread
+ *
+ * Only valid when every sample consumes exactly drawsPerSample outputs of
+ * rng: each range then starts from a copy of rng jumped past the ranges
+ * before it, and rng is left where runSequential() would leave it.
+ * Statistics are reduced afterwards block by block, so the result equals
+ * runSequential()'s bit for bit. Control co-moments are not stored per
+ * block; each range reduces them in segments that are aligned subtrees of
+ * the block reduction, which are appended in order afterwards.
+ */
+SummaryStatistics runPartitioned(RunPlan& plan,
+                                 std::mt19937& rng,
+                                 size_t drawsPerSample,
+                                 size_t rangeCount,
+                                 const std::vector<unsigned>& pinCpus) {
+    const size_t numSamples = plan.numSamples;
+    const size_t blockCount = (numSamples + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
+    const size_t rangeSize = (blockCount + rangeCount - 1) / rangeCount * SAMPLE_BLOCK_SIZE;
+    
+    std::mt19937 finalEngine;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::vector<std::vector<ComomentReducer>> rangeControls(rangeCount);
+    
+    auto worker = [&](size_t range) {
+        try {
+            std::optional<ScopedThreadPin> pin;
+            pinWorker(pin, pinCpus, range);
+            const size_t rangeStart = std::min(range * rangeSize, numSamples);
+            const size_t rangeEnd = std::min(rangeStart + rangeSize, numSamples);
+            if (pin) {
+                releaseSamplePages(plan, rangeStart, rangeEnd);
+            }
+            // Ranges start on block boundaries, so the draws before one are
+            // those of its first sample (halved with antithetic pairs)
+            std::mt19937 local = rng;
+            jumpAhead(local, static_cast<unsigned long long>(drawnRows(plan, rangeStart)) * drawsPerSample);
+            
+            BlockWorkspace workspace(plan.blockProgram);
+            std::vector<SamplerState> states = plan.registry.makeSamplerStates();
+            for (size_t blockStart = rangeStart; blockStart < rangeEnd; blockStart += SAMPLE_BLOCK_SIZE) {
+                const size_t blockSize = std::min(SAMPLE_BLOCK_SIZE, rangeEnd - blockStart);
+                double* columnData = workspace.columnData();
+                for (size_t i = 0; i < drawnRows(plan, blockSize); ++i) {
+                    plan.registry.sampleSlots(local, states, plan.sampledSlots,
+                                              columnData + i, SAMPLE_BLOCK_SIZE);
+                }
+                if (plan.antithetic) {
+                    mirrorPairs(plan, columnData, blockSize);
+                }
+                double* blockValues = plan.result.samples.data() + blockStart;
+                workspace.evaluate(blockSize, blockValues);
+                if (!plan.controlPrograms.empty()) {
+                    summarizeControls(plan, workspace,
+                                      controlSegment(plan, rangeControls[range], blockStart, rangeEnd),
+                                      blockSize, blockValues);
+                }
+                weighSamples(plan, columnData, blockStart, blockSize);
+            }
+            if (range == rangeCount - 1) {
+                finalEngine = local;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (size_t range = 1; range < rangeCount; ++range) {
+        threads.emplace_back(worker, range);
+    }
+    worker(0);  // The calling thread takes the first range
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    rng = finalEngine;
+    for (const auto& segments : rangeControls) {
+        for (const ComomentReducer& segment : segments) {
+            plan.controlTotal.append(segment);
+        }
+    }
+    
+    PairwiseReducer reducer;
+    auto record = plan.recordPoints.cbegin();
+    auto onRecord = [&plan](size_t point, const PairwiseReducer& prefix,
+                            const SummaryStatistics& partial) {
+        recordPoint(plan.result, point, prefix, partial);
+    };
+    for (size_t blockStart = 0; blockStart < numSamples; blockStart += SAMPLE_BLOCK_SIZE) {
+        const size_t blockSize = std::min(SAMPLE_BLOCK_SIZE, numSamples - blockStart);
+        reduceBlock(reducer, plan.result.samples.data() + blockStart, blockStart, blockSize,
+                    record, plan.recordPoints.cend(), plan.compensatedSummation, onRecord);
+    }
+    return reducer.total();
+}
+
+/**
+ * @brief Move the final statistics into the plan's result and return it
+ */
+SimulationResult finishRun(RunPlan& plan, const SummaryStatistics& total) {
+    SimulationResult& result = plan.result;
+    result.validSampleCount = total.count;
+    
+    // Compute final statistics
+    if (total.count == 0) {
+        // All samples were NaN
+        result.mean = std::numeric_limits<double>::quiet_NaN();
+        result.stddev = std::numeric_limits<double>::quiet_NaN();
+        result.min = std::numeric_limits<double>::quiet_NaN();
+        result.max = std::numeric_limits<double>::quiet_NaN();
+    } else {
+        result.mean = total.mean;
+        result.stddev = total.stddev();
+        result.min = total.min;
+        result.max = total.max;
+    }
+    
+    result.effectiveSampleSize = static_cast<double>(total.count);
+    
+    if (plan.replicateCount > 0) {
+        // Replicates are independent estimates of the mean; their spread is
+        // the error of the samples' mean
+        SummaryStatistics spread;
+        for (size_t r = 0; r < plan.replicateCount; ++r) {
+            const size_t start = replicateStart(plan.numSamples, plan.replicateCount, r);
+            const size_t end = replicateStart(plan.numSamples, plan.replicateCount, r + 1);
+            const SummaryStatistics stats = summarizeRange(result.samples.data() + start, end - start,
+                                                           plan.compensatedSummation);
+            const double mean = stats.count > 0 ? stats.mean : std::numeric_limits<double>::quiet_NaN();
+            result.replicateMeans.push_back(mean);
+            spread.merge(summarizeBlock(&mean, 1));
+        }
+        result.standardError = spread.count > 1 ? spread.stddev() / std::sqrt(static_cast<double>(spread.count))
+                                                : std::numeric_limits<double>::quiet_NaN();
+    } else {
+        result.standardError = total.count > 0 ? result.stddev / std::sqrt(static_cast<double>(total.count))
+                                               : std::numeric_limits<double>::quiet_NaN();
+    }
+    
+    result.pairCount = 0;
+    if (plan.antithetic) {
+        // A pair is one observation; its mean is NaN, and skipped, if either
+        // sample is NaN. Pairs never straddle a block.
+        PairwiseReducer pairs;
+        double pairMeans[SAMPLE_BLOCK_SIZE / 2];
+        for (size_t blockStart = 0; blockStart < plan.numSamples; blockStart += SAMPLE_BLOCK_SIZE) {
+            const double* values = result.samples.data() + blockStart;
+            const size_t pairCount = std::min(SAMPLE_BLOCK_SIZE, plan.numSamples - blockStart) / 2;
+            for (size_t i = 0; i < pairCount; ++i) {
+                pairMeans[i] = 0.5 * (values[2 * i] + values[2 * i + 1]);
+            }
+            pairs.add(summarizeBlock(pairMeans, pairCount, plan.compensatedSummation));
+        }
+        const SummaryStatistics stats = pairs.total();
+        result.pairCount = stats.count;
+        if (stats.count > 0) {
+            result.mean = stats.mean;
+            result.standardError = stats.stddev() / std::sqrt(static_cast<double>(stats.count));
+        } else {
+            result.mean = std::numeric_limits<double>::quiet_NaN();
+            result.standardError = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+    
+    if (!plan.controlPrograms.empty()) {
+        const ControlVariateEstimate estimate = estimateWithControls(plan.controlTotal.total(),
+                                                                     plan.controlExpectations);
+        result.mean = estimate.mean;
+        result.standardError = estimate.standardError;
+        result.controlCoefficients = estimate.coefficients;
+    }
+    
+    if (plan.importanceSampling) {
+        const WeightedSummary weighted = summarizeWeighted(result.samples.data(), result.logWeights.data(),
+                                                           plan.numSamples);
+        result.mean = weighted.mean;
+        result.stddev = std::sqrt(weighted.variance);
+        result.standardError = weighted.standardError;
+        result.effectiveSampleSize = weighted.effectiveSampleSize;
+    }
+    return std::move(result);
+}
+
+} // namespace
+
+std::vector<double> SimulationResult::quantiles(const std::vector<double>& probabilities) const {
+    return weightedQuantiles(samples.data(), logWeights.empty() ? nullptr : logWeights.data(),
+                             samples.size(), probabilities);
+}
+
+double SimulationResult::quantile(double probability) const {
+    return quantiles({probability}).front();
+}
+
+struct ChunkedEvaluation::State : RunPlan {
+    using RunPlan::RunPlan;
+};
+
+ChunkedEvaluation::ChunkedEvaluation(std::unique_ptr<State> state) : state_(std::move(state)) {}
+
+ChunkedEvaluation::ChunkedEvaluation(ChunkedEvaluation&&) noexcept = default;
+
+ChunkedEvaluation& ChunkedEvaluation::operator=(ChunkedEvaluation&&) noexcept = default;
+
+ChunkedEvaluation::~ChunkedEvaluation() = default;
+
+size_t ChunkedEvaluation::getChunkCount() const {
+    return state_->chunkReducers.size();
+}
+
+void ChunkedEvaluation::runChunk(size_t chunk) {
+    if (chunk >= getChunkCount()) {
+        throw std::out_of_range("Chunk index out of range");
+    }
+    BlockWorkspace workspace(state_->blockProgram);
+    std::vector<SamplerState> states(state_->sampledSlots.size());
+    state_->runChunk(chunk, workspace, states);
+}
+
+SimulationResult ChunkedEvaluation::finish() {
+    const SummaryStatistics total = mergeChunks(*state_);
+    return finishRun(*state_, total);
+}
+
 MonteCarloEvaluator::MonteCarloEvaluator(size_t numSamples, std::optional<unsigned> seed)
-    : numSamples_(numSamples) {
+    : numSamples_(numSamples), runCount_(0), threadCount_(0),
+      engine_(RandomEngine::Mt19937), partitionSequentialStream_(false),
+      compensatedSummation_(false), samplingMethod_(SamplingMethod::MonteCarlo),
+      replicateCount_(16), antitheticVariates_(false), importanceSampling_(false),
+      threadPinning_(false), nativeCodegen_(false) {
     if (seed.has_value()) {
-        rng_.seed(seed.value());
+        seed_ = seed.value();
     } else {
         std::random_device rd;
-        rng_.seed(rd());
+        seed_ = rd();
     }
+    rng_.seed(static_cast<std::mt19937::result_type>(seed_));
+}
+
+void MonteCarloEvaluator::setRandomEngine(RandomEngine engine) {
+    engine_ = engine;
+}
+
+void MonteCarloEvaluator::setPartitionSequentialStream(bool enabled) {
+    partitionSequentialStream_ = enabled;
+}
+
+void MonteCarloEvaluator::setCompensatedSummation(bool enabled) {
+    compensatedSummation_ = enabled;
+}
+
+void MonteCarloEvaluator::setSamplingMethod(SamplingMethod method) {
+    samplingMethod_ = method;
+}
+
+void MonteCarloEvaluator::setReplicateCount(size_t replicates) {
+    if (replicates == 0) {
+        throw std::invalid_argument("Replicate count must be positive");
+    }
+    replicateCount_ = replicates;
+}
+
+void MonteCarloEvaluator::setAntitheticVariates(bool enabled) {
+    antitheticVariates_ = enabled;
+}
+
+void MonteCarloEvaluator::addControlVariate(std::shared_ptr<Expression> control, double expectation) {
+    if (!control) {
+        throw std::invalid_argument("Control variate needs an expression");
+    }
+    if (!std::isfinite(expectation)) {
+        throw std::invalid_argument("Control variate expectation must be finite");
+    }
+    controlVariates_.push_back(ControlVariate{std::move(control), expectation});
+}
+
+void MonteCarloEvaluator::clearControlVariates() {
+    controlVariates_.clear();
+}
+
+const std::vector<ControlVariate>& MonteCarloEvaluator::checkControlVariates() const {
+    if (!controlVariates_.empty() && samplingMethod_ != SamplingMethod::MonteCarlo) {
+        throw std::invalid_argument("Control variates need SamplingMethod::MonteCarlo");
+    }
+    return controlVariates_;
+}
+
+void MonteCarloEvaluator::setImportanceSampling(bool enabled) {
+    importanceSampling_ = enabled;
+}
+
+bool MonteCarloEvaluator::checkImportanceSampling() const {
+    if (importanceSampling_ && samplingMethod_ != SamplingMethod::MonteCarlo) {
+        throw std::invalid_argument("Importance sampling needs SamplingMethod::MonteCarlo");
+    }
+    if (importanceSampling_ && (antitheticVariates_ || !controlVariates_.empty())) {
+        throw std::invalid_argument("Importance sampling cannot be combined with antithetic or control variates");
+    }
+    return importanceSampling_;
+}
+
+bool MonteCarloEvaluator::checkAntithetic() const {
+    if (antitheticVariates_ && samplingMethod_ != SamplingMethod::MonteCarlo) {
+        throw std::invalid_argument("Antithetic variates need SamplingMethod::MonteCarlo");
+    }
+    return antitheticVariates_;
+}
+
+void MonteCarloEvaluator::setThreadPinning(bool enabled) {
+    threadPinning_ = enabled;
+    pinCpus_ = enabled ? CpuTopology::detect().spreadOrder() : std::vector<unsigned>();
+}
+
+void MonteCarloEvaluator::setThreadCount(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threadCount_ = threadCount;
 }
 
 std::vector<size_t> MonteCarloEvaluator::computeSmartIntervals(size_t totalSamples) const {
@@ -39,17 +1295,11 @@ std::vector<size_t> MonteCarloEvaluator::computeSmartIntervals(size_t totalSampl
     return std::vector<size_t>(intervals.begin(), intervals.end());
 }
 
-SimulationResult MonteCarloEvaluator::evaluate(std::shared_ptr<Expression> expr,
-                                               const VariableRegistry& registry,
-                                               int convergenceInterval) {
-    SimulationResult result;
-    result.samples.reserve(numSamples_);
-    result.totalSampleCount = numSamples_;
-    
-    // Determine which sample counts to record
+std::vector<size_t> MonteCarloEvaluator::computeRecordPoints(int convergenceInterval) const {
     std::vector<size_t> recordPoints;
     if (convergenceInterval > 0) {
         // Fixed interval
+        recordPoints.reserve(numSamples_ / static_cast<size_t>(convergenceInterval) + 1);
         for (size_t i = static_cast<size_t>(convergenceInterval); i <= numSamples_; 
              i += static_cast<size_t>(convergenceInterval)) {
             recordPoints.push_back(i);
@@ -62,78 +1312,116 @@ SimulationResult MonteCarloEvaluator::evaluate(std::shared_ptr<Expression> expr,
         recordPoints = computeSmartIntervals(numSamples_);
     }
     // If convergenceInterval == 0, recordPoints remains empty (no tracking)
-    
-    // Welford's algorithm variables for online statistics
-    double runningMean = 0.0;
-    double runningM2 = 0.0;  // Sum of squared differences from mean
-    size_t validCount = 0;
-    size_t nextRecordIndex = 0;
-    
-    // Generate all samples
-    for (size_t i = 0; i < numSamples_; ++i) {
-        auto variables = registry.sampleAll(rng_);
-        double value = expr->evaluate(variables);
-        result.samples.push_back(value);
-        
-        // Update running statistics if value is valid
-        if (!std::isnan(value)) {
-            validCount++;
-            double delta = value - runningMean;
-            runningMean += delta / validCount;
-            double delta2 = value - runningMean;
-            runningM2 += delta * delta2;
-        }
-        
-        // Check if we should record at this point
-        size_t currentSampleCount = i + 1;
-        if (nextRecordIndex < recordPoints.size() && 
-            currentSampleCount == recordPoints[nextRecordIndex]) {
-            
-            ConvergencePoint point;
-            point.sampleCount = currentSampleCount;
-            point.validCount = validCount;
-            
-            if (validCount > 0) {
-                point.mean = runningMean;
-                point.stddev = validCount > 1 ? std::sqrt(runningM2 / (validCount - 1)) : 0.0;
-            } else {
-                point.mean = std::numeric_limits<double>::quiet_NaN();
-                point.stddev = std::numeric_limits<double>::quiet_NaN();
-            }
-            
-            result.convergenceHistory.push_back(point);
-            nextRecordIndex++;
-        }
+    return recordPoints;
+}
+
+std::vector<SamplerState>& MonteCarloEvaluator::samplerStatesFor(const VariableRegistry& registry) {
+    if (samplerStates_.size() < registry.getVariableCount()) {
+        samplerStates_.resize(registry.getVariableCount());
     }
+    return samplerStates_;
+}
+
+void MonteCarloEvaluator::setNativeCodegen(bool enabled, const NativeKernelOptions& options) {
+    nativeCodegen_ = enabled;
+    nativeOptions_ = options;
+}
+
+SimulationResult MonteCarloEvaluator::evaluate(std::shared_ptr<Expression> expr,
+                                               const VariableRegistry& registry,
+                                               int convergenceInterval) {
+    // Simplify and lower the tree once; each block of samples then runs the
+    // flat instruction tape, one tight loop per instruction
+    std::shared_ptr<Expression> optimized = optimize(expr).expression;
+    CompiledExpression program(*optimized);
+    return evaluateProgram(std::move(optimized), std::move(program), registry, convergenceInterval);
+}
+
+SimulationResult MonteCarloEvaluator::evaluate(const ExpressionGraph& graph,
+                                               ExpressionGraph::NodeId root,
+                                               const VariableRegistry& registry,
+                                               int convergenceInterval) {
+    // The graph is only read once to build the tape; sampling runs on the tape
+    return evaluateProgram(nullptr, CompiledExpression(graph, root), registry, convergenceInterval);
+}
+
+SimulationResult MonteCarloEvaluator::evaluateFused(std::shared_ptr<Expression> expr,
+                                                    const BlockKernel& kernel,
+                                                    const VariableRegistry& registry,
+                                                    int convergenceInterval) {
+    std::shared_ptr<Expression> optimized = optimize(expr).expression;
+    CompiledExpression program(*optimized);
+    return evaluateProgram(std::move(optimized), std::move(program), registry, convergenceInterval,
+                           &kernel);
+}
+
+SimulationResult MonteCarloEvaluator::evaluateProgram(std::shared_ptr<Expression> source,
+                                                      CompiledExpression program,
+                                                      const VariableRegistry& registry,
+                                                      int convergenceInterval,
+                                                      const BlockKernel* fused) {
+    // Size every buffer before sampling
+    RunPlan plan(std::move(source), std::move(program), fused, registry, checkControlVariates(),
+                 checkImportanceSampling(), numSamples_, computeRecordPoints(convergenceInterval),
+                 nativeCodegen_, nativeOptions_, compensatedSummation_);
     
-    result.validSampleCount = validCount;
+    plan.antithetic = checkAntithetic();
     
-    // Compute final statistics
-    if (validCount == 0) {
-        // All samples were NaN
-        result.mean = std::numeric_limits<double>::quiet_NaN();
-        result.stddev = std::numeric_limits<double>::quiet_NaN();
-        result.min = std::numeric_limits<double>::quiet_NaN();
-        result.max = std::numeric_limits<double>::quiet_NaN();
-    } else {
-        result.mean = runningMean;
-        result.stddev = validCount > 1 ? std::sqrt(runningM2 / (validCount - 1)) : 0.0;
-        
-        // Compute min and max from valid samples
-        std::vector<double> validSamples;
-        validSamples.reserve(validCount);
-        for (double sample : result.samples) {
-            if (!std::isnan(sample)) {
-                validSamples.push_back(sample);
-            }
+    SummaryStatistics total;
+    if (samplingMethod_ != SamplingMethod::MonteCarlo) {
+        // Quasi-random and Latin hypercube points depend only on their
+        // index, so they always run in chunks
+        plan.replicateCount = replicateCount_;
+        assignChunkSources(plan, samplingMethod_, engine_, seed_, runCount_++);
+        total = runChunked(plan, std::max<size_t>(threadCount_, 1),
+                           threadCount_ > 0 ? pinCpus_ : std::vector<unsigned>());
+    } else if (engine_ != RandomEngine::Mt19937) {
+        // Philox and xoshiro always run in chunks, so results are the same
+        // in sequential and parallel mode
+        assignChunkStreams(plan, engine_, seed_, runCount_++);
+        total = runChunked(plan, std::max<size_t>(threadCount_, 1),
+                           threadCount_ > 0 ? pinCpus_ : std::vector<unsigned>());
+    } else if (threadCount_ == 0) {
+        total = runSequential(plan, rng_, samplerStatesFor(registry));
+    } else if (partitionSequentialStream_) {
+        // The sequential stream can only be split where every sample uses a
+        // known number of outputs, and splitting only pays off for long ranges
+        size_t drawsPerSample = 0;
+        bool fixedDraws = true;
+        for (size_t slot : plan.sampledSlots) {
+            const size_t draws = plan.registry.getDistribution(slot).getFixedDrawCount();
+            fixedDraws = fixedDraws && draws > 0;
+            drawsPerSample += draws;
         }
-        
-        auto minmax = std::minmax_element(validSamples.begin(), validSamples.end());
-        result.min = *minmax.first;
-        result.max = *minmax.second;
+        const size_t rangeCount = std::min(threadCount_, numSamples_ / PARTITION_MIN_SAMPLES);
+        if (fixedDraws && rangeCount > 1) {
+            plan.result.partitionedStream = true;
+            total = runPartitioned(plan, rng_, drawsPerSample, rangeCount, pinCpus_);
+        } else {
+            total = runSequential(plan, rng_, samplerStatesFor(registry));
+        }
+    } else {
+        assignChunkStreams(plan, engine_, seed_, runCount_++);
+        total = runChunked(plan, threadCount_, pinCpus_);
     }
-    
-    return result;
+    return finishRun(plan, total);
+}
+
+ChunkedEvaluation MonteCarloEvaluator::prepareChunks(std::shared_ptr<Expression> expr,
+                                                     const VariableRegistry& registry,
+                                                     int convergenceInterval) {
+    std::shared_ptr<Expression> optimized = optimize(expr).expression;
+    CompiledExpression program(*optimized);
+    auto state = std::make_unique<ChunkedEvaluation::State>(
+        std::move(optimized), std::move(program), nullptr, registry, checkControlVariates(), checkImportanceSampling(), numSamples_,
+        computeRecordPoints(convergenceInterval), nativeCodegen_, nativeOptions_,
+        compensatedSummation_);
+    if (samplingMethod_ != SamplingMethod::MonteCarlo) {
+        state->replicateCount = replicateCount_;
+    }
+    state->antithetic = checkAntithetic();
+    assignChunkSources(*state, samplingMethod_, engine_, seed_, runCount_++);
+    return ChunkedEvaluation(std::move(state));
 }
 
 } // namespace tt_int
@@ -0,0 +1,296 @@
+#include "mt19937_jump.h"
+#include <array>
+#include <bitset>
+#include <sstream>
+#include <stdexcept>
+
+namespace tt_int {
+
+namespace {
+
+// Degree of the characteristic polynomial φ, and words of the state window
+constexpr size_t DEGREE = 19937;
+constexpr size_t STATE_WORDS = std::mt19937::state_size;
+constexpr size_t POLY_WORDS = (DEGREE + 1 + 63) / 64;  // Room for x^DEGREE
+
+// Jumps shorter than this are cheaper to apply with discard()
+constexpr unsigned long long DIRECT_DISCARD_LIMIT = 1ULL << 20;
+
+using Polynomial = std::vector<std::uint64_t>;  // Bit k is the coefficient of x^k
+
+bool testBit(const Polynomial& p, size_t bit) {
+    return (p[bit / 64] >> (bit % 64)) & 1;
+}
+
+// dst ^= src << shift; dst must be large enough to hold the result
+void xorShifted(Polynomial& dst, const Polynomial& src, size_t srcWords, size_t shift) {
+    const size_t wordShift = shift / 64;
+    const unsigned bitShift = shift % 64;
+    for (size_t i = 0; i < srcWords; ++i) {
+        dst[i + wordShift] ^= src[i] << bitShift;
+        if (bitShift != 0 && i + wordShift + 1 < dst.size()) {
+            dst[i + wordShift + 1] ^= src[i] >> (64 - bitShift);
+        }
+    }
+}
+
+// 64 bits of p starting at bit position, zero past the end
+std::uint64_t extractBits(const Polynomial& p, size_t position) {
+    const size_t word = position / 64;
+    const unsigned bit = position % 64;
+    std::uint64_t result = word < p.size() ? p[word] >> bit : 0;
+    if (bit != 0 && word + 1 < p.size()) {
+        result |= p[word + 1] << (64 - bit);
+    }
+    return result;
+}
+
+/**
+ * @brief φ, recovered once with Berlekamp-Massey from the low output bit
+ *
+ * φ is irreducible, so the minimal polynomial of any nonzero output bit
+ * sequence is φ itself and 2 * DEGREE bits determine it.
+ */
+const Polynomial& characteristicPolynomial() {
+    static const Polynomial phi = [] {
+        const size_t n = 2 * DEGREE + 64;
+        const size_t words = n / 64 + 2;
+
+        // reversed bit j is sequence bit n - 1 - j, so that the discrepancy
+        // sum over s[i - k] becomes a forward dot product
+        Polynomial reversed(words, 0);
+        std::mt19937 rng;
+        for (size_t i = 0; i < n; ++i) {
+            if (rng() & 1) {
+                const size_t j = n - 1 - i;
+                reversed[j / 64] |= std::uint64_t{1} << (j % 64);
+            }
+        }
+
+        Polynomial connection(words, 0);  // C(x), with s[i] = sum_k c_k s[i - k]
+        Polynomial previous(words, 0);    // B(x)
+        connection[0] = previous[0] = 1;
+        size_t length = 0;
+        size_t gap = 1;
+        for (size_t i = 0; i < n; ++i) {
+            std::uint64_t parity = 0;
+            for (size_t w = 0; w <= length / 64; ++w) {
+                parity ^= connection[w] & extractBits(reversed, n - 1 - i + 64 * w);
+            }
+            if (std::bitset<64>(parity).count() % 2 == 0) {
+                ++gap;
+            } else if (2 * length <= i) {
+                Polynomial saved = connection;
+                xorShifted(connection, previous, words - gap / 64 - 1, gap);
+                length = i + 1 - length;
+                previous = std::move(saved);
+                gap = 1;
+            } else {
+                xorShifted(connection, previous, words - gap / 64 - 1, gap);
+                ++gap;
+            }
+        }
+        if (length != DEGREE) {
+            throw std::logic_error("mt19937 characteristic polynomial has unexpected degree");
+        }
+
+        // φ is the reciprocal of the connection polynomial
+        Polynomial result(POLY_WORDS, 0);
+        for (size_t k = 0; k <= DEGREE; ++k) {
+            if (testBit(connection, DEGREE - k)) {
+                result[k / 64] |= std::uint64_t{1} << (k % 64);
+            }
+        }
+        return result;
+    }();
+    return phi;
+}
+
+// φ << s for s = 0..63, so that reduction only needs word-aligned XORs
+const std::vector<Polynomial>& shiftedPolynomials() {
+    static const std::vector<Polynomial> shifted = [] {
+        const Polynomial& phi = characteristicPolynomial();
+        std::vector<Polynomial> result(64, Polynomial(POLY_WORDS + 1, 0));
+        for (size_t shift = 0; shift < 64; ++shift) {
+            xorShifted(result[shift], phi, POLY_WORDS, shift);
+        }
+        return result;
+    }();
+    return shifted;
+}
+
+// Reduce p (of degree < 2 * DEGREE, in 2 * POLY_WORDS words) modulo φ,
+// leaving POLY_WORDS words
+void reduce(Polynomial& p) {
+    const std::vector<Polynomial>& shifted = shiftedPolynomials();
+    for (size_t bit = p.size() * 64; bit-- > DEGREE;) {
+        if (p[bit / 64] == 0) {
+            bit -= bit % 64;  // Skip the rest of an empty word
+            continue;
+        }
+        if (testBit(p, bit)) {
+            const size_t shift = bit - DEGREE;
+            const Polynomial& term = shifted[shift % 64];
+            std::uint64_t* target = p.data() + shift / 64;
+            for (size_t w = 0; w < term.size(); ++w) {
+                target[w] ^= term[w];
+            }
+        }
+    }
+    p.resize(POLY_WORDS);
+}
+
+// Spread the 32 bits of x to the even bit positions of the result
+std::uint64_t spreadBits(std::uint32_t x) {
+    std::uint64_t v = x;
+    v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+    v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+    v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    v = (v | (v << 2)) & 0x3333333333333333ULL;
+    v = (v | (v << 1)) & 0x5555555555555555ULL;
+    return v;
+}
+
+// p^2 mod φ; squaring over GF(2) just spreads the coefficients
+Polynomial squareMod(const Polynomial& p) {
+    Polynomial square(2 * POLY_WORDS, 0);
+    for (size_t w = 0; w < POLY_WORDS; ++w) {
+        square[2 * w] = spreadBits(static_cast<std::uint32_t>(p[w]));
+        square[2 * w + 1] = spreadBits(static_cast<std::uint32_t>(p[w] >> 32));
+    }
+    reduce(square);
+    return square;
+}
+
+// p * x mod φ
+void multiplyByX(Polynomial& p) {
+    for (size_t w = POLY_WORDS; w-- > 0;) {
+        p[w] = (p[w] << 1) | (w > 0 ? p[w - 1] >> 63 : 0);
+    }
+    if (testBit(p, DEGREE)) {
+        const Polynomial& phi = characteristicPolynomial();
+        for (size_t w = 0; w < POLY_WORDS; ++w) {
+            p[w] ^= phi[w];
+        }
+    }
+}
+
+/**
+ * @brief x^e mod φ by left-to-right square-and-multiply
+ * @param exponentBits Bits of e, most significant first
+ */
+Polynomial powerOfX(const std::vector<bool>& exponentBits) {
+    Polynomial result(POLY_WORDS, 0);
+    result[0] = 1;
+    for (bool bit : exponentBits) {
+        result = squareMod(result);
+        if (bit) {
+            multiplyByX(result);
+        }
+    }
+    return result;
+}
+
+std::vector<bool> bitsOf(unsigned long long value) {
+    std::vector<bool> bits;
+    for (int bit = 63; bit >= 0; --bit) {
+        bits.push_back((value >> bit) & 1);
+    }
+    return bits;
+}
+
+// Inverses of the xorshift steps of the Mersenne Twister tempering
+std::uint32_t undoRightShift(std::uint32_t y, unsigned shift) {
+    std::uint32_t x = y;
+    for (unsigned covered = shift; covered < 32; covered += shift) {
+        x = y ^ (x >> shift);
+    }
+    return x;
+}
+
+std::uint32_t undoLeftShift(std::uint32_t y, unsigned shift, std::uint32_t mask) {
+    std::uint32_t x = y;
+    for (unsigned covered = shift; covered < 32; covered += shift) {
+        x = y ^ ((x << shift) & mask);
+    }
+    return x;
+}
+
+std::uint32_t untemper(std::uint32_t y) {
+    y = undoRightShift(y, std::mt19937::tempering_l);
+    y = undoLeftShift(y, std::mt19937::tempering_t, std::mt19937::tempering_c);
+    y = undoLeftShift(y, std::mt19937::tempering_s, std::mt19937::tempering_b);
+    y = undoRightShift(y, std::mt19937::tempering_u);
+    return y;
+}
+
+} // namespace
+
+Mt19937Jump::Mt19937Jump(unsigned long long steps) {
+    if (steps < DIRECT_DISCARD_LIMIT) {
+        directSteps_ = steps;
+    } else {
+        // apply() itself moves 624 outputs further than the polynomial
+        polynomial_ = powerOfX(bitsOf(steps - STATE_WORDS));
+    }
+}
+
+Mt19937Jump Mt19937Jump::powerOfTwo(unsigned exponent) {
+    if (exponent < 64) {
+        return Mt19937Jump(1ULL << exponent);
+    }
+    // Bits of 2^exponent - 624: ones down to bit 10, then the bits of 1024 - 624
+    std::vector<bool> bits(exponent - 10, true);
+    for (int bit = 9; bit >= 0; --bit) {
+        bits.push_back(((1024 - STATE_WORDS) >> bit) & 1);
+    }
+    Mt19937Jump jump;
+    jump.polynomial_ = powerOfX(bits);
+    return jump;
+}
+
+void Mt19937Jump::apply(std::mt19937& rng) const {
+    if (polynomial_.empty()) {
+        rng.discard(directSteps_);
+        return;
+    }
+
+    // With W_k the window of 624 outputs starting k draws ahead, the window
+    // of g(T) is sum_k g_k W_k: the outputs n - 624 draws ahead. Untempered,
+    // those are the 624 state words that precede output n.
+    std::vector<std::uint32_t> outputs(DEGREE + STATE_WORDS - 1);
+    for (auto& output : outputs) {
+        output = static_cast<std::uint32_t>(rng());
+    }
+    std::array<std::uint32_t, STATE_WORDS> window{};
+    for (size_t k = 0; k < DEGREE; ++k) {
+        if (testBit(polynomial_, k)) {
+            const std::uint32_t* shifted = outputs.data() + k;
+            for (size_t j = 0; j < STATE_WORDS; ++j) {
+                window[j] ^= shifted[j];
+            }
+        }
+    }
+
+    // The textual state is the 624 words preceding the next output, oldest
+    // first; libstdc++ additionally stores its index into the word array
+    std::ostringstream state;
+    for (std::uint32_t word : window) {
+        state << untemper(word) << ' ';
+    }
+#ifdef __GLIBCXX__
+    state << STATE_WORDS;
+#endif
+    std::istringstream input(state.str());
+    input >> rng;
+}
+
+void jumpAhead(std::mt19937& rng, unsigned long long steps) {
+    Mt19937Jump(steps).apply(rng);
+}
+
+void jumpAheadPow2(std::mt19937& rng, unsigned exponent) {
+    Mt19937Jump::powerOfTwo(exponent).apply(rng);
+}
+
+} // namespace tt_int
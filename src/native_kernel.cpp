@@ -0,0 +1,366 @@
+#include "native_kernel.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "compiled_expression.h"
+
+#ifndef TT_INT_CXX_COMPILER
+#define TT_INT_CXX_COMPILER "c++"
+#endif
+
+namespace tt_int {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr const char* KERNEL_SYMBOL = "tt_int_kernel";
+
+// No contraction into FMAs and no fast-math, so results match the interpreter
+constexpr const char* COMPILE_FLAGS = "-std=c++17 -O3 -fPIC -shared -ffp-contract=off";
+
+/**
+ * @brief Spell a double so the compiler reads back exactly the same value
+ */
+std::string literal(double value) {
+    if (std::isnan(value)) {
+        return "__builtin_nan(\"\")";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "__builtin_inf()" : "(-__builtin_inf())";
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    return std::string("(") + buffer + ")";
+}
+
+const char* symbol(OpCode op) {
+    switch (op) {
+        case OpCode::Add:      return " + ";
+        case OpCode::Subtract: return " - ";
+        case OpCode::Multiply: return " * ";
+        default:               return " / ";
+    }
+}
+
+std::string getEnvironment(const char* name) {
+    const char* value = std::getenv(name);
+    return value != nullptr ? value : "";
+}
+
+// Owned by this user, a real directory (not a symlink) and closed to
+// everyone else, so nobody else can plant objects in it
+bool isPrivateDirectory(const fs::path& path) {
+    struct stat info;
+    return lstat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode) &&
+           info.st_uid == getuid() && (info.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+}
+
+/**
+ * @brief Cache directory under the world-writable temp directory
+ *
+ * A per-user directory shared by this user's processes if it can be
+ * trusted; if another user created that name first, or it is open to
+ * others, a fresh mkdtemp directory for this process instead
+ */
+fs::path privateTempDirectory() {
+    std::error_code error;
+    const fs::path temp = fs::temp_directory_path(error);
+    const fs::path shared = temp / ("tt_int-kernels-" + std::to_string(getuid()));
+    mkdir(shared.c_str(), 0700);  // Fails harmlessly if the name exists
+    if (isPrivateDirectory(shared)) {
+        return shared;
+    }
+    static std::mutex mutex;
+    static fs::path perProcess;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (perProcess.empty() || !isPrivateDirectory(perProcess)) {
+        std::string pattern = (temp / "tt_int-kernels-XXXXXX").string();
+        perProcess = mkdtemp(pattern.data()) != nullptr ? fs::path(pattern) : fs::path();
+    }
+    return perProcess;
+}
+
+fs::path defaultCacheDirectory() {
+    std::string explicitDirectory = getEnvironment("TT_INT_KERNEL_CACHE");
+    if (!explicitDirectory.empty()) {
+        return explicitDirectory;
+    }
+    std::string xdgCache = getEnvironment("XDG_CACHE_HOME");
+    if (!xdgCache.empty()) {
+        return fs::path(xdgCache) / "tt_int" / "kernels";
+    }
+    std::string home = getEnvironment("HOME");
+    if (!home.empty()) {
+        return fs::path(home) / ".cache" / "tt_int" / "kernels";
+    }
+    return privateTempDirectory();
+}
+
+// Single-quote for the POSIX shell
+std::string shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+bool readFile(const fs::path& path, std::string& contents) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+bool writeFile(const fs::path& path, const std::string& contents) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << contents;
+    return static_cast<bool>(out);
+}
+
+// 64-bit FNV-1a digest of the generated source
+uint64_t sourceDigest(const std::string& source) {
+    uint64_t digest = 0xcbf29ce484222325ULL;
+    for (unsigned char c : source) {
+        digest = (digest ^ c) * 0x100000001b3ULL;
+    }
+    return digest;
+}
+
+/**
+ * @brief Name of a build directory no other load() call uses, in this or
+ *        any other process
+ */
+std::string uniqueBuildName(const std::string& stem) {
+    static std::atomic<unsigned long> counter{0};
+    const size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return stem + "." + std::to_string(getpid()) + "." + std::to_string(thread) + "." +
+           std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+}
+
+// A cache entry directory holds the source and the object built from it
+bool holdsKernel(const fs::path& entry, const std::string& source) {
+    std::string cachedSource;
+    std::error_code error;
+    return readFile(entry / "kernel.cpp", cachedSource) && cachedSource == source &&
+           fs::exists(entry / "kernel.so", error);
+}
+
+// 64-bit FNV-1a over the instructions, constants and variable names
+size_t tapeHash(const CompiledExpression& program) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&](uint64_t word) {
+        for (int byte = 0; byte < 8; ++byte) {
+            hash = (hash ^ ((word >> (8 * byte)) & 0xff)) * 0x100000001b3ULL;
+        }
+    };
+    for (const Instruction& ins : program.getInstructions()) {
+        mix(static_cast<uint64_t>(ins.op));
+        mix(ins.dest);
+        mix(ins.lhs);
+        mix(ins.rhs);
+    }
+    for (double constant : program.getConstants()) {
+        uint64_t bits;
+        std::memcpy(&bits, &constant, sizeof(bits));
+        mix(bits);
+    }
+    for (const auto& name : program.getVariableNames()) {
+        mix(sourceDigest(name));
+    }
+    return static_cast<size_t>(hash);
+}
+
+/**
+ * @brief Emit the kernel for a tape
+ * @param hash Structural hash recorded in the header comment
+ */
+std::string emitSource(const CompiledExpression& program, size_t hash) {
+    // One SSA value per instruction; track which value each register holds
+    std::vector<std::string> registerValue(program.getRegisterCount());
+    std::ostringstream body;
+    const auto& code = program.getInstructions();
+    for (size_t k = 0; k < code.size(); ++k) {
+        const Instruction& ins = code[k];
+        std::string name = "t" + std::to_string(k);
+        body << "        const double " << name << " = ";
+        switch (ins.op) {
+            case OpCode::LoadConstant:
+                body << literal(program.getConstants()[ins.lhs]);
+                break;
+
+            case OpCode::LoadVariable:
+                body << "variables[" << ins.lhs << "][i]";
+                break;
+
+            case OpCode::Interpret:
+                throw std::invalid_argument("Native kernels cannot call interpreted expression nodes");
+
+            case OpCode::Divide:
+                // Same divide-by-zero semantics as BinaryOp::evaluate
+                body << registerValue[ins.rhs] << " == 0.0 ? __builtin_nan(\"\") : "
+                     << registerValue[ins.lhs] << " / " << registerValue[ins.rhs];
+                break;
+
+            default:
+                body << registerValue[ins.lhs] << symbol(ins.op) << registerValue[ins.rhs];
+                break;
+        }
+        body << ";\n";
+        registerValue[ins.dest] = name;
+    }
+
+    std::ostringstream source;
+    source << "// Generated by tt_int; structural hash " << hash << "\n"
+           << "#include <cstddef>\n\n"
+           << "extern \"C\" void " << KERNEL_SYMBOL
+           << "(const double* const* variables, std::size_t count, double* out) {\n"
+           << "    for (std::size_t i = 0; i < count; ++i) {\n"
+           << body.str()
+           << "        out[i] = t" << code.size() - 1 << ";\n"
+           << "    }\n"
+           << "}\n";
+    return source.str();
+}
+
+} // namespace
+
+NativeKernel::NativeKernel(void* handle, Function function, std::string libraryPath, bool fromCache)
+    : handle_(handle), function_(function), libraryPath_(std::move(libraryPath)), fromCache_(fromCache) {}
+
+NativeKernel::~NativeKernel() {
+    dlclose(handle_);
+}
+
+std::string NativeKernel::generateSource(const Expression& expr) {
+    return emitSource(CompiledExpression(expr), expr.hash());
+}
+
+std::string NativeKernel::generateSource(const CompiledExpression& program) {
+    return emitSource(program, tapeHash(program));
+}
+
+std::shared_ptr<NativeKernel> NativeKernel::load(const Expression& expr,
+                                                 const NativeKernelOptions& options) {
+    return loadSource(generateSource(expr), expr.hash(), options);
+}
+
+std::shared_ptr<NativeKernel> NativeKernel::load(const CompiledExpression& program,
+                                                 const NativeKernelOptions& options) {
+    const size_t hash = tapeHash(program);
+    return loadSource(emitSource(program, hash), hash, options);
+}
+
+std::shared_ptr<NativeKernel> NativeKernel::loadSource(const std::string& source, size_t hash,
+                                                       const NativeKernelOptions& options) {
+    fs::path directory = options.cacheDirectory.empty()
+        ? defaultCacheDirectory()
+        : fs::path(options.cacheDirectory);
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error) {
+        return nullptr;
+    }
+
+    // Content-addressed entry: the structural hash and a digest of the
+    // source, holding kernel.cpp and kernel.so. Entries are published by
+    // renaming a complete build directory, so source and object always
+    // belong together, and an entry never changes once it exists; dlopen,
+    // which returns an already loaded object with the same path, can then
+    // never hand back a different kernel
+    char stemText[64];
+    std::snprintf(stemText, sizeof(stemText), "kernel_%016zx_%016llx", hash,
+                  static_cast<unsigned long long>(sourceDigest(source)));
+    const std::string stem = stemText;
+    const fs::path entry = directory / stem;
+
+    // Reuse the cached object only if it was built from exactly this source
+    bool fromCache = holdsKernel(entry, source);
+    fs::path libraryPath = entry / "kernel.so";
+    fs::path buildDirectory;
+
+    if (!fromCache) {
+        // Build in a directory unique to this call, so concurrent threads and
+        // processes never write or load each other's partial objects
+        buildDirectory = directory / uniqueBuildName(stem);
+        const fs::path buildSource = buildDirectory / "kernel.cpp";
+        const fs::path buildLibrary = buildDirectory / "kernel.so";
+        const fs::path buildLog = buildDirectory / "kernel.log";
+        fs::create_directory(buildDirectory, error);
+        if (error || !writeFile(buildSource, source)) {
+            fs::remove_all(buildDirectory, error);
+            return nullptr;
+        }
+
+        std::string compiler = options.compiler;
+        if (compiler.empty()) {
+            compiler = getEnvironment("CXX");
+        }
+        if (compiler.empty()) {
+            compiler = TT_INT_CXX_COMPILER;
+        }
+        std::string command = shellQuote(compiler) + " " + COMPILE_FLAGS +
+                              " -o " + shellQuote(buildLibrary.string()) +
+                              " " + shellQuote(buildSource.string()) +
+                              " > " + shellQuote(buildLog.string()) + " 2>&1";
+        if (std::system(command.c_str()) != 0) {
+            fs::rename(buildLog, directory / (stem + ".log"), error);
+            fs::remove_all(buildDirectory, error);
+            return nullptr;
+        }
+        fs::remove(buildLog, error);
+
+        // Publish the pair; if another build got there first, use its entry
+        // when it holds this source, else (a digest collision) load this
+        // build from its own unique path
+        fs::rename(buildDirectory, entry, error);
+        if (!error || holdsKernel(entry, source)) {
+            fs::remove_all(buildDirectory, error);
+            buildDirectory.clear();
+        } else {
+            libraryPath = buildLibrary;
+        }
+    }
+
+    void* handle = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!buildDirectory.empty()) {
+        // An unpublished build stays mapped after its files are removed
+        std::error_code ignored;
+        fs::remove_all(buildDirectory, ignored);
+    }
+    if (handle == nullptr) {
+        return nullptr;
+    }
+    auto function = reinterpret_cast<Function>(dlsym(handle, KERNEL_SYMBOL));
+    if (function == nullptr) {
+        dlclose(handle);
+        return nullptr;
+    }
+    return std::shared_ptr<NativeKernel>(
+        new NativeKernel(handle, function, libraryPath.string(), fromCache));
+}
+
+} // namespace tt_int
@@ -0,0 +1,137 @@
+#include "pairwise_statistics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tt_int {
+
+namespace {
+
+// Neumaier's variant of Kahan summation: sum + compensation is the total
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void add(double value) {
+        const double t = sum + value;
+        if (std::abs(sum) >= std::abs(value)) {
+            compensation += (sum - t) + value;
+        } else {
+            compensation += (value - t) + sum;
+        }
+        sum = t;
+    }
+
+    double value() const { return sum + compensation; }
+};
+
+// Nodes ever held: one per bit of the block count
+constexpr size_t MAX_NODES = 64;
+
+} // namespace
+
+void SummaryStatistics::merge(const SummaryStatistics& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    const double n = static_cast<double>(count + other.count);
+    const double delta = other.mean - mean;
+    mean += delta * (static_cast<double>(other.count) / n);
+    m2 += other.m2 + delta * delta *
+          (static_cast<double>(count) * static_cast<double>(other.count) / n);
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+double SummaryStatistics::stddev() const {
+    return count > 1 ? std::sqrt(m2 / (count - 1)) : 0.0;
+}
+
+SummaryStatistics summarizeBlock(const double* values, size_t count, bool compensated) {
+    SummaryStatistics stats;
+    double sum = 0.0;
+    CompensatedSum compensatedSum;
+    for (size_t i = 0; i < count; ++i) {
+        const double value = values[i];
+        if (std::isnan(value)) {
+            continue;
+        }
+        stats.count++;
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+        if (compensated) {
+            compensatedSum.add(value);
+        } else {
+            sum += value;
+        }
+    }
+    if (stats.count == 0) {
+        return stats;
+    }
+    stats.mean = (compensated ? compensatedSum.value() : sum) / static_cast<double>(stats.count);
+
+    // Second pass: squared deviations from the block mean
+    double m2 = 0.0;
+    CompensatedSum compensatedM2;
+    for (size_t i = 0; i < count; ++i) {
+        const double value = values[i];
+        if (std::isnan(value)) {
+            continue;
+        }
+        const double delta = value - stats.mean;
+        if (compensated) {
+            compensatedM2.add(delta * delta);
+        } else {
+            m2 += delta * delta;
+        }
+    }
+    stats.m2 = compensated ? compensatedM2.value() : m2;
+    return stats;
+}
+
+PairwiseReducer::PairwiseReducer() {
+    // Reserved up front so adding blocks never allocates
+    nodes_.reserve(MAX_NODES);
+}
+
+void PairwiseReducer::add(const SummaryStatistics& block) {
+    push(Node{block, 1});
+}
+
+void PairwiseReducer::append(const PairwiseReducer& later) {
+    for (const Node& node : later.nodes_) {
+        push(node);
+    }
+}
+
+void PairwiseReducer::push(const Node& node) {
+    nodes_.push_back(node);
+    while (nodes_.size() >= 2 && nodes_[nodes_.size() - 2].blocks == nodes_.back().blocks) {
+        Node& left = nodes_[nodes_.size() - 2];
+        left.stats.merge(nodes_.back().stats);
+        left.blocks *= 2;
+        nodes_.pop_back();
+    }
+}
+
+SummaryStatistics PairwiseReducer::total() const {
+    SummaryStatistics result;
+    for (const Node& node : nodes_) {
+        result.merge(node.stats);
+    }
+    return result;
+}
+
+size_t PairwiseReducer::getBlockCount() const {
+    size_t blocks = 0;
+    for (const Node& node : nodes_) {
+        blocks += node.blocks;
+    }
+    return blocks;
+}
+
+} // namespace tt_int
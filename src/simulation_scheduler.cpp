@@ -0,0 +1,182 @@
+#include "simulation_scheduler.h"
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace tt_int {
+
+namespace {
+
+// Task::chunk of a job's preparation task
+constexpr size_t PREPARE = std::numeric_limits<size_t>::max();
+
+} // namespace
+
+struct SimulationScheduler::Job {
+    SimulationJob spec;
+    std::promise<SimulationResult> promise;
+    std::optional<ChunkedEvaluation> evaluation;
+    std::atomic<size_t> remainingChunks{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;  // First error of any chunk
+};
+
+SimulationScheduler::SimulationScheduler(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&SimulationScheduler::workerLoop, this, i);
+    }
+}
+
+SimulationScheduler::~SimulationScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+std::future<SimulationResult> SimulationScheduler::submit(SimulationJob job) {
+    if (!job.expression || !job.registry) {
+        throw std::invalid_argument("SimulationJob needs an expression and a registry");
+    }
+    auto state = std::make_shared<Job>();
+    state->spec = std::move(job);
+    std::future<SimulationResult> result = state->promise.get_future();
+    push(nextQueue_++ % queues_.size(), {Task{std::move(state), PREPARE}});
+    return result;
+}
+
+void SimulationScheduler::push(size_t worker, std::vector<Task> tasks) {
+    const size_t count = tasks.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[worker]->mutex);
+        for (Task& task : tasks) {
+            queues_[worker]->tasks.push_back(std::move(task));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queuedTasks_ += count;
+    }
+    if (count == 1) {
+        wakeUp_.notify_one();
+    } else {
+        wakeUp_.notify_all();
+    }
+}
+
+bool SimulationScheduler::takeTask(size_t worker, Task& task) {
+    bool found = false;
+    {
+        // Own deque first, oldest task first
+        std::lock_guard<std::mutex> lock(queues_[worker]->mutex);
+        auto& tasks = queues_[worker]->tasks;
+        if (!tasks.empty()) {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            found = true;
+        }
+    }
+    // Then steal the newest task of the next busy worker
+    for (size_t offset = 1; !found && offset < queues_.size(); ++offset) {
+        WorkerQueue& victim = *queues_[(worker + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            found = true;
+        }
+    }
+    if (found) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        --queuedTasks_;
+    }
+    return found;
+}
+
+void SimulationScheduler::workerLoop(size_t worker) {
+    for (;;) {
+        Task task;
+        if (takeTask(worker, task)) {
+            runTask(worker, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wakeUp_.wait(lock, [this] { return stopping_ || queuedTasks_ > 0; });
+        if (stopping_ && queuedTasks_ == 0) {
+            return;
+        }
+    }
+}
+
+void SimulationScheduler::runTask(size_t worker, const Task& task) {
+    Job& job = *task.job;
+    if (task.chunk == PREPARE) {
+        try {
+            // A fresh evaluator per job: its first run uses the chunk
+            // streams of (seed, run 0), as a standalone evaluation would
+            MonteCarloEvaluator evaluator(job.spec.numSamples, job.spec.seed);
+            evaluator.setRandomEngine(job.spec.engine);
+            evaluator.setCompensatedSummation(job.spec.compensatedSummation);
+            evaluator.setSamplingMethod(job.spec.samplingMethod);
+            evaluator.setReplicateCount(job.spec.replicateCount);
+            evaluator.setAntitheticVariates(job.spec.antitheticVariates);
+            for (const auto& control : job.spec.controlVariates) {
+                evaluator.addControlVariate(control.expression, control.expectation);
+            }
+            evaluator.setImportanceSampling(job.spec.importanceSampling);
+            job.evaluation.emplace(evaluator.prepareChunks(
+                job.spec.expression, *job.spec.registry, job.spec.convergenceInterval));
+        } catch (...) {
+            job.promise.set_exception(std::current_exception());
+            return;
+        }
+        const size_t chunkCount = job.evaluation->getChunkCount();
+        if (chunkCount == 0) {
+            job.promise.set_value(job.evaluation->finish());
+            return;
+        }
+        job.remainingChunks = chunkCount;
+        std::vector<Task> chunks;
+        chunks.reserve(chunkCount);
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            chunks.push_back(Task{task.job, chunk});
+        }
+        push(worker, std::move(chunks));
+        return;
+    }
+
+    try {
+        job.evaluation->runChunk(task.chunk);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(job.errorMutex);
+        if (!job.error) {
+            job.error = std::current_exception();
+        }
+    }
+    // The worker that completes the last chunk merges and publishes the result
+    if (--job.remainingChunks == 0) {
+        if (job.error) {
+            job.promise.set_exception(job.error);
+            return;
+        }
+        try {
+            job.promise.set_value(job.evaluation->finish());
+        } catch (...) {
+            job.promise.set_exception(std::current_exception());
+        }
+    }
+}
+
+} // namespace tt_int
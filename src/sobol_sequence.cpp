@@ -0,0 +1,158 @@
+#include "sobol_sequence.h"
+#include <stdexcept>
+#include <string>
+
+namespace tt_int {
+
+namespace {
+
+// Primitive polynomial of degree s with inner coefficients a, and its
+// initial direction numbers m_1..m_s, for dimensions 1 to 50
+struct DirectionSeed {
+    int degree;
+    std::uint32_t coefficients;
+    std::uint32_t initial[8];
+};
+
+constexpr DirectionSeed JOE_KUO[SobolSequence::MAX_DIMENSIONS - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7, 1, {1, 3, 7, 11, 23, 15, 103}},
+    {7, 4, {1, 3, 7, 13, 13, 15, 69}},
+    {7, 7, {1, 1, 3, 13, 7, 35, 63}},
+    {7, 8, {1, 3, 5, 9, 1, 25, 53}},
+    {7, 14, {1, 3, 1, 13, 9, 35, 107}},
+    {7, 19, {1, 3, 1, 5, 27, 61, 31}},
+    {7, 21, {1, 1, 5, 11, 19, 41, 61}},
+    {7, 28, {1, 3, 5, 3, 3, 13, 69}},
+    {7, 31, {1, 1, 7, 13, 1, 19, 1}},
+    {7, 32, {1, 3, 7, 5, 13, 19, 59}},
+    {7, 37, {1, 1, 3, 9, 25, 29, 41}},
+    {7, 41, {1, 3, 5, 13, 23, 1, 55}},
+    {7, 42, {1, 3, 7, 3, 13, 59, 17}},
+    {7, 50, {1, 3, 1, 3, 5, 53, 69}},
+    {7, 55, {1, 1, 5, 5, 23, 33, 13}},
+    {7, 56, {1, 1, 7, 7, 1, 61, 123}},
+    {7, 59, {1, 1, 7, 9, 13, 61, 49}},
+    {7, 62, {1, 3, 3, 5, 3, 55, 33}},
+    {8, 14, {1, 3, 1, 15, 31, 13, 49, 245}},
+    {8, 21, {1, 3, 5, 15, 31, 59, 63, 97}},
+    {8, 22, {1, 3, 1, 11, 11, 11, 77, 249}},
+    {8, 38, {1, 3, 1, 11, 27, 43, 71, 9}},
+    {8, 47, {1, 1, 7, 15, 21, 11, 81, 45}},
+    {8, 49, {1, 3, 7, 3, 25, 31, 65, 79}},
+    {8, 50, {1, 3, 1, 1, 19, 11, 3, 205}},
+    {8, 52, {1, 1, 5, 9, 19, 21, 29, 157}},
+    {8, 56, {1, 3, 7, 11, 1, 33, 89, 185}},
+    {8, 67, {1, 3, 3, 3, 15, 9, 79, 71}},
+    {8, 70, {1, 3, 7, 11, 15, 39, 119, 27}},
+    {8, 84, {1, 1, 3, 1, 11, 31, 97, 225}},
+    {8, 97, {1, 1, 1, 3, 23, 43, 57, 177}},
+    {8, 103, {1, 3, 7, 7, 17, 17, 37, 71}},
+};
+
+std::uint32_t reverseBits(std::uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+int countTrailingZeros(std::uint64_t x) {
+    int count = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+SobolSequence::SobolSequence(size_t dimensions)
+    : dimensions_(dimensions), directions_(dimensions * BITS) {
+    if (dimensions > MAX_DIMENSIONS) {
+        throw std::invalid_argument("Sobol sequence supports at most " +
+                                    std::to_string(MAX_DIMENSIONS) + " dimensions");
+    }
+    for (size_t d = 0; d < dimensions; ++d) {
+        std::uint32_t* v = directions_.data() + d * BITS;
+        if (d == 0) {
+            for (int k = 0; k < BITS; ++k) {
+                v[k] = 1u << (BITS - 1 - k);
+            }
+            continue;
+        }
+        const DirectionSeed& seed = JOE_KUO[d - 1];
+        const int s = seed.degree;
+        for (int k = 0; k < s; ++k) {
+            v[k] = seed.initial[k] << (BITS - 1 - k);
+        }
+        for (int k = s; k < BITS; ++k) {
+            v[k] = v[k - s] ^ (v[k - s] >> s);
+            for (int j = 1; j < s; ++j) {
+                if ((seed.coefficients >> (s - 1 - j)) & 1) {
+                    v[k] ^= v[k - j];
+                }
+            }
+        }
+    }
+}
+
+std::uint32_t SobolSequence::point(std::uint64_t index, size_t dimension) const {
+    const std::uint32_t* v = directions_.data() + dimension * BITS;
+    std::uint64_t gray = index ^ (index >> 1);
+    std::uint32_t x = 0;
+    for (int k = 0; gray != 0; ++k, gray >>= 1) {
+        if (gray & 1) {
+            x ^= v[k];
+        }
+    }
+    return x;
+}
+
+void SobolSequence::fill(std::uint64_t start, size_t count, size_t dimension, std::uint32_t* out) const {
+    if (count == 0) {
+        return;
+    }
+    const std::uint32_t* v = directions_.data() + dimension * BITS;
+    // Gray codes of n - 1 and n differ in bit ctz(n)
+    std::uint32_t x = point(start, dimension);
+    out[0] = x;
+    for (size_t i = 1; i < count; ++i) {
+        x ^= v[countTrailingZeros(start + i)];
+        out[i] = x;
+    }
+}
+
+std::uint32_t owenScramble(std::uint32_t value, std::uint32_t seed) {
+    // Laine-Karras style permutation on the reversed bits: adding the seed
+    // and XOR-ing with multiples by even constants only propagates changes
+    // from low to high bits, i.e. from high to low bits of the fraction
+    std::uint32_t x = reverseBits(value);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x);
+}
+
+} // namespace tt_int
@@ -0,0 +1,194 @@
+#include "thread_placement.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace tt_int {
+
+namespace {
+
+unsigned parseCpuNumber(const std::string& text, const std::string& list) {
+    if (text.empty() || !std::all_of(text.begin(), text.end(),
+                                     [](unsigned char c) { return std::isdigit(c); })) {
+        throw std::invalid_argument("Malformed CPU list: " + list);
+    }
+    return static_cast<unsigned>(std::stoul(text));
+}
+
+std::string trim(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t\n");
+    if (first == std::string::npos) {
+        return "";
+    }
+    return text.substr(first, text.find_last_not_of(" \t\n") - first + 1);
+}
+
+// CPUs of 0..hardware_concurrency() - 1, for platforms without a topology
+std::vector<unsigned> allCpus() {
+    std::vector<unsigned> cpus(std::max(1u, std::thread::hardware_concurrency()));
+    for (unsigned cpu = 0; cpu < cpus.size(); ++cpu) {
+        cpus[cpu] = cpu;
+    }
+    return cpus;
+}
+
+} // namespace
+
+std::vector<unsigned> parseCpuList(const std::string& list) {
+    std::vector<unsigned> cpus;
+    const std::string trimmed = trim(list);
+    size_t start = 0;
+    while (start < trimmed.size()) {
+        size_t end = trimmed.find(',', start);
+        if (end == std::string::npos) {
+            end = trimmed.size();
+        }
+        const std::string item = trim(trimmed.substr(start, end - start));
+        const size_t dash = item.find('-');
+        if (dash == std::string::npos) {
+            cpus.push_back(parseCpuNumber(item, list));
+        } else {
+            const unsigned first = parseCpuNumber(item.substr(0, dash), list);
+            const unsigned last = parseCpuNumber(item.substr(dash + 1), list);
+            if (last < first) {
+                throw std::invalid_argument("Malformed CPU list: " + list);
+            }
+            for (unsigned cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        start = end + 1;
+    }
+    return cpus;
+}
+
+CpuTopology::CpuTopology(std::vector<std::vector<unsigned>> nodes) {
+    for (auto& cpus : nodes) {
+        if (!cpus.empty()) {
+            nodes_.push_back(std::move(cpus));
+        }
+    }
+}
+
+CpuTopology CpuTopology::detect() {
+    std::vector<std::vector<unsigned>> nodes;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodeList;
+    if (online && std::getline(online, nodeList)) {
+        try {
+            for (unsigned node : parseCpuList(nodeList)) {
+                std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string cpuList;
+                std::vector<unsigned> cpus;
+                if (file && std::getline(file, cpuList)) {
+                    for (unsigned cpu : parseCpuList(cpuList)) {
+                        if (!haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                }
+                nodes.push_back(std::move(cpus));
+            }
+        } catch (const std::invalid_argument&) {
+            nodes.clear();
+        }
+    }
+    if (std::all_of(nodes.begin(), nodes.end(), [](const auto& cpus) { return cpus.empty(); })) {
+        nodes.clear();
+        if (haveMask) {
+            std::vector<unsigned> cpus;
+            for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed)) {
+                    cpus.push_back(cpu);
+                }
+            }
+            nodes.push_back(std::move(cpus));
+        }
+    }
+#endif
+    if (nodes.empty()) {
+        nodes.push_back(allCpus());
+    }
+    return CpuTopology(std::move(nodes));
+}
+
+std::vector<unsigned> CpuTopology::spreadOrder() const {
+    std::vector<unsigned> order;
+    for (size_t index = 0;; ++index) {
+        const size_t before = order.size();
+        for (const auto& cpus : nodes_) {
+            if (index < cpus.size()) {
+                order.push_back(cpus[index]);
+            }
+        }
+        if (order.size() == before) {
+            return order;
+        }
+    }
+}
+
+ScopedThreadPin::ScopedThreadPin(unsigned cpu) {
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE) {
+        return;
+    }
+    cpu_set_t previous;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) != 0) {
+        return;
+    }
+    cpu_set_t target;
+    CPU_ZERO(&target);
+    CPU_SET(cpu, &target);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(target), &target) == 0) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&previous);
+        previousMask_.assign(bytes, bytes + sizeof(previous));
+        pinned_ = true;
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+ScopedThreadPin::~ScopedThreadPin() {
+#ifdef __linux__
+    if (pinned_) {
+        cpu_set_t previous;
+        std::copy(previousMask_.begin(), previousMask_.end(), reinterpret_cast<unsigned char*>(&previous));
+        pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+    }
+#endif
+}
+
+void releasePages(double* data, size_t count) {
+#ifdef __linux__
+    static const std::uintptr_t pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(data);
+    const auto end = reinterpret_cast<std::uintptr_t>(data + count);
+    const std::uintptr_t first = (begin + pageSize - 1) / pageSize * pageSize;
+    const std::uintptr_t last = end / pageSize * pageSize;
+    if (first < last) {
+        // Private anonymous pages come back zero-filled on the next touch
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+    }
+#else
+    (void)data;
+    (void)count;
+#endif
+}
+
+} // namespace tt_int
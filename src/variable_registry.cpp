@@ -1,18 +1,61 @@
 #include "variable_registry.h"
+#include <iterator>
+#include <stdexcept>
+#include <utility>
 
 namespace tt_int {
 
 void VariableRegistry::registerVariable(const std::string& name,
                                        std::shared_ptr<Distribution> dist) {
     variables_[name] = dist;
+    proposals_.erase(name);
+    rebuildSlots();
 }
 
-std::map<std::string, double> VariableRegistry::sampleAll(std::mt19937& rng) const {
-    std::map<std::string, double> samples;
+void VariableRegistry::setProposal(const std::string& name, std::shared_ptr<Distribution> proposal) {
+    if (!hasVariable(name)) {
+        throw std::out_of_range("Variable '" + name + "' not found in variable registry");
+    }
+    if (proposal) {
+        proposals_[name] = std::move(proposal);
+    } else {
+        proposals_.erase(name);
+    }
+    rebuildSlots();
+}
+
+VariableRegistry VariableRegistry::withProposals() const {
+    VariableRegistry result;
+    result.variables_ = variables_;
+    for (const auto& pair : proposals_) {
+        result.variables_[pair.first] = pair.second;
+    }
+    result.rebuildSlots();
+    return result;
+}
+
+void VariableRegistry::rebuildSlots() {
+    // Rebuild the slot tables; registration happens at setup, not per sample
+    slots_.clear();
+    names_.clear();
+    proposalSlots_.clear();
+    slots_.reserve(variables_.size());
+    names_.reserve(variables_.size());
+    proposalSlots_.reserve(variables_.size());
     for (const auto& pair : variables_) {
-        samples[pair.first] = pair.second->sample(rng);
+        slots_.push_back(pair.second);
+        names_.push_back(pair.first);
+        auto proposal = proposals_.find(pair.first);
+        proposalSlots_.push_back(proposal != proposals_.end() ? proposal->second : nullptr);
+    }
+}
+
+size_t VariableRegistry::getSlot(const std::string& name) const {
+    auto it = variables_.find(name);
+    if (it == variables_.end()) {
+        throw std::out_of_range("Variable '" + name + "' not found in variable registry");
     }
-    return samples;
+    return static_cast<size_t>(std::distance(variables_.begin(), it));
 }
 
 bool VariableRegistry::hasVariable(const std::string& name) const {
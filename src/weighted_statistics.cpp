@@ -0,0 +1,152 @@
+#include "weighted_statistics.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace tt_int {
+
+namespace {
+
+// Rows summed directly before the partial sums enter the binary tree
+constexpr size_t SUM_BLOCK_SIZE = 512;
+
+/**
+ * @brief Sum N terms over rows: each block of rows sequentially, then the
+ *        block sums along a fixed binary tree
+ * @param terms Called as terms(row, sums) and adds the row's terms to sums
+ */
+template <size_t N, typename Terms>
+std::array<double, N> treeSums(size_t count, Terms terms) {
+    std::vector<std::array<double, N>> blocks((count + SUM_BLOCK_SIZE - 1) / SUM_BLOCK_SIZE);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        blocks[b].fill(0.0);
+        const size_t end = std::min(count, (b + 1) * SUM_BLOCK_SIZE);
+        for (size_t row = b * SUM_BLOCK_SIZE; row < end; ++row) {
+            terms(row, blocks[b]);
+        }
+    }
+    for (size_t width = 1; width < blocks.size(); width *= 2) {
+        for (size_t b = 0; b + width < blocks.size(); b += 2 * width) {
+            for (size_t k = 0; k < N; ++k) {
+                blocks[b][k] += blocks[b + width][k];
+            }
+        }
+    }
+    if (blocks.empty()) {
+        std::array<double, N> zero;
+        zero.fill(0.0);
+        return zero;
+    }
+    return blocks.front();
+}
+
+bool isUsable(const double* values, const double* logWeights, size_t row) {
+    return !std::isnan(values[row]) && (logWeights == nullptr || !std::isnan(logWeights[row]));
+}
+
+/**
+ * @brief Largest log weight of the usable rows; -infinity if there are none
+ */
+double maxLogWeight(const double* values, const double* logWeights, size_t count) {
+    double result = -std::numeric_limits<double>::infinity();
+    for (size_t row = 0; row < count; ++row) {
+        if (isUsable(values, logWeights, row)) {
+            result = std::max(result, logWeights == nullptr ? 0.0 : logWeights[row]);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+WeightedSummary summarizeWeighted(const double* values, const double* logWeights, size_t count) {
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+    WeightedSummary summary;
+    summary.mean = NaN;
+    summary.variance = NaN;
+    summary.standardError = NaN;
+    summary.effectiveSampleSize = 0.0;
+    for (size_t row = 0; row < count; ++row) {
+        summary.count += isUsable(values, logWeights, row) ? 1 : 0;
+    }
+    const double shift = maxLogWeight(values, logWeights, count);
+    if (!std::isfinite(shift)) {
+        return summary;
+    }
+
+    // First pass: sum(w), sum(w * y), sum(w^2)
+    const auto totals = treeSums<3>(count, [=](size_t row, std::array<double, 3>& sums) {
+        if (isUsable(values, logWeights, row)) {
+            const double weight = std::exp(logWeights[row] - shift);
+            sums[0] += weight;
+            sums[1] += weight * values[row];
+            sums[2] += weight * weight;
+        }
+    });
+    const double weightSum = totals[0];
+    const double mean = totals[1] / weightSum;
+
+    // Second pass: weighted squared deviations from the mean
+    const auto deviations = treeSums<2>(count, [=](size_t row, std::array<double, 2>& sums) {
+        if (isUsable(values, logWeights, row)) {
+            const double weight = std::exp(logWeights[row] - shift);
+            const double deviation = values[row] - mean;
+            sums[0] += weight * deviation * deviation;
+            sums[1] += weight * weight * deviation * deviation;
+        }
+    });
+
+    summary.mean = mean;
+    summary.effectiveSampleSize = weightSum * weightSum / totals[2];
+    const double reliability = weightSum - totals[2] / weightSum;
+    summary.variance = reliability > 0.0 ? deviations[0] / reliability : NaN;
+    // The ess / (ess - 1) factor makes equal weights give stddev / sqrt(n)
+    const double ess = summary.effectiveSampleSize;
+    summary.standardError = ess > 1.0 ? std::sqrt(deviations[1] * ess / (ess - 1.0)) / weightSum : NaN;
+    return summary;
+}
+
+std::vector<double> weightedQuantiles(const double* values, const double* logWeights, size_t count,
+                                      const std::vector<double>& probabilities) {
+    for (double p : probabilities) {
+        if (!(p >= 0.0 && p <= 1.0)) {
+            throw std::invalid_argument("Quantile probabilities must lie in [0, 1]");
+        }
+    }
+    std::vector<double> quantiles(probabilities.size(), std::numeric_limits<double>::quiet_NaN());
+    const double shift = maxLogWeight(values, logWeights, count);
+    if (!std::isfinite(shift)) {
+        return quantiles;
+    }
+    auto weightOf = [=](size_t row) {
+        return logWeights == nullptr ? 1.0 : std::exp(logWeights[row] - shift);
+    };
+
+    // Rows with a positive weight in ascending order of value, ties in row order
+    std::vector<size_t> order;
+    for (size_t row = 0; row < count; ++row) {
+        if (isUsable(values, logWeights, row) && weightOf(row) > 0.0) {
+            order.push_back(row);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [values](size_t a, size_t b) { return values[a] < values[b]; });
+    std::vector<double> cumulative(order.size());
+    double total = 0.0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        total += weightOf(order[i]);
+        cumulative[i] = total;
+    }
+
+    for (size_t q = 0; q < probabilities.size(); ++q) {
+        const double target = probabilities[q] * total;
+        const size_t i = static_cast<size_t>(
+            std::lower_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin());
+        quantiles[q] = values[order[std::min(i, order.size() - 1)]];
+    }
+    return quantiles;
+}
+
+} // namespace tt_int
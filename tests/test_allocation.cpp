@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include "distribution.h"
+#include "variable_registry.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+// Counting replacements for the global allocation functions. They apply to
+// the whole test binary, which is harmless: they only add a counter.
+namespace {
+std::atomic<size_t> allocationCount{0};
+std::atomic<size_t> otherThreadAllocationCount{0};  // Made off the test's own thread
+thread_local bool onTestThread = false;
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (!onTestThread) {
+        otherThreadAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+using namespace tt_int;
+
+namespace {
+
+// Number of heap allocations made by one evaluate() call
+size_t countEvaluateAllocations(std::shared_ptr<Expression> expr,
+                                const VariableRegistry& registry,
+                                size_t numSamples,
+                                int convergenceInterval) {
+    MonteCarloEvaluator evaluator(numSamples, 42);
+    size_t before = allocationCount.load();
+    auto result = evaluator.evaluate(expr, registry, convergenceInterval);
+    size_t after = allocationCount.load();
+    EXPECT_EQ(result.samples.size(), numSamples);
+    return after - before;
+}
+
+} // namespace
+
+TEST(AllocationTest, CounterSeesAllocations) {
+    size_t before = allocationCount.load();
+    auto value = std::make_shared<double>(1.0);
+    EXPECT_GT(allocationCount.load(), before);
+}
+
+// If the sampling loop allocated, the count would grow with the sample count
+TEST(AllocationTest, SamplingLoopIsAllocationFree) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    registry.registerVariable("cost", std::make_shared<NormalDistribution>(50.0, 5.0));
+    
+    auto price = ExpressionBuilder::variable("price");
+    auto quantity = ExpressionBuilder::variable("quantity");
+    auto cost = ExpressionBuilder::variable("cost");
+    auto expr = (price * quantity - cost) / quantity;
+    
+    size_t small = countEvaluateAllocations(expr.get(), registry, 1000, 0);
+    size_t large = countEvaluateAllocations(expr.get(), registry, 200000, 0);
+    EXPECT_EQ(small, large);
+}
+
+TEST(AllocationTest, ConvergenceTrackingIsAllocationFree) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x * x;
+    
+    size_t small = countEvaluateAllocations(expr.get(), registry, 1000, 100);
+    size_t large = countEvaluateAllocations(expr.get(), registry, 200000, 100);
+    EXPECT_EQ(small, large);
+}
+
+// Parallel workers allocate their scratch once; if chunks allocated (their
+// streams or convergence records), the count would grow with the chunk count
+TEST(AllocationTest, ParallelChunksAreAllocationFree) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = x * y + x;
+
+    onTestThread = true;
+    auto workerAllocations = [&](size_t numSamples) {
+        MonteCarloEvaluator evaluator(numSamples, 42);
+        evaluator.setThreadCount(3);
+        size_t before = otherThreadAllocationCount.load();
+        auto result = evaluator.evaluate(expr.get(), registry, 100);
+        EXPECT_EQ(result.samples.size(), numSamples);
+        return otherThreadAllocationCount.load() - before;
+    };
+    size_t small = workerAllocations(8 * 16384);
+    size_t large = workerAllocations(64 * 16384);
+    onTestThread = false;
+    EXPECT_EQ(small, large);
+}
+
+// The flat-array registry forms never allocate, with or without states
+TEST(AllocationTest, RegistryFlatSamplingIsAllocationFree) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto states = registry.makeSamplerStates();
+    const std::vector<size_t> slots = {1, 0};
+    std::mt19937 rng(42);
+    double values[2];
+    double columns[2 * 64];
+
+    size_t before = allocationCount.load();
+    for (int i = 0; i < 100; ++i) {
+        registry.sampleAll(rng, values);
+        registry.sampleAll(rng, states, values);
+        registry.sampleSlots(rng, slots, values);
+        registry.sampleColumns(rng, slots, columns, 64, 64);
+    }
+    EXPECT_EQ(allocationCount.load(), before);
+}
@@ -0,0 +1,376 @@
+#include <gtest/gtest.h>
+#include "compiled_expression.h"
+#include "expression_builder.h"
+#include "distribution.h"
+#include "variable_registry.h"
+#include "monte_carlo_evaluator.h"
+#include <cmath>
+#include <map>
+#include <random>
+
+using namespace tt_int;
+
+TEST(CompiledExpressionTest, Constant) {
+    CompiledExpression program(Constant(42.0));
+    EXPECT_EQ(program.evaluate({}), 42.0);
+    EXPECT_EQ(program.getInstructions().size(), 1);
+    EXPECT_EQ(program.getRegisterCount(), 1);
+}
+
+TEST(CompiledExpressionTest, Variable) {
+    CompiledExpression program(Variable("x"));
+    std::map<std::string, double> vars = {{"x", 5.0}};
+    EXPECT_EQ(program.evaluate(vars), 5.0);
+    ASSERT_EQ(program.getVariableNames().size(), 1);
+    EXPECT_EQ(program.getVariableNames()[0], "x");
+}
+
+TEST(CompiledExpressionTest, MissingVariableThrows) {
+    CompiledExpression program(Variable("missing"));
+    std::map<std::string, double> vars = {{"x", 1.0}};
+    EXPECT_THROW(program.evaluate(vars), std::out_of_range);
+}
+
+TEST(CompiledExpressionTest, MatchesTreeEvaluation) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto z = ExpressionBuilder::variable("z");
+    auto expr = (x + y) * z - x / y + 2.0 * (z - 1.5) / (y + 0.25);
+
+    CompiledExpression program(*expr.get());
+    std::map<std::string, double> vars = {{"x", 3.5}, {"y", -1.25}, {"z", 7.0}};
+    EXPECT_EQ(program.evaluate(vars), expr.get()->evaluate(vars));
+}
+
+TEST(CompiledExpressionTest, DivideByZeroIsNaN) {
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x / (x - x);
+
+    CompiledExpression program(*expr.get());
+    std::map<std::string, double> vars = {{"x", 4.0}};
+    EXPECT_TRUE(std::isnan(program.evaluate(vars)));
+}
+
+TEST(CompiledExpressionTest, PostOrderTape) {
+    // (x + 2) * y  =>  load x, load 2, add, load y, mul
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = (x + 2.0) * y;
+
+    CompiledExpression program(*expr.get());
+    const auto& code = program.getInstructions();
+    ASSERT_EQ(code.size(), 5);
+    EXPECT_EQ(code[0].op, OpCode::LoadVariable);
+    EXPECT_EQ(code[1].op, OpCode::LoadConstant);
+    EXPECT_EQ(code[2].op, OpCode::Add);
+    EXPECT_EQ(code[3].op, OpCode::LoadVariable);
+    EXPECT_EQ(code[4].op, OpCode::Multiply);
+}
+
+TEST(CompiledExpressionTest, VariablesDeduplicated) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = x * x + y * x;
+
+    CompiledExpression program(*expr.get());
+    ASSERT_EQ(program.getVariableNames().size(), 2);
+    EXPECT_EQ(program.getVariableNames()[0], "x");
+    EXPECT_EQ(program.getVariableNames()[1], "y");
+
+    double values[] = {3.0, 4.0};
+    std::vector<double> registers(program.getRegisterCount());
+    EXPECT_EQ(program.evaluate(values, registers.data()), 21.0);
+}
+
+TEST(CompiledExpressionTest, DeepChainReusesRegisters) {
+    // A long left-leaning chain needs only two live registers
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x;
+    for (int i = 0; i < 10000; ++i) {
+        expr = expr + 1.0;
+    }
+
+    CompiledExpression program(*expr.get());
+    EXPECT_EQ(program.getRegisterCount(), 2);
+
+    std::map<std::string, double> vars = {{"x", 0.5}};
+    EXPECT_EQ(program.evaluate(vars), 10000.5);
+}
+
+TEST(CompiledExpressionTest, NullNodeThrows) {
+    BinaryOp expr(std::make_shared<Constant>(1.0), nullptr, BinaryOperator::Add);
+    EXPECT_THROW(CompiledExpression program(expr), std::invalid_argument);
+}
+
+namespace {
+
+// A node type the tape has no opcode for: |x - y|
+class AbsoluteDifference : public Expression {
+public:
+    double evaluate(const std::map<std::string, double>& variables) const override {
+        return std::abs(variables.at("x") - variables.at("y"));
+    }
+    size_t hash() const override { return reinterpret_cast<size_t>(this); }
+    bool equals(const Expression& other) const override { return this == &other; }
+};
+
+} // namespace
+
+TEST(CompiledExpressionTest, UnknownNodeIsInterpreted) {
+    ExpressionBuilder custom(std::make_shared<AbsoluteDifference>());
+    auto expr = custom * ExpressionBuilder::variable("x") + 1.0;
+
+    CompiledExpression program(*expr.get());
+    EXPECT_TRUE(program.hasInterpretedNodes());
+    ASSERT_EQ(program.getVariableNames().size(), 1);
+
+    // Binding adds the registry variables the interpreted node may read
+    VariableRegistry registry;
+    registry.registerVariable("y", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    program.bind(registry);
+    ASSERT_EQ(program.getVariableNames().size(), 2);
+    EXPECT_EQ(program.getVariableNames()[0], "x");
+    EXPECT_EQ(program.getVariableNames()[1], "y");
+
+    std::map<std::string, double> vars = {{"x", 2.0}, {"y", 5.0}};
+    EXPECT_EQ(program.evaluate(vars), expr.get()->evaluate(vars));
+
+    const double xs[] = {2.0, -1.0, 0.25};
+    const double ys[] = {5.0, 4.0, 0.0};
+    const double* columns[] = {xs, ys};  // Registry slot order
+    double out[3];
+    std::vector<double> registers(program.getRegisterCount() * 3);
+    program.evaluateBatch(columns, 3, out, registers.data());
+    for (size_t i = 0; i < 3; ++i) {
+        std::map<std::string, double> sample = {{"x", xs[i]}, {"y", ys[i]}};
+        EXPECT_EQ(out[i], expr.get()->evaluate(sample));
+    }
+}
+
+TEST(CompiledExpressionTest, EvaluatorInterpretsUnknownNode) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 2.0));
+
+    ExpressionBuilder custom(std::make_shared<AbsoluteDifference>());
+    auto expr = custom + ExpressionBuilder::variable("x");
+
+    MonteCarloEvaluator evaluator(1000, 42);
+    auto result = evaluator.evaluate(expr.get(), registry);
+
+    VariableRegistry referenceRegistry;
+    referenceRegistry.registerVariable("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    referenceRegistry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 2.0));
+
+    std::mt19937 rng(42);
+    ASSERT_EQ(result.samples.size(), 1000);
+    for (double sample : result.samples) {
+        auto variables = referenceRegistry.sampleAll(rng);
+        EXPECT_EQ(sample, expr.get()->evaluate(variables));
+    }
+}
+
+// The evaluator runs the tape; samples must match walking the tree directly
+TEST(CompiledExpressionTest, EvaluatorMatchesTreeWalk) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<NormalDistribution>(3.0, 0.5));
+    registry.registerVariable("c", std::make_shared<UniformDistribution>(1.0, 2.0));
+
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto c = ExpressionBuilder::variable("c");
+    auto expr = (a + b) * c - a / b;
+
+    MonteCarloEvaluator evaluator(1000, 42);
+    auto result = evaluator.evaluate(expr.get(), registry);
+
+    VariableRegistry referenceRegistry;
+    referenceRegistry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    referenceRegistry.registerVariable("b", std::make_shared<NormalDistribution>(3.0, 0.5));
+    referenceRegistry.registerVariable("c", std::make_shared<UniformDistribution>(1.0, 2.0));
+
+    std::mt19937 rng(42);
+    auto states = referenceRegistry.makeSamplerStates();
+    ASSERT_EQ(result.samples.size(), 1000);
+    for (double sample : result.samples) {
+        auto variables = referenceRegistry.sampleAll(rng, states);
+        EXPECT_EQ(sample, expr.get()->evaluate(variables));
+    }
+}
+
+TEST(CompiledExpressionTest, BatchMatchesScalar) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = (x + y) * 3.0 - x / (y - 2.0) + y;
+
+    CompiledExpression program(*expr.get());
+    ASSERT_EQ(program.getVariableNames()[0], "x");
+
+    const size_t count = 37;
+    std::vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = 0.5 * static_cast<double>(i) - 4.0;
+        ys[i] = static_cast<double>(i % 5);  // y == 2 hits the divide-by-zero path
+    }
+    const double* columns[] = {xs.data(), ys.data()};
+    std::vector<double> registers(program.getRegisterCount() * count);
+    std::vector<double> out(count);
+    program.evaluateBatch(columns, count, out.data(), registers.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        std::map<std::string, double> vars = {{"x", xs[i]}, {"y", ys[i]}};
+        double expected = expr.get()->evaluate(vars);
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(out[i]));
+        } else {
+            EXPECT_EQ(out[i], expected);
+        }
+    }
+}
+
+TEST(CompiledExpressionTest, BatchSingleVariableAndConstant) {
+    const double xs[] = {1.0, 2.0, 3.0};
+    const double* columns[] = {xs};
+    double out[3];
+
+    CompiledExpression variableProgram(Variable("x"));
+    std::vector<double> registers(variableProgram.getRegisterCount() * 3);
+    variableProgram.evaluateBatch(columns, 3, out, registers.data());
+    EXPECT_EQ(out[0], 1.0);
+    EXPECT_EQ(out[2], 3.0);
+
+    CompiledExpression constantProgram(Constant(7.5));
+    registers.assign(constantProgram.getRegisterCount() * 3, 0.0);
+    constantProgram.evaluateBatch(nullptr, 3, out, registers.data());
+    EXPECT_EQ(out[0], 7.5);
+    EXPECT_EQ(out[2], 7.5);
+}
+
+TEST(CompiledExpressionTest, BindResolvesRegistrySlots) {
+    VariableRegistry registry;
+    registry.registerVariable("b", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("c", std::make_shared<NormalDistribution>(0.0, 1.0));
+
+    auto c = ExpressionBuilder::variable("c");
+    auto a = ExpressionBuilder::variable("a");
+    auto expr = c - a;
+
+    CompiledExpression program(*expr.get());
+    program.bind(registry);
+    ASSERT_EQ(program.getVariableSlots().size(), 2);
+    EXPECT_EQ(program.getVariableSlots()[0], 2);  // c
+    EXPECT_EQ(program.getVariableSlots()[1], 0);  // a
+
+    // Flat array in registry slot order: a, b, c
+    double values[] = {1.0, 100.0, 10.0};
+    std::vector<double> registers(program.getRegisterCount());
+    EXPECT_EQ(program.evaluate(values, registers.data()), 9.0);
+
+    // Map evaluation keeps working after binding
+    std::map<std::string, double> vars = {{"a", 1.0}, {"c", 10.0}};
+    EXPECT_EQ(program.evaluate(vars), 9.0);
+}
+
+TEST(CompiledExpressionTest, BindMissingVariableThrows) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+
+    auto expr = ExpressionBuilder::variable("x") + ExpressionBuilder::variable("y");
+    CompiledExpression program(*expr.get());
+    EXPECT_THROW(program.bind(registry), std::out_of_range);
+}
+
+TEST(CompiledExpressionTest, BatchReadsBoundColumns) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("b", std::make_shared<NormalDistribution>(0.0, 1.0));
+
+    CompiledExpression program(Variable("b"));
+    program.bind(registry);
+
+    const double bs[] = {4.0, 5.0};
+    const double* columns[] = {nullptr, bs};  // slot 0 is unreferenced
+    double out[2];
+    std::vector<double> registers(program.getRegisterCount() * 2);
+    program.evaluateBatch(columns, 2, out, registers.data());
+    EXPECT_EQ(out[0], 4.0);
+    EXPECT_EQ(out[1], 5.0);
+}
+
+TEST(CompiledExpressionTest, SharedSubtreeEmittedOnce) {
+    // t = (x + y); t * t - t  =>  load x, load y, add, mul, sub
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto t = x + y;
+    auto expr = t * t - t;
+
+    CompiledExpression program(*expr.get());
+    const auto& code = program.getInstructions();
+    ASSERT_EQ(code.size(), 5);
+    EXPECT_EQ(code[2].op, OpCode::Add);
+    EXPECT_EQ(code[3].op, OpCode::Multiply);
+    EXPECT_EQ(code[3].lhs, code[3].rhs);
+    EXPECT_EQ(code[4].op, OpCode::Subtract);
+    EXPECT_EQ(code[4].rhs, code[2].dest);
+
+    std::map<std::string, double> vars = {{"x", 2.0}, {"y", 1.5}};
+    EXPECT_EQ(program.evaluate(vars), expr.get()->evaluate(vars));
+
+    const double xs[] = {2.0, -1.0, 0.25};
+    const double ys[] = {1.5, 4.0, 0.0};
+    const double* columns[] = {xs, ys};
+    double out[3];
+    std::vector<double> registers(program.getRegisterCount() * 3);
+    program.evaluateBatch(columns, 3, out, registers.data());
+    for (size_t i = 0; i < 3; ++i) {
+        std::map<std::string, double> sample = {{"x", xs[i]}, {"y", ys[i]}};
+        EXPECT_EQ(out[i], expr.get()->evaluate(sample));
+    }
+}
+
+TEST(CompiledExpressionTest, LowersGraphDirectly) {
+    ExpressionGraph graph;
+    auto x = GraphExpressionBuilder::variable(graph, "x");
+    auto y = GraphExpressionBuilder::variable(graph, "y");
+    auto unused = x * 100.0;
+    auto shared = x - y;
+    auto expr = shared * shared / (y + 2.0);
+    (void)unused;
+
+    CompiledExpression program(graph, expr.getId());
+    // x, y, x - y, 2, y + 2, product, quotient; the unused nodes are skipped
+    EXPECT_EQ(program.getInstructions().size(), 7);
+    ASSERT_EQ(program.getVariableNames().size(), 2);
+    EXPECT_EQ(program.getVariableNames()[0], "x");
+
+    for (double yValue : {-2.0, 0.5, 3.0}) {
+        std::map<std::string, double> vars = {{"x", 1.25}, {"y", yValue}};
+        double expected = graph.evaluate(expr.getId(), vars);
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(program.evaluate(vars)));
+        } else {
+            EXPECT_EQ(program.evaluate(vars), expected);
+        }
+    }
+
+    EXPECT_THROW(CompiledExpression(graph, static_cast<ExpressionGraph::NodeId>(graph.size())),
+                 std::invalid_argument);
+}
+
+TEST(CompiledExpressionTest, SharedChainReusesRegisters) {
+    // Repeated squaring through a shared node: t = t * t
+    auto expr = ExpressionBuilder::variable("x");
+    for (int i = 0; i < 1000; ++i) {
+        expr = expr * expr;
+    }
+
+    CompiledExpression program(*expr.get());
+    EXPECT_EQ(program.getInstructions().size(), 1001);
+    EXPECT_EQ(program.getRegisterCount(), 1);
+
+    std::map<std::string, double> vars = {{"x", 1.0}};
+    EXPECT_EQ(program.evaluate(vars), 1.0);
+}
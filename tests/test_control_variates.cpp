@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include "control_variates.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include "simulation_scheduler.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace tt_int;
+
+namespace {
+
+// Column-major block: target in column 0, controls after it
+std::vector<double> makeColumns(size_t rows, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> normal(10.0, 2.0);
+    std::vector<double> columns(3 * rows);
+    for (size_t i = 0; i < rows; ++i) {
+        const double c1 = normal(rng);
+        const double c2 = normal(rng);
+        columns[rows + i] = c1;
+        columns[2 * rows + i] = c2;
+        columns[i] = 2.0 + 3.0 * c1 - c2 + 0.5 * normal(rng);  // Noise of mean 5, sd 1
+    }
+    return columns;
+}
+
+// E[price * quantity] = 1500 with price ~ N(100, 15) and quantity ~ U(10, 20);
+// the controls are the price and the quantity
+ExpressionBuilder revenue() {
+    return ExpressionBuilder::variable("price") * ExpressionBuilder::variable("quantity");
+}
+
+void addLinearControls(MonteCarloEvaluator& evaluator) {
+    evaluator.addControlVariate(ExpressionBuilder::variable("price").get(), 100.0);
+    evaluator.addControlVariate(ExpressionBuilder::variable("quantity").get(), 15.0);
+}
+
+} // namespace
+
+TEST(ControlVariatesTest, MergeMatchesWholeBlock) {
+    const size_t rows = 1000;
+    std::vector<double> columns = makeColumns(rows, 7);
+    columns[2 * rows + 10] = NAN;  // Drops row 10 in every column
+
+    ComomentStatistics whole(3);
+    summarizeComoments(columns.data(), rows, rows, whole);
+    EXPECT_EQ(whole.count, rows - 1);
+
+    ComomentStatistics first(3);
+    ComomentStatistics second(3);
+    summarizeComoments(columns.data(), rows, 300, first);
+    summarizeComoments(columns.data() + 300, rows, rows - 300, second);
+    first.merge(second);
+    EXPECT_EQ(first.count, whole.count);
+    for (size_t k = 0; k < 3; ++k) {
+        EXPECT_NEAR(first.mean[k], whole.mean[k], 1e-12);
+    }
+    for (size_t k = 0; k < 9; ++k) {
+        EXPECT_NEAR(first.comoment[k], whole.comoment[k], 1e-9 * std::abs(whole.comoment[k]));
+    }
+    EXPECT_EQ(whole.comoment[1], whole.comoment[3]);  // Symmetric
+}
+
+TEST(ControlVariatesTest, ReducerAppendsAlignedRuns) {
+    const size_t rows = 64;
+    const size_t blocks = 45;
+    std::vector<double> columns = makeColumns(rows * blocks, 5);
+    std::vector<ComomentStatistics> stats(blocks, ComomentStatistics(3));
+    for (size_t b = 0; b < blocks; ++b) {
+        summarizeComoments(columns.data() + b * rows, rows * blocks, rows, stats[b]);
+    }
+
+    ComomentReducer whole(3, blocks);
+    for (const auto& block : stats) {
+        whole.add(block);
+    }
+    EXPECT_EQ(whole.getBlockCount(), blocks);
+
+    // Runs of 8 blocks, as chunks are appended, and then runs starting at
+    // 40 (8 blocks aligned), 44 and 45, as partitioned ranges are
+    ComomentReducer appended(3);
+    auto appendRun = [&](size_t begin, size_t end) {
+        ComomentReducer run(3, end - begin);
+        for (size_t b = begin; b < end; ++b) {
+            run.add(stats[b]);
+        }
+        appended.append(run);
+    };
+    for (size_t begin = 0; begin < 40; begin += 8) {
+        appendRun(begin, begin + 8);
+    }
+    appendRun(40, 44);
+    appendRun(44, 45);
+
+    const ComomentStatistics expected = whole.total();
+    const ComomentStatistics actual = appended.total();
+    EXPECT_EQ(actual.count, rows * blocks);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.comoment, expected.comoment);
+    EXPECT_EQ(ComomentReducer(3).total().count, 0);
+}
+
+TEST(ControlVariatesTest, RecoversLinearRelation) {
+    const size_t rows = 20000;
+    std::vector<double> columns = makeColumns(rows, 11);
+    ComomentStatistics stats(3);
+    summarizeComoments(columns.data(), rows, rows, stats);
+
+    ControlVariateEstimate estimate = estimateWithControls(stats, {10.0, 10.0});
+    ASSERT_EQ(estimate.coefficients.size(), 2);
+    EXPECT_NEAR(estimate.coefficients[0], 3.0, 0.02);
+    EXPECT_NEAR(estimate.coefficients[1], -1.0, 0.02);
+    // Only the noise is left
+    EXPECT_NEAR(estimate.standardError, 1.0 / std::sqrt(static_cast<double>(rows)), 1e-4);
+    EXPECT_NEAR(estimate.mean, 27.0, 5.0 * estimate.standardError);
+}
+
+TEST(ControlVariatesTest, DependentControlsGetZeroCoefficient) {
+    const size_t rows = 1000;
+    std::vector<double> columns(4 * rows);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < rows; ++i) {
+        const double c = uniform(rng);
+        columns[i] = 4.0 * c + 1.0;  // Target is exactly linear in c
+        columns[rows + i] = c;
+        columns[2 * rows + i] = 2.0 * c;  // Repeats the first control
+        columns[3 * rows + i] = 5.0;      // Constant
+    }
+    ComomentStatistics stats(4);
+    summarizeComoments(columns.data(), rows, rows, stats);
+
+    ControlVariateEstimate estimate = estimateWithControls(stats, {0.5, 1.0, 5.0});
+    EXPECT_NEAR(estimate.coefficients[0], 4.0, 1e-9);
+    EXPECT_EQ(estimate.coefficients[1], 0.0);
+    EXPECT_EQ(estimate.coefficients[2], 0.0);
+    EXPECT_NEAR(estimate.mean, 3.0, 1e-9);
+    EXPECT_NEAR(estimate.standardError, 0.0, 1e-9);
+
+    ControlVariateEstimate empty = estimateWithControls(ComomentStatistics(4), {0.5, 1.0, 5.0});
+    EXPECT_TRUE(std::isnan(empty.mean));
+    EXPECT_TRUE(std::isnan(empty.standardError));
+    EXPECT_TRUE(std::isnan(empty.coefficients[0]));
+}
+
+TEST(ControlVariatesTest, ReducesStandardError) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    MonteCarloEvaluator plain(100000, 42);
+    SimulationResult independent = plain.evaluate(revenue().get(), registry);
+    EXPECT_TRUE(independent.controlCoefficients.empty());
+
+    MonteCarloEvaluator controlled(100000, 42);
+    addLinearControls(controlled);
+    ASSERT_EQ(controlled.getControlVariates().size(), 2);
+    SimulationResult result = controlled.evaluate(revenue().get(), registry);
+
+    // The controls are drawn from the same stream, so the samples match
+    EXPECT_EQ(result.samples, independent.samples);
+    EXPECT_EQ(result.stddev, independent.stddev);
+    ASSERT_EQ(result.controlCoefficients.size(), 2);
+    EXPECT_NEAR(result.controlCoefficients[0], 15.0, 0.1);   // E[quantity]
+    EXPECT_NEAR(result.controlCoefficients[1], 100.0, 1.0);  // E[price]
+    // Only the product of the deviations is left: sd 15 * 2.89 vs 1500 * 0.2
+    EXPECT_LT(result.standardError, 0.2 * independent.standardError);
+    EXPECT_NEAR(result.mean, 1500.0, 5.0 * result.standardError);
+
+    controlled.clearControlVariates();
+    EXPECT_TRUE(controlled.getControlVariates().empty());
+}
+
+TEST(ControlVariatesTest, ExactControlRemovesError) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    MonteCarloEvaluator evaluator(10000, 42);
+    auto target = ExpressionBuilder::variable("price") * 2.0 + ExpressionBuilder::variable("quantity");
+    evaluator.addControlVariate(target.get(), 215.0);
+    SimulationResult result = evaluator.evaluate(target.get(), registry);
+    EXPECT_NEAR(result.mean, 215.0, 1e-9);
+    EXPECT_LT(result.standardError, 1e-6);  // Rounding only
+    EXPECT_NEAR(result.controlCoefficients[0], 1.0, 1e-12);
+}
+
+TEST(ControlVariatesTest, NanRowsAreSkipped) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    MonteCarloEvaluator evaluator(1000, 42);
+    addLinearControls(evaluator);
+    auto divide = ExpressionBuilder::variable("price") / ExpressionBuilder::constant(0.0);
+    SimulationResult result = evaluator.evaluate(divide.get(), registry);
+    EXPECT_EQ(result.validSampleCount, 0);
+    EXPECT_TRUE(std::isnan(result.mean));
+    EXPECT_TRUE(std::isnan(result.standardError));
+
+    // Rows where a control is NaN are left out; here that is every row
+    MonteCarloEvaluator partial(1000, 42);
+    partial.addControlVariate((ExpressionBuilder::variable("quantity") /
+                               ExpressionBuilder::constant(0.0)).get(), 15.0);
+    SimulationResult unaffected = partial.evaluate(revenue().get(), registry);
+    EXPECT_EQ(unaffected.validSampleCount, 1000);
+    EXPECT_TRUE(std::isnan(unaffected.mean));
+}
+
+TEST(ControlVariatesTest, IndependentOfThreads) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry->registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    auto run = [&registry](size_t threads) {
+        MonteCarloEvaluator evaluator(100001, 42);
+        evaluator.setRandomEngine(RandomEngine::Philox4x32);
+        evaluator.setThreadCount(threads);
+        addLinearControls(evaluator);
+        return evaluator.evaluate(revenue().get(), *registry);
+    };
+    SimulationResult expected = run(1);
+    SimulationResult actual = run(4);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.standardError, expected.standardError);
+    EXPECT_EQ(actual.controlCoefficients, expected.controlCoefficients);
+
+    // A scheduler job with the same controls gives the same result
+    SimulationJob job;
+    job.expression = revenue().get();
+    job.registry = registry;
+    job.numSamples = 100001;
+    job.seed = 42;
+    job.engine = RandomEngine::Philox4x32;
+    job.controlVariates = {{ExpressionBuilder::variable("price").get(), 100.0},
+                           {ExpressionBuilder::variable("quantity").get(), 15.0}};
+    SimulationScheduler scheduler(3);
+    SimulationResult scheduled = scheduler.submit(job).get();
+    EXPECT_EQ(scheduled.mean, expected.mean);
+    EXPECT_EQ(scheduled.controlCoefficients, expected.controlCoefficients);
+}
+
+TEST(ControlVariatesTest, PartitionedStreamMatchesSequential) {
+    // Uniform draws have a fixed count, so the stream can be split; ranges
+    // of 521 blocks do not start on aligned blocks
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<UniformDistribution>(10.0, 20.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto expr = (ExpressionBuilder::variable("a") * ExpressionBuilder::variable("b")).get();
+    auto run = [&](size_t threads) {
+        MonteCarloEvaluator evaluator(800001, 42);
+        evaluator.setThreadCount(threads);
+        evaluator.setPartitionSequentialStream(true);
+        evaluator.addControlVariate(ExpressionBuilder::variable("a").get(), 15.0);
+        evaluator.addControlVariate(ExpressionBuilder::variable("b").get(), 0.5);
+        return evaluator.evaluate(expr, registry);
+    };
+    SimulationResult expected = run(0);
+    SimulationResult actual = run(3);
+    EXPECT_EQ(actual.samples, expected.samples);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.standardError, expected.standardError);
+    EXPECT_EQ(actual.controlCoefficients, expected.controlCoefficients);
+    EXPECT_NEAR(actual.mean, 7.5, 5.0 * actual.standardError);
+}
+
+TEST(ControlVariatesTest, CombinesWithAntitheticPairs) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    MonteCarloEvaluator evaluator(100000, 42);
+    evaluator.setAntitheticVariates(true);
+    addLinearControls(evaluator);
+    SimulationResult result = evaluator.evaluate(revenue().get(), registry);
+    EXPECT_EQ(result.pairCount, 50000);
+    EXPECT_NEAR(result.mean, 1500.0, 5.0 * result.standardError);
+    EXPECT_GT(result.standardError, 0.0);
+}
+
+TEST(ControlVariatesTest, InvalidControls) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    MonteCarloEvaluator evaluator(1000, 42);
+    EXPECT_THROW(evaluator.addControlVariate(nullptr, 1.0), std::invalid_argument);
+    EXPECT_THROW(evaluator.addControlVariate(ExpressionBuilder::variable("price").get(), NAN),
+                 std::invalid_argument);
+
+    evaluator.addControlVariate(ExpressionBuilder::variable("missing").get(), 0.0);
+    EXPECT_THROW(evaluator.evaluate(revenue().get(), registry), std::out_of_range);
+
+    evaluator.clearControlVariates();
+    addLinearControls(evaluator);
+    evaluator.setSamplingMethod(SamplingMethod::QuasiMonteCarlo);
+    EXPECT_THROW(evaluator.evaluate(revenue().get(), registry), std::invalid_argument);
+}
@@ -2,6 +2,8 @@
 #include <numeric>
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <thread>
 #include "distribution.h"
 #include "variable_registry.h"
 
@@ -240,6 +242,86 @@ TEST(VariableRegistryTest, ReRegistration) {
     EXPECT_LE(samples["x"], 20.0);
 }
 
+// Test slots follow name order regardless of registration order
+TEST(VariableRegistryTest, SlotsFollowNameOrder) {
+    VariableRegistry registry;
+    registry.registerVariable("zeta", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("alpha", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("mid", std::make_shared<NormalDistribution>(0.0, 1.0));
+    
+    EXPECT_EQ(registry.getSlot("alpha"), 0);
+    EXPECT_EQ(registry.getSlot("mid"), 1);
+    EXPECT_EQ(registry.getSlot("zeta"), 2);
+    EXPECT_THROW(registry.getSlot("missing"), std::out_of_range);
+}
+
+// Test flat-array sampling consumes the stream exactly like the map overload
+TEST(VariableRegistryTest, SampleAllIntoArrayMatchesMap) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.registerVariable("z", std::make_shared<NormalDistribution>(5.0, 2.0));
+    
+    VariableRegistry reference;
+    reference.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    reference.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    reference.registerVariable("z", std::make_shared<NormalDistribution>(5.0, 2.0));
+    
+    std::mt19937 rng1(42);
+    std::mt19937 rng2(42);
+    for (int i = 0; i < 5; ++i) {
+        // Strided layout: slot s lands at values[s * 2]
+        double values[6];
+        registry.sampleAll(rng1, values, 2);
+        auto samples = reference.sampleAll(rng2);
+        EXPECT_EQ(values[0], samples["x"]);
+        EXPECT_EQ(values[2], samples["y"]);
+        EXPECT_EQ(values[4], samples["z"]);
+    }
+}
+
+// Test flat-array sampling with states keeps each normal pair's spare
+TEST(VariableRegistryTest, SampleAllIntoArrayContinuesStates) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    
+    std::mt19937 rng1(42);
+    std::mt19937 rng2(42);
+    auto states1 = registry.makeSamplerStates();
+    auto states2 = registry.makeSamplerStates();
+    for (int i = 0; i < 5; ++i) {
+        double values[2];
+        registry.sampleAll(rng1, states1, values);
+        auto samples = registry.sampleAll(rng2, states2);
+        EXPECT_EQ(values[0], samples["x"]);
+        EXPECT_EQ(values[1], samples["y"]);
+    }
+}
+
+// Test subset sampling draws only the listed slots
+TEST(VariableRegistryTest, SampleSlotsDrawsOnlyListed) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.registerVariable("c", std::make_shared<NormalDistribution>(5.0, 2.0));
+    
+    VariableRegistry reference;
+    reference.registerVariable("a", std::make_shared<NormalDistribution>(0.0, 1.0));
+    reference.registerVariable("c", std::make_shared<NormalDistribution>(5.0, 2.0));
+    
+    std::mt19937 rng1(42);
+    std::mt19937 rng2(42);
+    const std::vector<size_t> slots = {0, 2};
+    for (int i = 0; i < 5; ++i) {
+        double values[2];
+        registry.sampleSlots(rng1, slots, values);
+        auto samples = reference.sampleAll(rng2);
+        EXPECT_EQ(values[0], samples["a"]);
+        EXPECT_EQ(values[1], samples["c"]);
+    }
+}
+
 // Test different seeds produce different sequences
 TEST(DistributionTest, DifferentSeeds) {
     NormalDistribution dist(0.0, 1.0);
@@ -252,3 +334,385 @@ TEST(DistributionTest, DifferentSeeds) {
     
     EXPECT_NE(sample1, sample2);
 }
+
+// Block sampling with std::mt19937 is the same sequence as scalar sampling
+TEST(DistributionTest, BlockSamplingMatchesScalarForMt19937) {
+    // Separate objects, since each continues its own normal pairs
+    NormalDistribution blockNormal(2.0, 3.0);
+    NormalDistribution scalarNormal(2.0, 3.0);
+    UniformDistribution uniform(-1.0, 1.0);
+    std::mt19937 rng1(42);
+    std::mt19937 rng2(42);
+    
+    std::vector<double> block(101);
+    blockNormal.sample(rng1, block.data(), block.size());
+    for (double value : block) {
+        EXPECT_EQ(value, scalarNormal.sample(rng2));
+    }
+    uniform.sample(rng1, block.data(), block.size());
+    for (double value : block) {
+        EXPECT_EQ(value, uniform.sample(rng2));
+    }
+}
+
+// sample(rng) continues the object's normal pairs like a std::normal_distribution member
+TEST(DistributionTest, ScalarSamplingContinuesPairs) {
+    NormalDistribution normal(2.0, 3.0);
+    std::normal_distribution<double> reference(2.0, 3.0);
+    std::mt19937 rng1(42);
+    std::mt19937 rng2(42);
+    for (int i = 0; i < 101; ++i) {
+        EXPECT_EQ(normal.sample(rng1), reference(rng2));
+    }
+    EXPECT_EQ(rng1, rng2);
+    
+    // A SamplerState stream does not disturb the object's own pairs
+    std::mt19937 other(7);
+    SamplerState state;
+    normal.sample(other, state);
+    EXPECT_EQ(normal.sample(rng1), reference(rng2));
+}
+
+namespace {
+
+// Written against the original interface: only sample(std::mt19937&)
+class LegacyConstant : public Distribution {
+public:
+    explicit LegacyConstant(double value) : value_(value) {}
+    double sample(std::mt19937& rng) const override {
+        rng();
+        return value_;
+    }
+
+private:
+    double value_;
+};
+
+} // namespace
+
+TEST(DistributionTest, LegacySubclassSamplesWithMt19937) {
+    LegacyConstant legacy(4.0);
+    const Distribution& constant = legacy;
+    std::mt19937 rng(1);
+    SamplerState state;
+    EXPECT_EQ(constant.sample(rng), 4.0);
+    EXPECT_EQ(constant.sample(rng, state), 4.0);
+    double block[3];
+    constant.sample(rng, state, block, 3);
+    EXPECT_EQ(block[2], 4.0);
+    std::mt19937 reference(1);
+    reference.discard(5);
+    EXPECT_EQ(rng, reference);
+    
+    VariableRegistry registry;
+    registry.registerVariable("c", std::make_shared<LegacyConstant>(4.0));
+    EXPECT_EQ(registry.sampleAll(rng)["c"], 4.0);
+    
+    Xoshiro256PlusPlus xoshiro(1);
+    EXPECT_THROW(constant.sample(xoshiro, state), std::logic_error);
+    EXPECT_THROW(constant.cdf(0.0), std::logic_error);
+    EXPECT_THROW(constant.clone(), std::logic_error);
+}
+
+// Block kernels (Box-Muller, bits-to-double uniform) on the other engines
+TEST(DistributionTest, BlockKernelMoments) {
+    NormalDistribution normal(10.0, 2.0);
+    UniformDistribution uniform(3.0, 5.0);
+    Philox4x32 philox(11);
+    Xoshiro256PlusPlus xoshiro(11);
+    
+    // Odd block size exercises the unpaired last sample
+    const size_t blockSize = 511;
+    std::vector<double> block(blockSize);
+    double normalSum = 0.0;
+    double normalSquares = 0.0;
+    double uniformSum = 0.0;
+    size_t count = 0;
+    for (int b = 0; b < 200; ++b) {
+        if (b % 2 == 0) {
+            normal.sample(philox, block.data(), blockSize);
+        } else {
+            normal.sample(xoshiro, block.data(), blockSize);
+        }
+        for (double value : block) {
+            ASSERT_TRUE(std::isfinite(value));
+            normalSum += value;
+            normalSquares += value * value;
+        }
+        
+        if (b % 2 == 0) {
+            uniform.sample(philox, block.data(), blockSize);
+        } else {
+            uniform.sample(xoshiro, block.data(), blockSize);
+        }
+        for (double value : block) {
+            ASSERT_GE(value, 3.0);
+            ASSERT_LT(value, 5.0);
+            uniformSum += value;
+        }
+        count += blockSize;
+    }
+    double mean = normalSum / count;
+    EXPECT_NEAR(mean, 10.0, 0.03);
+    EXPECT_NEAR(std::sqrt(normalSquares / count - mean * mean), 2.0, 0.03);
+    EXPECT_NEAR(uniformSum / count, 4.0, 0.01);
+    
+    // Both halves of each Box-Muller pair are used
+    Philox4x32 rng(3);
+    double pair[2];
+    normal.sample(rng, pair, 2);
+    EXPECT_NE(pair[0], pair[1]);
+}
+
+TEST(DistributionTest, SampleColumnsFillsEachColumn) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(10.0, 11.0));
+    registry.registerVariable("c", std::make_shared<UniformDistribution>(20.0, 21.0));
+    
+    // Columns of stride 8, filled with 5 samples each; c is not sampled
+    std::vector<double> columns(16, -1.0);
+    std::mt19937 rng1(7);
+    registry.sampleColumns(rng1, {1, 0}, columns.data(), 8, 5);
+    
+    std::mt19937 rng2(7);
+    UniformDistribution b(10.0, 11.0);
+    UniformDistribution a(0.0, 1.0);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(columns[i], b.sample(rng2));
+    }
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(columns[8 + i], a.sample(rng2));
+    }
+    EXPECT_EQ(columns[5], -1.0);
+    EXPECT_EQ(columns[13], -1.0);
+}
+
+namespace {
+
+// Kolmogorov-Smirnov distance of a sample from the standard normal
+double ksDistanceFromStandardNormal(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const double n = static_cast<double>(values.size());
+    double distance = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        const double cdf = 0.5 * std::erfc(-values[i] / std::sqrt(2.0));
+        distance = std::max({distance, cdf - i / n, (i + 1) / n - cdf});
+    }
+    return distance;
+}
+
+void expectStandardNormal(const std::vector<double>& values) {
+    const double n = static_cast<double>(values.size());
+    double mean = calculateMean(values);
+    double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    for (double value : values) {
+        double d = value - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    m2 /= n;
+    m3 /= n;
+    m4 /= n;
+    EXPECT_NEAR(mean, 0.0, 0.01);
+    EXPECT_NEAR(m2, 1.0, 0.015);
+    EXPECT_NEAR(m3 / std::pow(m2, 1.5), 0.0, 0.03);  // Skewness
+    EXPECT_NEAR(m4 / (m2 * m2), 3.0, 0.06);          // Kurtosis
+    // Critical value at the 0.1% level is 1.95 / sqrt(n)
+    EXPECT_LT(ksDistanceFromStandardNormal(values), 1.95 / std::sqrt(n));
+}
+
+} // namespace
+
+// One registry sampled by several threads at once, each with its own engine
+// and sampler states, gives the same values as sampling it serially
+TEST(VariableRegistryTest, SharedAcrossThreads) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(2.0, 3.0));
+    registry.registerVariable("c", std::make_shared<NormalDistribution>(1.0, 0.5, NormalSampler::Ziggurat));
+    const std::vector<size_t> slots = {0, 1, 2};
+    const size_t rows = 10001;
+    
+    auto sampleStream = [&](unsigned seed, std::vector<double>& out) {
+        std::mt19937 rng(seed);
+        auto states = registry.makeSamplerStates();
+        out.resize(rows * slots.size());
+        for (size_t i = 0; i < rows; ++i) {
+            registry.sampleSlots(rng, states, slots, out.data() + i * slots.size());
+        }
+    };
+    
+    std::vector<std::vector<double>> concurrent(4);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] { sampleStream(t + 1, concurrent[t]); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (unsigned t = 0; t < 4; ++t) {
+        std::vector<double> serial;
+        sampleStream(t + 1, serial);
+        EXPECT_EQ(concurrent[t], serial);
+    }
+}
+
+TEST(DistributionTest, ZigguratTables) {
+    const ZigguratTables& tables = ZigguratTables::get();
+    EXPECT_EQ(&tables, &ZigguratTables::get());
+    EXPECT_EQ(tables.x[1], ZigguratTables::TAIL_START);
+    EXPECT_EQ(tables.x[ZigguratTables::LAYERS], 0.0);
+    for (size_t i = 1; i < ZigguratTables::LAYERS; ++i) {
+        EXPECT_GT(tables.x[i], tables.x[i + 1]);
+        EXPECT_LT(tables.ratio[i], 1.0);
+    }
+    // The top layer's edge is where the density is close to its peak
+    EXPECT_LT(tables.x[ZigguratTables::LAYERS - 1], 0.3);
+}
+
+TEST(DistributionTest, ZigguratMomentsAndKolmogorovSmirnov) {
+    NormalDistribution standard(0.0, 1.0, NormalSampler::Ziggurat);
+    EXPECT_EQ(standard.getSampler(), NormalSampler::Ziggurat);
+    const size_t count = 200000;
+    std::vector<double> values(count);
+    
+    std::mt19937 mt(1);
+    for (auto& value : values) {
+        value = standard.sample(mt);
+    }
+    expectStandardNormal(values);
+    
+    Xoshiro256PlusPlus xoshiro(2);
+    standard.sample(xoshiro, values.data(), count);
+    expectStandardNormal(values);
+    
+    // The tail beyond R is sampled at its true frequency, 2 * (1 - Phi(R))
+    size_t tail = 0;
+    for (double value : values) {
+        tail += std::abs(value) > ZigguratTables::TAIL_START ? 1 : 0;
+    }
+    const double expectedTail = std::erfc(ZigguratTables::TAIL_START / std::sqrt(2.0)) * count;
+    EXPECT_NEAR(static_cast<double>(tail), expectedTail, 5.0 * std::sqrt(expectedTail));
+}
+
+TEST(DistributionTest, ZigguratScaleAndClone) {
+    NormalDistribution dist(50.0, 4.0, NormalSampler::Ziggurat);
+    auto copy = dist.clone();
+    EXPECT_EQ(static_cast<const NormalDistribution&>(*copy).getSampler(), NormalSampler::Ziggurat);
+    
+    Philox4x32 rng1(9);
+    Philox4x32 rng2(9);
+    std::vector<double> values(100000);
+    for (auto& value : values) {
+        value = dist.sample(rng1);
+        EXPECT_EQ(value, copy->sample(rng2));
+    }
+    double mean = calculateMean(values);
+    EXPECT_NEAR(mean, 50.0, 0.05);
+    EXPECT_NEAR(calculateStdDev(values, mean), 4.0, 0.05);
+    
+    // The default sampler is unchanged
+    EXPECT_EQ(NormalDistribution(0.0, 1.0).getSampler(), NormalSampler::Default);
+}
+
+TEST(DistributionTest, BoxMullerMomentsAndFixedDraws) {
+    NormalDistribution standard(0.0, 1.0, NormalSampler::BoxMuller);
+    EXPECT_EQ(standard.getFixedDrawCount(), 4);
+    EXPECT_EQ(NormalDistribution(0.0, 1.0).getFixedDrawCount(), 0);
+    EXPECT_EQ(NormalDistribution(0.0, 1.0, NormalSampler::Ziggurat).getFixedDrawCount(), 0);
+    const size_t count = 200000;
+    std::vector<double> values(count);
+    
+    // Every sample takes exactly four outputs, in blocks as one by one
+    std::mt19937 mt(1);
+    standard.sample(mt, values.data(), count);
+    expectStandardNormal(values);
+    std::mt19937 reference(1);
+    reference.discard(4 * count);
+    EXPECT_EQ(mt(), reference());
+    
+    std::mt19937 scalar(1);
+    for (size_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(standard.sample(scalar), values[i]);
+    }
+    
+    Philox4x32 philox(2);
+    standard.sample(philox, values.data(), count);
+    expectStandardNormal(values);
+}
+
+TEST(DistributionTest, NormalInverseCdf) {
+    NormalDistribution standard(0.0, 1.0);
+    EXPECT_EQ(standard.inverseCdf(0.5), 0.0);
+    EXPECT_NEAR(standard.inverseCdf(0.975), 1.959963984540054, 1e-14);
+    EXPECT_NEAR(standard.inverseCdf(0.025), -1.959963984540054, 1e-14);
+    EXPECT_NEAR(standard.inverseCdf(1e-10), -6.361340902404056, 1e-12);
+    EXPECT_EQ(standard.inverseCdf(0.0), -std::numeric_limits<double>::infinity());
+    EXPECT_EQ(standard.inverseCdf(1.0), std::numeric_limits<double>::infinity());
+    
+    // Round trip through the CDF, across the central and both tail regions
+    NormalDistribution dist(100.0, 15.0);
+    for (double p : {1e-12, 1e-6, 0.01, 0.02425, 0.1, 0.3, 0.5, 0.7, 0.9, 0.99, 1.0 - 1e-6}) {
+        const double x = dist.inverseCdf(p);
+        EXPECT_NEAR(dist.cdf(x), p, 1e-14 * std::max(1.0, p / (1.0 - p))) << "p = " << p;
+    }
+    EXPECT_NEAR(dist.cdf(100.0 + 15.0), 0.8413447460685429, 1e-15);
+}
+
+TEST(DistributionTest, UniformInverseCdf) {
+    UniformDistribution dist(10.0, 20.0);
+    EXPECT_EQ(dist.inverseCdf(0.0), 10.0);
+    EXPECT_EQ(dist.inverseCdf(0.25), 12.5);
+    EXPECT_EQ(dist.cdf(12.5), 0.25);
+    EXPECT_EQ(dist.cdf(5.0), 0.0);
+    EXPECT_EQ(dist.cdf(25.0), 1.0);
+    
+    // The block form matches the scalar one and may work in place
+    double values[] = {0.1, 0.5, 0.9};
+    const Distribution& base = dist;
+    base.inverseCdf(values, values, 3);
+    EXPECT_EQ(values[0], dist.inverseCdf(0.1));
+    EXPECT_EQ(values[1], 15.0);
+    EXPECT_EQ(values[2], dist.inverseCdf(0.9));
+}
+
+TEST(DistributionTest, AntitheticCounterparts) {
+    // Counterparts sit at the mirrored quantile, inverseCdf(1 - cdf(x))
+    NormalDistribution normal(100.0, 15.0);
+    UniformDistribution uniform(10.0, 20.0);
+    double in[] = {70.0, 100.0, 121.5};
+    double out[3];
+    normal.antithetic(in, out, 3);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_NEAR(out[i], normal.inverseCdf(1.0 - normal.cdf(in[i])), 1e-9);
+    }
+    EXPECT_EQ(out[1], 100.0);
+    
+    double u[] = {10.0, 12.5, 19.0};
+    uniform.antithetic(u, u, 3);  // In place
+    EXPECT_EQ(u[0], 20.0);
+    EXPECT_EQ(u[1], 17.5);
+    EXPECT_EQ(u[2], 11.0);
+}
+
+TEST(DistributionTest, LogPdf) {
+    NormalDistribution normal(100.0, 15.0);
+    EXPECT_NEAR(normal.logPdf(100.0), -std::log(15.0 * std::sqrt(2.0 * M_PI)), 1e-14);
+    EXPECT_NEAR(normal.logPdf(130.0), normal.logPdf(100.0) - 2.0, 1e-12);
+    
+    // The block form matches the scalar one
+    double values[] = {70.0, 100.0, 121.5};
+    double logs[3];
+    const Distribution& base = normal;
+    base.logPdf(values, logs, 3);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(logs[i], normal.logPdf(values[i]));
+    }
+    
+    UniformDistribution uniform(10.0, 20.0);
+    EXPECT_DOUBLE_EQ(uniform.logPdf(15.0), -std::log(10.0));
+    EXPECT_EQ(uniform.logPdf(10.0), -std::log(10.0));
+    EXPECT_EQ(uniform.logPdf(25.0), -std::numeric_limits<double>::infinity());
+}
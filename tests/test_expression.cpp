@@ -185,3 +185,54 @@ TEST(ExpressionTest, DifferenceOfSquares) {
     
     EXPECT_EQ(mulExpr->evaluate(vars), 16.0);
 }
+
+// Test structural hashing and equality
+TEST(ExpressionTest, StructurallyEqualTreesHashEqually) {
+    auto makeTree = []() {
+        return std::make_shared<BinaryOp>(
+            std::make_shared<Variable>("x"),
+            std::make_shared<Constant>(2.5),
+            BinaryOperator::Multiply
+        );
+    };
+    auto first = makeTree();
+    auto second = makeTree();
+    
+    EXPECT_NE(first, second);
+    EXPECT_EQ(first->hash(), second->hash());
+    EXPECT_TRUE(first->equals(*second));
+    EXPECT_TRUE(second->equals(*first));
+}
+
+TEST(ExpressionTest, StructuralDifferencesAreDetected) {
+    auto x = std::make_shared<Variable>("x");
+    auto y = std::make_shared<Variable>("y");
+    auto two = std::make_shared<Constant>(2.0);
+    auto sum = std::make_shared<BinaryOp>(x, two, BinaryOperator::Add);
+    auto product = std::make_shared<BinaryOp>(x, two, BinaryOperator::Multiply);
+    auto swapped = std::make_shared<BinaryOp>(two, x, BinaryOperator::Add);
+    auto otherVariable = std::make_shared<BinaryOp>(y, two, BinaryOperator::Add);
+    
+    EXPECT_FALSE(sum->equals(*product));
+    EXPECT_FALSE(sum->equals(*swapped));
+    EXPECT_FALSE(sum->equals(*otherVariable));
+    EXPECT_FALSE(sum->equals(*x));
+    EXPECT_FALSE(x->equals(*two));
+    EXPECT_NE(sum->hash(), product->hash());
+    EXPECT_NE(sum->hash(), swapped->hash());
+    
+    // Constants compare bit for bit, so 0.0 and -0.0 are distinct
+    EXPECT_FALSE(Constant(0.0).equals(Constant(-0.0)));
+    EXPECT_TRUE(Constant(1.5).equals(Constant(1.5)));
+}
+
+TEST(ExpressionTest, DeepChainEquality) {
+    std::shared_ptr<Expression> first = std::make_shared<Variable>("x");
+    std::shared_ptr<Expression> second = std::make_shared<Variable>("x");
+    for (int i = 0; i < 10000; ++i) {
+        first = std::make_shared<BinaryOp>(first, std::make_shared<Constant>(1.0), BinaryOperator::Add);
+        second = std::make_shared<BinaryOp>(second, std::make_shared<Constant>(1.0), BinaryOperator::Add);
+    }
+    EXPECT_EQ(first->hash(), second->hash());
+    EXPECT_TRUE(first->equals(*second));
+}
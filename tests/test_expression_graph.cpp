@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "expression_graph.h"
+#include "expression_builder.h"
+#include "expression_optimizer.h"
+#include "monte_carlo_evaluator.h"
+#include <cmath>
+#include <map>
+#include <random>
+
+using namespace tt_int;
+
+TEST(ExpressionGraphTest, ConstantAndVariable) {
+    ExpressionGraph graph;
+    auto c = graph.constant(42.0);
+    auto x = graph.variable("x");
+
+    EXPECT_EQ(graph.evaluate(c, {}), 42.0);
+    std::map<std::string, double> vars = {{"x", 5.0}};
+    EXPECT_EQ(graph.evaluate(x, vars), 5.0);
+    EXPECT_EQ(graph.size(), 2);
+    EXPECT_EQ(graph.getNode(x).kind, NodeKind::Variable);
+    EXPECT_EQ(graph.getVariableName(graph.getNode(x).lhs), "x");
+}
+
+TEST(ExpressionGraphTest, MissingVariableThrows) {
+    ExpressionGraph graph;
+    auto x = graph.variable("missing");
+    std::map<std::string, double> vars = {{"x", 1.0}};
+    EXPECT_THROW(graph.evaluate(x, vars), std::out_of_range);
+}
+
+TEST(ExpressionGraphTest, InvalidIdsThrow) {
+    ExpressionGraph graph;
+    auto x = graph.variable("x");
+    EXPECT_THROW(graph.binary(BinaryOperator::Add, x, 7), std::invalid_argument);
+    EXPECT_THROW(graph.evaluate(7, {}), std::invalid_argument);
+    EXPECT_THROW(graph.toExpression(7), std::invalid_argument);
+}
+
+TEST(ExpressionGraphTest, OnlyReachableNodesAreEvaluated) {
+    // An unrelated node referencing an unset variable does not affect the result
+    ExpressionGraph graph;
+    auto x = graph.variable("x");
+    graph.variable("unused");
+    auto sum = graph.binary(BinaryOperator::Add, x, graph.constant(1.0));
+
+    std::map<std::string, double> vars = {{"x", 2.0}};
+    EXPECT_EQ(graph.evaluate(sum, vars), 3.0);
+}
+
+TEST(ExpressionGraphTest, DivideByZeroIsNaN) {
+    ExpressionGraph graph;
+    auto one = graph.constant(1.0);
+    auto zero = graph.constant(0.0);
+    EXPECT_TRUE(std::isnan(graph.evaluate(graph.binary(BinaryOperator::Divide, one, zero), {})));
+}
+
+TEST(ExpressionGraphTest, BuilderMatchesTreeBuilder) {
+    ExpressionGraph graph;
+    auto gx = GraphExpressionBuilder::variable(graph, "x");
+    auto gy = GraphExpressionBuilder::variable(graph, "y");
+    auto graphExpr = (gx + gy) * 3.0 - gx / (gy - 2.0) + 0.5 / gy;
+
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto treeExpr = (x + y) * 3.0 - x / (y - 2.0) + 0.5 / y;
+
+    for (double yValue : {-1.5, 0.0, 2.0, 4.25}) {
+        std::map<std::string, double> vars = {{"x", 1.75}, {"y", yValue}};
+        double expected = treeExpr.get()->evaluate(vars);
+        double actual = graph.evaluate(graphExpr.getId(), vars);
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(actual));
+        } else {
+            EXPECT_EQ(actual, expected);
+        }
+    }
+}
+
+TEST(ExpressionGraphTest, ToExpressionPreservesStructureAndSharing) {
+    ExpressionGraph graph;
+    auto x = GraphExpressionBuilder::variable(graph, "x");
+    auto t = x + 1.0;
+    auto expr = t * t;
+
+    auto converted = expr.get();
+    auto reference = (ExpressionBuilder::variable("x") + 1.0) * (ExpressionBuilder::variable("x") + 1.0);
+    EXPECT_TRUE(converted->equals(*reference.get()));
+
+    // The shared graph node stays a single shared Expression node
+    EXPECT_EQ(countNodes(converted), 4);
+}
+
+TEST(ExpressionGraphTest, BuildersFromDifferentGraphsThrow) {
+    ExpressionGraph first;
+    ExpressionGraph second;
+    auto x = GraphExpressionBuilder::variable(first, "x");
+    auto y = GraphExpressionBuilder::variable(second, "y");
+    EXPECT_THROW(x + y, std::invalid_argument);
+}
+
+TEST(ExpressionGraphTest, DeepChain) {
+    ExpressionGraph graph;
+    graph.reserve(200001);
+    auto expr = GraphExpressionBuilder::variable(graph, "x");
+    for (int i = 0; i < 100000; ++i) {
+        expr = expr + 1.0;
+    }
+
+    std::map<std::string, double> vars = {{"x", 0.5}};
+    EXPECT_EQ(graph.evaluate(expr.getId(), vars), 100000.5);
+    EXPECT_EQ(graph.size(), 200001);
+
+    graph.clear();
+    EXPECT_EQ(graph.size(), 0);
+}
+
+TEST(ExpressionGraphTest, DeepChainConvertsAndTearsDown) {
+    ExpressionGraph graph;
+    auto expr = GraphExpressionBuilder::variable(graph, "x");
+    for (int i = 0; i < 1000000; ++i) {
+        expr = expr + 1.0;
+    }
+
+    // Releasing a million-deep Expression chain must not overflow the stack
+    std::shared_ptr<Expression> tree = expr.get();
+    EXPECT_NE(tree, nullptr);
+    tree.reset();
+}
+
+TEST(ExpressionGraphTest, EvaluatorRunsMillionNodeGraph) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+
+    ExpressionGraph graph;
+    graph.reserve(1000001);
+    auto one = GraphExpressionBuilder::constant(graph, 1.0);
+    auto expr = GraphExpressionBuilder::variable(graph, "x");
+    for (int i = 0; i < 999999; ++i) {
+        expr = expr + one;
+    }
+    ASSERT_EQ(graph.size(), 1000001);
+
+    MonteCarloEvaluator evaluator(16, 5);
+    auto result = evaluator.evaluate(graph, expr.getId(), registry);
+
+    VariableRegistry referenceRegistry;
+    referenceRegistry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    std::mt19937 rng(5);
+    auto states = referenceRegistry.makeSamplerStates();
+    ASSERT_EQ(result.samples.size(), 16);
+    for (double sample : result.samples) {
+        EXPECT_EQ(sample, graph.evaluate(expr.getId(), referenceRegistry.sampleAll(rng, states)));
+    }
+}
+
+TEST(ExpressionGraphTest, EvaluatorMatchesTreeEvaluation) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 2.0));
+
+    ExpressionGraph graph;
+    auto ga = GraphExpressionBuilder::variable(graph, "a");
+    auto gb = GraphExpressionBuilder::variable(graph, "b");
+    auto graphExpr = ga * gb - ga / gb;
+
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto treeExpr = a * b - a / b;
+
+    MonteCarloEvaluator graphEvaluator(500, 7);
+    MonteCarloEvaluator treeEvaluator(500, 7);
+    auto graphResult = graphEvaluator.evaluate(graph, graphExpr.getId(), registry);
+    auto treeResult = treeEvaluator.evaluate(treeExpr.get(), registry);
+    EXPECT_EQ(graphResult.samples, treeResult.samples);
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include "expression_optimizer.h"
+#include "expression_builder.h"
+#include <cmath>
+#include <map>
+
+using namespace tt_int;
+
+namespace {
+
+// Overrides only evaluate(), so it keeps the identity hash() and equals()
+class Seven : public Expression {
+public:
+    double evaluate(const std::map<std::string, double>&) const override { return 7.0; }
+};
+
+bool isConstant(const std::shared_ptr<Expression>& expr, double value) {
+    const auto* constant = dynamic_cast<const Constant*>(expr.get());
+    return constant != nullptr && constant->getValue() == value;
+}
+
+} // namespace
+
+TEST(OptimizerTest, CountNodes) {
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = (x + 1.0) * 2.0;
+    EXPECT_EQ(countNodes(expr.get()), 5);
+
+    // A shared subtree counts once
+    auto x2 = x * x;
+    auto shared = x2 + x2;
+    EXPECT_EQ(countNodes(shared.get()), 3);
+}
+
+TEST(OptimizerTest, FoldsConstantSubtree) {
+    // (2.0 * 0.5) * x  =>  1 * x  =>  x
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = (ExpressionBuilder::constant(2.0) * 0.5) * x;
+
+    auto result = simplify(expr.get());
+    EXPECT_EQ(result.expression, x.get());
+    EXPECT_EQ(result.nodesRemoved, 4);
+}
+
+TEST(OptimizerTest, FoldsWholeConstantExpression) {
+    auto expr = (ExpressionBuilder::constant(3.0) + 4.0) * 2.0 - 1.0;
+
+    auto result = simplify(expr.get());
+    EXPECT_TRUE(isConstant(result.expression, 13.0));
+    EXPECT_EQ(result.nodesRemoved, 6);
+}
+
+TEST(OptimizerTest, RemovesIdentities) {
+    // x * 1.0 + 0.0  =>  x
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x * 1.0 + 0.0;
+
+    auto result = simplify(expr.get());
+    EXPECT_EQ(result.expression, x.get());
+    EXPECT_EQ(result.nodesRemoved, 4);
+
+    EXPECT_EQ(simplify((1.0 * x).get()).expression, x.get());
+    EXPECT_EQ(simplify((0.0 + x).get()).expression, x.get());
+    EXPECT_EQ(simplify((x - 0.0).get()).expression, x.get());
+    EXPECT_EQ(simplify((x / 1.0).get()).expression, x.get());
+}
+
+TEST(OptimizerTest, DivisionByConstantBecomesMultiplication) {
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x / 4.0;
+
+    auto result = simplify(expr.get());
+    const auto* node = dynamic_cast<const BinaryOp*>(result.expression.get());
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->getOperator(), BinaryOperator::Multiply);
+    EXPECT_TRUE(isConstant(node->getRight(), 0.25));
+
+    std::map<std::string, double> vars = {{"x", 10.0}};
+    EXPECT_EQ(result.expression->evaluate(vars), 2.5);
+}
+
+TEST(OptimizerTest, PreservesDivideByZeroNaN) {
+    // Constant division by zero folds to NaN
+    auto folded = simplify((ExpressionBuilder::constant(1.0) / 0.0).get());
+    const auto* constant = dynamic_cast<const Constant*>(folded.expression.get());
+    ASSERT_NE(constant, nullptr);
+    EXPECT_TRUE(std::isnan(constant->getValue()));
+
+    // Division of a variable by zero is kept and still yields NaN
+    auto x = ExpressionBuilder::variable("x");
+    auto kept = simplify((x / 0.0).get());
+    std::map<std::string, double> vars = {{"x", 3.0}};
+    EXPECT_TRUE(std::isnan(kept.expression->evaluate(vars)));
+    EXPECT_EQ(kept.nodesRemoved, 0);
+}
+
+TEST(OptimizerTest, DoesNotApplyUnsafeIdentities) {
+    // x * 0 must stay NaN for x = NaN and x / x must stay NaN for x = 0
+    auto x = ExpressionBuilder::variable("x");
+    auto timesZero = simplify((x * 0.0).get());
+    auto selfRatio = simplify((x / x).get());
+    EXPECT_EQ(timesZero.nodesRemoved, 0);
+    EXPECT_EQ(selfRatio.nodesRemoved, 0);
+
+    std::map<std::string, double> vars = {{"x", 0.0}};
+    EXPECT_TRUE(std::isnan(selfRatio.expression->evaluate(vars)));
+}
+
+TEST(OptimizerTest, UnchangedTreeIsReturnedAsIs) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = (x + y) * (x - y);
+
+    auto result = simplify(expr.get());
+    EXPECT_EQ(result.expression, expr.get());
+    EXPECT_EQ(result.nodesRemoved, 0);
+}
+
+TEST(OptimizerTest, SimplifiedMatchesOriginal) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = ((ExpressionBuilder::constant(2.0) * 0.5) * x + 0.0) / 2.0
+                - (y * (ExpressionBuilder::constant(3.0) - 2.0)) / 8.0;
+
+    auto result = simplify(expr.get());
+    EXPECT_GT(result.nodesRemoved, 0);
+
+    std::map<std::string, double> vars = {{"x", 7.0}, {"y", -3.0}};
+    EXPECT_DOUBLE_EQ(result.expression->evaluate(vars), expr.get()->evaluate(vars));
+}
+
+TEST(OptimizerTest, DeepChain) {
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x;
+    for (int i = 0; i < 10000; ++i) {
+        expr = expr * 1.0;
+    }
+
+    auto result = simplify(expr.get());
+    EXPECT_EQ(result.expression, x.get());
+    EXPECT_EQ(result.nodesRemoved, 20000);
+}
+
+TEST(OptimizerTest, MergesIdenticalSubtrees) {
+    // Two separately built copies of x * x
+    auto x1 = ExpressionBuilder::variable("x");
+    auto x2 = ExpressionBuilder::variable("x");
+    auto expr = x1 * x1 + x2 * x2;
+    EXPECT_EQ(countNodes(expr.get()), 5);
+
+    auto result = eliminateCommonSubexpressions(expr.get());
+    const auto* sum = dynamic_cast<const BinaryOp*>(result.expression.get());
+    ASSERT_NE(sum, nullptr);
+    EXPECT_EQ(sum->getLeft(), sum->getRight());
+    EXPECT_EQ(countNodes(result.expression), 3);
+    EXPECT_EQ(result.nodesRemoved, 2);
+
+    std::map<std::string, double> vars = {{"x", 3.0}};
+    EXPECT_EQ(result.expression->evaluate(vars), 18.0);
+}
+
+TEST(OptimizerTest, MergesRepeatedLeaves) {
+    auto expr = ExpressionBuilder::variable("x") * 2.0 + ExpressionBuilder::variable("x") * 2.0;
+    auto result = eliminateCommonSubexpressions(expr.get());
+    EXPECT_EQ(countNodes(result.expression), 4);  // x, 2, x * 2, sum
+    EXPECT_EQ(result.nodesRemoved, 3);
+}
+
+TEST(OptimizerTest, KeepsDistinctSubtrees) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = (x - y) * (y - x);
+
+    auto result = eliminateCommonSubexpressions(expr.get());
+    EXPECT_EQ(result.expression, expr.get());
+    EXPECT_EQ(result.nodesRemoved, 0);
+}
+
+TEST(OptimizerTest, KeepsDistinctUnknownNodes) {
+    ExpressionBuilder first(std::make_shared<Seven>());
+    ExpressionBuilder second(std::make_shared<Seven>());
+    auto expr = first * 2.0 + second * 2.0;
+
+    auto result = eliminateCommonSubexpressions(expr.get());
+    const auto* sum = dynamic_cast<const BinaryOp*>(result.expression.get());
+    ASSERT_NE(sum, nullptr);
+    EXPECT_NE(sum->getLeft(), sum->getRight());
+    EXPECT_EQ(result.nodesRemoved, 1);  // Only the repeated constant 2
+    EXPECT_EQ(result.expression->evaluate({}), 28.0);
+
+    // The same node shared twice is still one node
+    auto shared = first * first;
+    EXPECT_EQ(shared.get()->hash(), (first * first).get()->hash());
+    EXPECT_TRUE(shared.get()->equals(*(first * first).get()));
+    EXPECT_FALSE(first.get()->equals(*second.get()));
+}
+
+TEST(OptimizerTest, OptimizeSimplifiesThenDeduplicates) {
+    // After simplification both sides become (x + y) * 0.5
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = ((x + y) / 2.0) * 1.0 - (ExpressionBuilder::variable("x") + y) / 2.0;
+
+    auto result = optimize(expr.get());
+    const auto* difference = dynamic_cast<const BinaryOp*>(result.expression.get());
+    ASSERT_NE(difference, nullptr);
+    EXPECT_EQ(difference->getLeft(), difference->getRight());
+    EXPECT_EQ(result.nodesRemoved, countNodes(expr.get()) - countNodes(result.expression));
+
+    std::map<std::string, double> vars = {{"x", 1.5}, {"y", 2.5}};
+    EXPECT_EQ(result.expression->evaluate(vars), 0.0);
+}
+
+TEST(OptimizerTest, CollectVariables) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = (x + 2.0) * (y - x) / ExpressionBuilder::variable("x");
+
+    auto names = collectVariables(expr.get());
+    EXPECT_EQ(names, (std::set<std::string>{"x", "y"}));
+    EXPECT_TRUE(collectVariables(ExpressionBuilder::constant(1.0).get()).empty());
+}
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include "weighted_statistics.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include "simulation_scheduler.h"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace tt_int;
+
+TEST(ImportanceSamplingTest, EqualWeightsMatchPlainStatistics) {
+    const double values[] = {2.0, 4.0, NAN, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+    const double zero[9] = {};
+    WeightedSummary summary = summarizeWeighted(values, zero, 9);
+    EXPECT_EQ(summary.count, 8);
+    EXPECT_DOUBLE_EQ(summary.mean, 5.0);
+    EXPECT_DOUBLE_EQ(summary.variance, 32.0 / 7.0);
+    EXPECT_DOUBLE_EQ(summary.standardError, std::sqrt(32.0 / 7.0 / 8.0));
+    EXPECT_DOUBLE_EQ(summary.effectiveSampleSize, 8.0);
+
+    // Only differences of log weights matter, however large
+    const double shifted[9] = {1e3, 1e3, 1e3, 1e3, 1e3, 1e3, 1e3, 1e3, 1e3};
+    WeightedSummary same = summarizeWeighted(values, shifted, 9);
+    EXPECT_DOUBLE_EQ(same.mean, summary.mean);
+    EXPECT_DOUBLE_EQ(same.effectiveSampleSize, summary.effectiveSampleSize);
+}
+
+TEST(ImportanceSamplingTest, WeightsShiftMeanAndEffectiveSize) {
+    // Weights 1 and 3: the mean is (1 * 1 + 3 * 5) / 4 = 4
+    const double values[] = {1.0, 5.0, 8.0};
+    const double logWeights[] = {0.0, std::log(3.0), -INFINITY};
+    WeightedSummary summary = summarizeWeighted(values, logWeights, 3);
+    EXPECT_EQ(summary.count, 3);
+    EXPECT_DOUBLE_EQ(summary.mean, 4.0);
+    EXPECT_DOUBLE_EQ(summary.effectiveSampleSize, 16.0 / 10.0);
+    // sum(w (y - 4)^2) = 9 + 3 = 12, divided by 4 - 10 / 4
+    EXPECT_DOUBLE_EQ(summary.variance, 12.0 / 1.5);
+    // sum(w^2 (y - 4)^2) / 4^2 = 18 / 16, times 1.6 / 0.6
+    EXPECT_DOUBLE_EQ(summary.standardError, std::sqrt(3.0));
+
+    const double nan[] = {NAN, NAN, NAN};
+    WeightedSummary empty = summarizeWeighted(values, nan, 3);
+    EXPECT_EQ(empty.count, 0);
+    EXPECT_TRUE(std::isnan(empty.mean));
+    EXPECT_EQ(empty.effectiveSampleSize, 0.0);
+}
+
+TEST(ImportanceSamplingTest, WeightedQuantiles) {
+    const double values[] = {4.0, 1.0, 3.0, NAN, 2.0};
+    EXPECT_EQ(weightedQuantiles(values, nullptr, 5, {0.0, 0.25, 0.5, 0.51, 1.0}),
+              (std::vector<double>{1.0, 1.0, 2.0, 3.0, 4.0}));
+
+    // Weights 1, 1, 1 and 5 on the values 4, 1, 3 and 2
+    const double logWeights[] = {0.0, 0.0, 0.0, 0.0, std::log(5.0)};
+    EXPECT_EQ(weightedQuantiles(values, logWeights, 5, {0.125, 0.2, 0.75, 0.8, 1.0}),
+              (std::vector<double>{1.0, 2.0, 2.0, 3.0, 4.0}));
+
+    EXPECT_THROW(weightedQuantiles(values, nullptr, 5, {1.5}), std::invalid_argument);
+    EXPECT_THROW(weightedQuantiles(values, nullptr, 5, {NAN}), std::invalid_argument);
+    EXPECT_TRUE(std::isnan(weightedQuantiles(values, nullptr, 0, {0.5})[0]));
+}
+
+TEST(ImportanceSamplingTest, RegistryProposals) {
+    // x ~ N(0, 1) drawn from N(1, 1); y ~ U(0, 1) drawn as registered
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.setProposal("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    const size_t x = registry.getSlot("x");
+    const size_t y = registry.getSlot("y");
+    ASSERT_NE(registry.getProposal(x), nullptr);
+    EXPECT_EQ(registry.getProposal(y), nullptr);
+    EXPECT_THROW(registry.setProposal("missing", std::make_shared<NormalDistribution>(0.0, 1.0)),
+                 std::out_of_range);
+
+    VariableRegistry proposals = registry.withProposals();
+    EXPECT_EQ(proposals.getSlot("x"), x);
+    EXPECT_EQ(&proposals.getDistribution(x), registry.getProposal(x));
+    EXPECT_EQ(&proposals.getDistribution(y), &registry.getDistribution(y));
+    EXPECT_EQ(proposals.getProposal(x), nullptr);
+
+    // Slots shift when a name is added; proposals follow their variable
+    registry.registerVariable("a", std::make_shared<UniformDistribution>(0.0, 1.0));
+    EXPECT_NE(registry.getProposal(registry.getSlot("x")), nullptr);
+    EXPECT_EQ(registry.getProposal(registry.getSlot("a")), nullptr);
+
+    // Registering again, or a null proposal, removes it
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    EXPECT_EQ(registry.getProposal(registry.getSlot("x")), nullptr);
+    registry.setProposal("y", std::make_shared<UniformDistribution>(0.0, 2.0));
+    registry.setProposal("y", nullptr);
+    EXPECT_EQ(registry.getProposal(registry.getSlot("y")), nullptr);
+}
+
+TEST(ImportanceSamplingTest, ShiftedProposalWeights) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.setProposal("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    auto x = ExpressionBuilder::variable("x").get();
+
+    MonteCarloEvaluator evaluator(100000, 42);
+    evaluator.setImportanceSampling(true);
+    EXPECT_TRUE(evaluator.getImportanceSampling());
+    SimulationResult result = evaluator.evaluate(x, registry);
+    ASSERT_EQ(result.logWeights.size(), 100000);
+    for (size_t i = 0; i < 100; ++i) {
+        // log N(x; 0, 1) - log N(x; 1, 1) = 0.5 - x
+        EXPECT_NEAR(result.logWeights[i], 0.5 - result.samples[i], 1e-12);
+    }
+
+    // The draws have mean 1, the weighted statistics those of N(0, 1)
+    EXPECT_NEAR(result.mean, 0.0, 5.0 * result.standardError);
+    EXPECT_NEAR(result.stddev, 1.0, 0.05);
+    // E[w^2] = e for a unit shift, so about n / e samples are effective
+    EXPECT_NEAR(result.effectiveSampleSize / result.validSampleCount, std::exp(-1.0), 0.05);
+}
+
+TEST(ImportanceSamplingTest, WideProposalReachesTail) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.setProposal("x", std::make_shared<NormalDistribution>(0.0, 2.0));
+    auto x = ExpressionBuilder::variable("x").get();
+
+    // 6% of the draws lie beyond the target's 0.999 quantile, 3.0902,
+    // instead of 0.1%
+    MonteCarloEvaluator evaluator(20000, 42);
+    evaluator.setImportanceSampling(true);
+    SimulationResult result = evaluator.evaluate(x, registry);
+    EXPECT_NEAR(result.quantile(0.999), 3.0902, 0.03);
+    EXPECT_GT(result.max, 5.0);  // min and max describe the draws
+}
+
+TEST(ImportanceSamplingTest, WithoutProposalsWeightsAreOne) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.setProposal("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    auto y = ExpressionBuilder::variable("y").get();
+
+    MonteCarloEvaluator plain(10000, 42);
+    SimulationResult expected = plain.evaluate(y, registry);
+    EXPECT_TRUE(expected.logWeights.empty());
+    EXPECT_EQ(expected.effectiveSampleSize, 10000.0);
+
+    MonteCarloEvaluator weighted(10000, 42);
+    weighted.setImportanceSampling(true);
+    SimulationResult result = weighted.evaluate(y, registry);
+    EXPECT_EQ(result.samples, expected.samples);
+    for (double logWeight : result.logWeights) {
+        ASSERT_EQ(logWeight, 0.0);
+    }
+    EXPECT_NEAR(result.mean, expected.mean, 1e-12);
+    EXPECT_NEAR(result.stddev, expected.stddev, 1e-12);
+    EXPECT_NEAR(result.standardError, expected.standardError, 1e-12);
+    EXPECT_EQ(result.effectiveSampleSize, 10000.0);
+    EXPECT_EQ(result.quantiles({0.1, 0.9}), expected.quantiles({0.1, 0.9}));
+}
+
+TEST(ImportanceSamplingTest, DivideByZeroCarriesNoWeight) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.setProposal("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    auto expr = (ExpressionBuilder::variable("x") / ExpressionBuilder::constant(0.0)).get();
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setImportanceSampling(true);
+    SimulationResult result = evaluator.evaluate(expr, registry);
+    EXPECT_EQ(result.validSampleCount, 0);
+    EXPECT_TRUE(std::isnan(result.mean));
+    EXPECT_TRUE(std::isnan(result.standardError));
+    EXPECT_EQ(result.effectiveSampleSize, 0.0);
+    EXPECT_TRUE(std::isnan(result.quantile(0.5)));
+}
+
+TEST(ImportanceSamplingTest, IndependentOfThreads) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry->registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry->setProposal("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    auto expr = (ExpressionBuilder::variable("x") * ExpressionBuilder::variable("y")).get();
+    auto run = [&](size_t threads) {
+        MonteCarloEvaluator evaluator(100001, 42);
+        evaluator.setRandomEngine(RandomEngine::Philox4x32);
+        evaluator.setThreadCount(threads);
+        evaluator.setImportanceSampling(true);
+        return evaluator.evaluate(expr, *registry);
+    };
+    SimulationResult expected = run(1);
+    SimulationResult actual = run(4);
+    EXPECT_EQ(actual.samples, expected.samples);
+    EXPECT_EQ(actual.logWeights, expected.logWeights);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.effectiveSampleSize, expected.effectiveSampleSize);
+
+    SimulationJob job;
+    job.expression = expr;
+    job.registry = registry;
+    job.numSamples = 100001;
+    job.seed = 42;
+    job.engine = RandomEngine::Philox4x32;
+    job.importanceSampling = true;
+    SimulationScheduler scheduler(3);
+    SimulationResult scheduled = scheduler.submit(job).get();
+    EXPECT_EQ(scheduled.logWeights, expected.logWeights);
+    EXPECT_EQ(scheduled.mean, expected.mean);
+}
+
+TEST(ImportanceSamplingTest, RejectsOtherVarianceReduction) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.setProposal("x", std::make_shared<NormalDistribution>(1.0, 1.0));
+    auto x = ExpressionBuilder::variable("x").get();
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setImportanceSampling(true);
+
+    evaluator.setSamplingMethod(SamplingMethod::LatinHypercube);
+    EXPECT_THROW(evaluator.evaluate(x, registry), std::invalid_argument);
+    evaluator.setSamplingMethod(SamplingMethod::MonteCarlo);
+
+    evaluator.setAntitheticVariates(true);
+    EXPECT_THROW(evaluator.evaluate(x, registry), std::invalid_argument);
+    evaluator.setAntitheticVariates(false);
+
+    evaluator.addControlVariate(x, 0.0);
+    EXPECT_THROW(evaluator.prepareChunks(x, registry), std::invalid_argument);
+}
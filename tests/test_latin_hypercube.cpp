@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "latin_hypercube.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include <cmath>
+#include <vector>
+
+using namespace tt_int;
+
+namespace {
+
+// Each of the n strata of width 1/n holds exactly one value
+void expectOnePerStratum(const double* values, size_t n) {
+    std::vector<int> hits(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_GT(values[i], 0.0);
+        ASSERT_LT(values[i], 1.0);
+        ++hits[static_cast<size_t>(values[i] * n)];
+    }
+    for (size_t s = 0; s < n; ++s) {
+        ASSERT_EQ(hits[s], 1) << "stratum " << s << " of " << n;
+    }
+}
+
+SimulationResult runLatinHypercube(std::shared_ptr<Expression> expr, const VariableRegistry& registry,
+                                   size_t samples, size_t replicates, size_t threads = 0,
+                                   unsigned seed = 42) {
+    MonteCarloEvaluator evaluator(samples, seed);
+    evaluator.setSamplingMethod(SamplingMethod::LatinHypercube);
+    evaluator.setReplicateCount(replicates);
+    evaluator.setThreadCount(threads);
+    return evaluator.evaluate(expr, registry);
+}
+
+} // namespace
+
+TEST(LatinHypercubeTest, PermuteIndexIsPermutation) {
+    for (std::uint32_t n : {1u, 2u, 7u, 1000u, 4096u, 100003u}) {
+        for (std::uint32_t seed : {0u, 1u, 0x9e3779b9u}) {
+            std::vector<bool> seen(n, false);
+            for (std::uint32_t i = 0; i < n; ++i) {
+                const std::uint32_t image = permuteIndex(i, n, seed);
+                ASSERT_LT(image, n);
+                ASSERT_FALSE(seen[image]) << "n = " << n << ", seed " << seed;
+                seen[image] = true;
+            }
+        }
+    }
+    // Different seeds give different permutations
+    size_t same = 0;
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        same += permuteIndex(i, 1000, 1) == permuteIndex(i, 1000, 2) ? 1 : 0;
+    }
+    EXPECT_LT(same, 20u);
+}
+
+TEST(LatinHypercubeTest, OneValuePerStratum) {
+    const size_t n = 5000;
+    std::vector<double> whole(n);
+    fillLatinHypercube(0, n, n, 17, whole.data());
+    expectOnePerStratum(whole.data(), n);
+    
+    // Slices of the design match the whole
+    std::vector<double> sliced(n);
+    for (size_t start = 0; start < n; start += 512) {
+        fillLatinHypercube(start, std::min<size_t>(512, n - start), n, 17, sliced.data() + start);
+    }
+    EXPECT_EQ(sliced, whole);
+}
+
+TEST(LatinHypercubeTest, EvaluatorStratifiesEveryReplicate) {
+    VariableRegistry registry;
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.registerVariable("v", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto u = ExpressionBuilder::variable("u");
+    auto v = ExpressionBuilder::variable("v");
+    // 3 replicates of 1000 samples; u and v sample their own strata
+    for (auto expr : {u.get(), (v * 1.0).get()}) {
+        SimulationResult result = runLatinHypercube(expr, registry, 3000, 3);
+        ASSERT_EQ(result.replicateMeans.size(), 3u);
+        for (size_t r = 0; r < 3; ++r) {
+            expectOnePerStratum(result.samples.data() + 1000 * r, 1000);
+            EXPECT_NEAR(result.replicateMeans[r], 0.5, 1e-3);
+        }
+    }
+}
+
+TEST(LatinHypercubeTest, StrataPairedAtRandom) {
+    VariableRegistry registry;
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.registerVariable("v", std::make_shared<UniformDistribution>(0.0, 1.0));
+    // E[u * v] = 1/4 only if the strata of u and v are not aligned
+    auto u = ExpressionBuilder::variable("u");
+    auto v = ExpressionBuilder::variable("v");
+    SimulationResult result = runLatinHypercube((u * v).get(), registry, 1 << 16, 16);
+    EXPECT_GT(result.standardError, 0.0);
+    EXPECT_LT(std::abs(result.mean - 0.25), 5.0 * result.standardError);
+}
+
+TEST(LatinHypercubeTest, SmallerErrorThanMonteCarlo) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(0.0, 1.0));
+    // Nearly additive: stratifying each marginal removes most of the variance
+    auto a = ExpressionBuilder::variable("a");
+    auto u = ExpressionBuilder::variable("u");
+    auto expr = (a + u * 2.0).get();
+    const size_t samples = 1 << 14;
+    SimulationResult latin = runLatinHypercube(expr, registry, samples, 16);
+    MonteCarloEvaluator plain(samples, 42);
+    SimulationResult random = plain.evaluate(expr, registry);
+    EXPECT_LT(latin.standardError * 10.0, random.standardError);
+    EXPECT_LT(std::abs(latin.mean - 6.0), 5.0 * latin.standardError);
+}
+
+TEST(LatinHypercubeTest, IndependentOfThreads) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto expr = (ExpressionBuilder::variable("a") * ExpressionBuilder::variable("u")).get();
+    SimulationResult expected = runLatinHypercube(expr, registry, 100000, 4);
+    for (size_t threads : {1, 3}) {
+        SimulationResult actual = runLatinHypercube(expr, registry, 100000, 4, threads);
+        EXPECT_EQ(actual.samples, expected.samples);
+        EXPECT_EQ(actual.standardError, expected.standardError);
+    }
+    EXPECT_NE(runLatinHypercube(expr, registry, 100000, 4, 0, 7).samples, expected.samples);
+}
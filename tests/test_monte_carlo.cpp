@@ -495,3 +495,169 @@ TEST(MonteCarloTest, ConvergenceMeanStabilizes) {
     // Later estimates should be more stable (lower variance from true mean)
     EXPECT_LT(secondHalfVar, firstHalfVar);
 }
+
+// Test a variable missing from the registry is reported before sampling
+TEST(MonteCarloTest, MissingVariableThrows) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    
+    auto x = std::make_shared<Variable>("x");
+    auto y = std::make_shared<Variable>("y");
+    auto expr = std::make_shared<BinaryOp>(x, y, BinaryOperator::Add);
+    
+    MonteCarloEvaluator evaluator(1000, 42);
+    EXPECT_THROW(evaluator.evaluate(expr, registry), std::out_of_range);
+}
+
+// Test unreferenced registry variables do not affect the results
+TEST(MonteCarloTest, UnreferencedVariablesNotSampled) {
+    VariableRegistry small;
+    small.registerVariable("x", std::make_shared<NormalDistribution>(10.0, 2.0));
+    small.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    
+    VariableRegistry large;
+    for (int i = 0; i < 50; ++i) {
+        large.registerVariable("factor" + std::to_string(i),
+                               std::make_shared<NormalDistribution>(0.0, 1.0));
+    }
+    large.registerVariable("x", std::make_shared<NormalDistribution>(10.0, 2.0));
+    large.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    large.registerVariable("z_unused", std::make_shared<UniformDistribution>(0.0, 1.0));
+    
+    auto x = std::make_shared<Variable>("x");
+    auto y = std::make_shared<Variable>("y");
+    auto expr = std::make_shared<BinaryOp>(x, y, BinaryOperator::Multiply);
+    
+    MonteCarloEvaluator smallEvaluator(2000, 42);
+    MonteCarloEvaluator largeEvaluator(2000, 42);
+    auto expected = smallEvaluator.evaluate(expr, small);
+    auto actual = largeEvaluator.evaluate(expr, large);
+    EXPECT_EQ(actual.samples, expected.samples);
+}
+
+// Test antithetic pairs mirror every variable of the drawn sample
+TEST(MonteCarloTest, AntitheticPairsMirror) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(3.0, 2.0));
+    registry.registerVariable("x", std::make_shared<UniformDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 1.0));
+    
+    MonteCarloEvaluator evaluator(1001, 42);
+    evaluator.setAntitheticVariates(true);
+    EXPECT_TRUE(evaluator.getAntitheticVariates());
+    
+    auto a = std::make_shared<Variable>("a");
+    auto normal = evaluator.evaluate(a, registry);
+    ASSERT_EQ(normal.samples.size(), 1001);
+    for (size_t k = 0; k + 1 < normal.samples.size(); k += 2) {
+        EXPECT_DOUBLE_EQ(normal.samples[k + 1], 6.0 - normal.samples[k]);
+    }
+    EXPECT_EQ(normal.pairCount, 500);  // The last sample is unpaired
+    EXPECT_EQ(normal.validSampleCount, 1001);
+    
+    auto x = std::make_shared<Variable>("x");
+    auto y = std::make_shared<Variable>("y");
+    auto diff = std::make_shared<BinaryOp>(x, y, BinaryOperator::Subtract);
+    auto result = evaluator.evaluate(diff, registry);
+    for (size_t k = 0; k + 1 < result.samples.size(); k += 2) {
+        EXPECT_NEAR(result.samples[k + 1], -result.samples[k], 1e-15);
+    }
+}
+
+// Test antithetic pairs reduce the standard error of a monotone expression
+// price ~ N(100, 15), quantity ~ U(10, 20), E[price * quantity] = 1500
+TEST(MonteCarloTest, AntitheticReducesStandardError) {
+    VariableRegistry registry;
+    registry.registerVariable("price", std::make_shared<NormalDistribution>(100.0, 15.0));
+    registry.registerVariable("quantity", std::make_shared<UniformDistribution>(10.0, 20.0));
+    
+    auto price = std::make_shared<Variable>("price");
+    auto quantity = std::make_shared<Variable>("quantity");
+    auto expr = std::make_shared<BinaryOp>(price, quantity, BinaryOperator::Multiply);
+    
+    MonteCarloEvaluator plain(100000, 42);
+    auto independent = plain.evaluate(expr, registry);
+    EXPECT_EQ(independent.pairCount, 0);
+    
+    MonteCarloEvaluator paired(100000, 42);
+    paired.setAntitheticVariates(true);
+    auto result = paired.evaluate(expr, registry);
+    EXPECT_EQ(result.pairCount, 50000);
+    EXPECT_LT(result.standardError, 0.5 * independent.standardError);
+    EXPECT_NEAR(result.mean, 1500.0, 5.0 * result.standardError);
+}
+
+// Test pairs with a NaN member are left out of the pair statistics
+TEST(MonteCarloTest, AntitheticDivideByZero) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(5.0, 1.0));
+    
+    auto x = std::make_shared<Variable>("x");
+    auto zero = std::make_shared<Constant>(0.0);
+    auto expr = std::make_shared<BinaryOp>(x, zero, BinaryOperator::Divide);
+    
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setAntitheticVariates(true);
+    auto result = evaluator.evaluate(expr, registry);
+    
+    EXPECT_EQ(result.validSampleCount, 0);
+    EXPECT_EQ(result.totalSampleCount, 1000);
+    EXPECT_EQ(result.pairCount, 0);
+    EXPECT_TRUE(std::isnan(result.mean));
+    EXPECT_TRUE(std::isnan(result.standardError));
+}
+
+// Test antithetic runs do not depend on the thread count
+TEST(MonteCarloTest, AntitheticThreadIndependent) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<UniformDistribution>(1.0, 2.0));
+    registry.registerVariable("y", std::make_shared<UniformDistribution>(0.0, 4.0));
+    
+    auto x = std::make_shared<Variable>("x");
+    auto y = std::make_shared<Variable>("y");
+    auto expr = std::make_shared<BinaryOp>(x, y, BinaryOperator::Divide);
+    
+    MonteCarloEvaluator single(100001, 42);
+    single.setRandomEngine(RandomEngine::Philox4x32);
+    single.setAntitheticVariates(true);
+    single.setThreadCount(1);
+    auto expected = single.evaluate(expr, registry);
+    
+    MonteCarloEvaluator multi(100001, 42);
+    multi.setRandomEngine(RandomEngine::Philox4x32);
+    multi.setAntitheticVariates(true);
+    multi.setThreadCount(4);
+    auto actual = multi.evaluate(expr, registry);
+    
+    EXPECT_EQ(actual.samples, expected.samples);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.standardError, expected.standardError);
+    EXPECT_EQ(actual.pairCount, expected.pairCount);
+    
+    // A partitioned sequential stream reproduces the sequential pairs
+    MonteCarloEvaluator sequential(1 << 20, 7);
+    sequential.setAntitheticVariates(true);
+    auto sequentialResult = sequential.evaluate(expr, registry);
+    
+    MonteCarloEvaluator partitioned(1 << 20, 7);
+    partitioned.setAntitheticVariates(true);
+    partitioned.setThreadCount(2);
+    partitioned.setPartitionSequentialStream(true);
+    auto partitionedResult = partitioned.evaluate(expr, registry);
+    EXPECT_EQ(partitionedResult.samples, sequentialResult.samples);
+    EXPECT_EQ(partitionedResult.mean, sequentialResult.mean);
+}
+
+// Test antithetic pairs require independent draws
+TEST(MonteCarloTest, AntitheticRequiresMonteCarlo) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto x = std::make_shared<Variable>("x");
+    
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setAntitheticVariates(true);
+    evaluator.setSamplingMethod(SamplingMethod::QuasiMonteCarlo);
+    EXPECT_THROW(evaluator.evaluate(x, registry), std::invalid_argument);
+    evaluator.setSamplingMethod(SamplingMethod::LatinHypercube);
+    EXPECT_THROW(evaluator.evaluate(x, registry), std::invalid_argument);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "mt19937_jump.h"
+#include "distribution.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace tt_int;
+
+namespace {
+
+std::mt19937 discarded(std::mt19937 rng, unsigned long long steps) {
+    rng.discard(steps);
+    return rng;
+}
+
+// Engines in the same logical state may store it differently (libstdc++
+// keeps an index into its word array), so compare what they generate; 1248
+// outputs cover two full state regenerations
+bool sameSequence(std::mt19937 a, std::mt19937 b) {
+    for (int i = 0; i < 1248; ++i) {
+        if (a() != b()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(Mt19937JumpTest, MatchesDiscard) {
+    std::mt19937 base(12345);
+    base.discard(17);  // Start mid-block
+    for (unsigned long long steps : {0ULL, 1ULL, 623ULL, 624ULL, 625ULL, 100000ULL,
+                                     (1ULL << 20) - 1, 1ULL << 20, (1ULL << 20) + 1,
+                                     3000017ULL}) {
+        SCOPED_TRACE(steps);
+        std::mt19937 jumped = base;
+        jumpAhead(jumped, steps);
+        EXPECT_TRUE(sameSequence(jumped, discarded(base, steps)));
+    }
+}
+
+TEST(Mt19937JumpTest, PowerOfTwoMatchesDiscard) {
+    std::mt19937 base(99);
+    for (unsigned exponent : {0u, 5u, 19u, 20u, 23u}) {
+        SCOPED_TRACE(exponent);
+        std::mt19937 jumped = base;
+        jumpAheadPow2(jumped, exponent);
+        EXPECT_TRUE(sameSequence(jumped, discarded(base, 1ULL << exponent)));
+    }
+}
+
+TEST(Mt19937JumpTest, JumpsCompose) {
+    // 2^70 cannot be checked with discard(), but two 2^69 jumps must agree
+    // with it, as must 2^40 and 2^41 - 2^40 in either order
+    std::mt19937 once(7);
+    jumpAheadPow2(once, 70);
+    std::mt19937 twice(7);
+    auto half = Mt19937Jump::powerOfTwo(69);
+    half.apply(twice);
+    half.apply(twice);
+    EXPECT_TRUE(sameSequence(once, twice));
+
+    std::mt19937 a(7), b(7);
+    jumpAhead(a, 1ULL << 40);
+    jumpAhead(a, 123456789ULL);
+    jumpAhead(b, 123456789ULL);
+    jumpAheadPow2(b, 40);
+    EXPECT_TRUE(sameSequence(a, b));
+    EXPECT_FALSE(sameSequence(a, std::mt19937(7)));
+}
+
+TEST(Mt19937JumpTest, ReusableAcrossEngines) {
+    Mt19937Jump jump(5000000);
+    for (unsigned seed : {1u, 2u, 3u}) {
+        std::mt19937 rng(seed);
+        jump.apply(rng);
+        EXPECT_TRUE(sameSequence(rng, discarded(std::mt19937(seed), 5000000)));
+    }
+}
+
+TEST(Mt19937JumpTest, CostIndependentOfDistance) {
+    std::mt19937 warmUp(1);
+    jumpAheadPow2(warmUp, 64);  // Computes the characteristic polynomial once
+
+    std::mt19937 rng(1);
+    auto start = std::chrono::steady_clock::now();
+    jumpAheadPow2(rng, 200);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(std::chrono::duration<double>(elapsed).count(), 2.0);
+}
+
+TEST(Mt19937JumpTest, UniformDrawCountMatchesEngineUse) {
+    UniformDistribution uniform(-2.0, 7.0);
+    ASSERT_EQ(uniform.getFixedDrawCount(), 2);
+    EXPECT_EQ(NormalDistribution(0.0, 1.0).getFixedDrawCount(), 0);
+
+    std::mt19937 rng(3);
+    for (int i = 0; i < 100; ++i) {
+        uniform.sample(rng);
+    }
+    EXPECT_TRUE(sameSequence(rng, discarded(std::mt19937(3), 200)));
+}
+
+TEST(Mt19937JumpTest, PartitionedRunsReproduceSequentialStream) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<UniformDistribution>(1.0, 2.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    registry.registerVariable("unused", std::make_shared<NormalDistribution>(0.0, 1.0));
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto expr = (a * b + a / b).get();
+
+    // Long enough for four ranges, not a multiple of the block size
+    const size_t samples = 1100003;
+    MonteCarloEvaluator sequential(samples, 42);
+    MonteCarloEvaluator parallel(samples, 42);
+    parallel.setThreadCount(4);
+    parallel.setPartitionSequentialStream(true);
+    EXPECT_TRUE(parallel.getPartitionSequentialStream());
+
+    // Consecutive runs continue the same stream
+    for (int run = 0; run < 2; ++run) {
+        SCOPED_TRACE(run);
+        auto expected = sequential.evaluate(expr, registry, -1);
+        auto actual = parallel.evaluate(expr, registry, -1);
+        EXPECT_TRUE(actual.partitionedStream);
+        EXPECT_FALSE(expected.partitionedStream);
+        ASSERT_EQ(actual.samples.size(), expected.samples.size());
+        for (size_t i = 0; i < samples; ++i) {
+            if (!std::isnan(expected.samples[i]) || !std::isnan(actual.samples[i])) {
+                ASSERT_EQ(actual.samples[i], expected.samples[i]) << "sample " << i;
+            }
+        }
+        EXPECT_EQ(actual.mean, expected.mean);
+        EXPECT_EQ(actual.stddev, expected.stddev);
+        EXPECT_EQ(actual.validSampleCount, expected.validSampleCount);
+        ASSERT_EQ(actual.convergenceHistory.size(), expected.convergenceHistory.size());
+        for (size_t i = 0; i < actual.convergenceHistory.size(); ++i) {
+            EXPECT_EQ(actual.convergenceHistory[i].mean, expected.convergenceHistory[i].mean);
+        }
+    }
+}
+
+TEST(Mt19937JumpTest, PartitioningFallsBackForRejectionSamplers) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(3.0, 1.0));
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto expr = (ExpressionBuilder::variable("x") * ExpressionBuilder::variable("u")).get();
+
+    MonteCarloEvaluator sequential(600000, 5);
+    MonteCarloEvaluator parallel(600000, 5);
+    parallel.setThreadCount(4);
+    parallel.setPartitionSequentialStream(true);
+    auto actual = parallel.evaluate(expr, registry);
+    EXPECT_FALSE(actual.partitionedStream);
+    EXPECT_EQ(actual.samples, sequential.evaluate(expr, registry).samples);
+}
+
+TEST(Mt19937JumpTest, BoxMullerNormalsPartition) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(3.0, 1.0, NormalSampler::BoxMuller));
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto expr = (ExpressionBuilder::variable("x") * ExpressionBuilder::variable("u")).get();
+
+    MonteCarloEvaluator sequential(600000, 5);
+    MonteCarloEvaluator parallel(600000, 5);
+    parallel.setThreadCount(2);
+    parallel.setPartitionSequentialStream(true);
+    for (int run = 0; run < 2; ++run) {
+        SCOPED_TRACE(run);
+        auto actual = parallel.evaluate(expr, registry);
+        auto expected = sequential.evaluate(expr, registry);
+        EXPECT_TRUE(actual.partitionedStream);
+        EXPECT_EQ(actual.samples, expected.samples);
+        EXPECT_EQ(actual.mean, expected.mean);
+    }
+}
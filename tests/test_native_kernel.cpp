@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+#include "native_kernel.h"
+#include "compiled_expression.h"
+#include "expression_builder.h"
+#include "monte_carlo_evaluator.h"
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace tt_int;
+
+namespace {
+
+// Fresh cache directory per test so cache hits are under the test's control
+class NativeKernelTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        cacheDirectory_ = std::filesystem::path(::testing::TempDir()) /
+            ("tt_int_kernels_" + std::to_string(getpid()) + "_" + info->name());
+        std::filesystem::remove_all(cacheDirectory_);
+        options_.cacheDirectory = cacheDirectory_.string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(cacheDirectory_);
+    }
+
+    std::filesystem::path cacheDirectory_;
+    NativeKernelOptions options_;
+};
+
+} // namespace
+
+TEST_F(NativeKernelTest, GeneratedSourceDefinesKernel) {
+    auto x = ExpressionBuilder::variable("x");
+    auto source = NativeKernel::generateSource(*(x / 3.0 + 0.1).get());
+    EXPECT_NE(source.find("extern \"C\" void tt_int_kernel"), std::string::npos);
+    EXPECT_NE(source.find("variables[0][i]"), std::string::npos);
+}
+
+TEST_F(NativeKernelTest, MatchesInterpreterBitForBit) {
+    auto x = ExpressionBuilder::variable("x");
+    auto y = ExpressionBuilder::variable("y");
+    auto expr = ((x + y) * 3.1 - x / (y - 2.0) + 0.1 / y) * (x - 1e-300);
+
+    auto kernel = NativeKernel::load(*expr.get(), options_);
+    if (!kernel) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    EXPECT_FALSE(kernel->isFromCache());
+
+    const size_t count = 64;
+    std::vector<double> xs(count), ys(count), expected(count), actual(count);
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = 0.37 * static_cast<double>(i) - 5.0;
+        ys[i] = static_cast<double>(i % 5);  // y == 0 and y == 2 hit the NaN paths
+    }
+    const double* columns[] = {xs.data(), ys.data()};
+
+    CompiledExpression program(*expr.get());
+    std::vector<double> registers(program.getRegisterCount() * count);
+    program.evaluateBatch(columns, count, expected.data(), registers.data());
+    kernel->run(columns, count, actual.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        if (std::isnan(expected[i])) {
+            EXPECT_TRUE(std::isnan(actual[i]));
+        } else {
+            EXPECT_EQ(actual[i], expected[i]);
+        }
+    }
+}
+
+TEST_F(NativeKernelTest, SpecialConstants) {
+    // Folded constants can be infinite or NaN
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x * 1e308 * 10.0 + (ExpressionBuilder::constant(1.0) / 0.0);
+
+    auto kernel = NativeKernel::load(*expr.get(), options_);
+    if (!kernel) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    const double xs[] = {1.0};
+    const double* columns[] = {xs};
+    double out;
+    kernel->run(columns, 1, &out);
+    EXPECT_TRUE(std::isnan(out));
+}
+
+TEST_F(NativeKernelTest, ReusesDiskCache) {
+    auto x = ExpressionBuilder::variable("x");
+    auto first = NativeKernel::load(*(x * x + 1.0).get(), options_);
+    if (!first) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    EXPECT_FALSE(first->isFromCache());
+
+    // A structurally identical, separately built expression hits the cache
+    auto y = ExpressionBuilder::variable("x");
+    auto second = NativeKernel::load(*(y * y + 1.0).get(), options_);
+    ASSERT_NE(second, nullptr);
+    EXPECT_TRUE(second->isFromCache());
+    EXPECT_EQ(second->getLibraryPath(), first->getLibraryPath());
+}
+
+TEST_F(NativeKernelTest, ConcurrentBuildsOfOneKernel) {
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x * 3.0 - 7.0;
+    std::vector<std::shared_ptr<NativeKernel>> kernels(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kernels.size(); ++t) {
+        threads.emplace_back([&, t] { kernels[t] = NativeKernel::load(*expr.get(), options_); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (!kernels[0]) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    for (const auto& kernel : kernels) {
+        ASSERT_NE(kernel, nullptr);
+        const double xs[] = {2.0};
+        const double* columns[] = {xs};
+        double out;
+        kernel->run(columns, 1, &out);
+        EXPECT_EQ(out, -1.0);
+    }
+    // Only the published entry is left behind
+    size_t entries = 0;
+    for (const auto& item : std::filesystem::directory_iterator(cacheDirectory_)) {
+        entries += item.is_directory() ? 1 : 0;
+    }
+    EXPECT_EQ(entries, 1);
+}
+
+TEST_F(NativeKernelTest, MismatchedEntryIsNotLoaded) {
+    auto x = ExpressionBuilder::variable("x");
+    auto first = NativeKernel::load(*(x + 5.0).get(), options_);
+    if (!first) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    // Stand-in for a collision: the entry claims to hold a different source
+    const auto entry = std::filesystem::path(first->getLibraryPath()).parent_path();
+    std::ofstream(entry / "kernel.cpp", std::ios::trunc) << "// another kernel\n";
+
+    auto second = NativeKernel::load(*(x + 5.0).get(), options_);
+    ASSERT_NE(second, nullptr);
+    EXPECT_FALSE(second->isFromCache());
+    EXPECT_NE(second->getLibraryPath(), first->getLibraryPath());
+    const double xs[] = {1.0};
+    const double* columns[] = {xs};
+    double out;
+    second->run(columns, 1, &out);
+    EXPECT_EQ(out, 6.0);
+}
+
+TEST_F(NativeKernelTest, MissingCompilerReturnsNull) {
+    options_.compiler = "/nonexistent/tt_int-compiler";
+    auto x = ExpressionBuilder::variable("x");
+    EXPECT_EQ(NativeKernel::load(*(x + 2.0).get(), options_), nullptr);
+}
+
+TEST_F(NativeKernelTest, TempFallbackSkipsUntrustedDirectory) {
+    // Only the temp dir is left to choose from
+    auto saved = [](const char* name) {
+        const char* value = std::getenv(name);
+        return value != nullptr ? std::optional<std::string>(value) : std::nullopt;
+    };
+    const std::vector<const char*> names = {"TT_INT_KERNEL_CACHE", "XDG_CACHE_HOME", "HOME", "TMPDIR"};
+    std::vector<std::optional<std::string>> values;
+    for (const char* name : names) {
+        values.push_back(saved(name));
+        unsetenv(name);
+    }
+    std::filesystem::create_directories(cacheDirectory_);
+    setenv("TMPDIR", cacheDirectory_.c_str(), 1);
+
+    // A directory under the expected name that others may write into
+    const auto planted = cacheDirectory_ / ("tt_int-kernels-" + std::to_string(getuid()));
+    std::filesystem::create_directory(planted);
+    std::filesystem::permissions(planted, std::filesystem::perms::all);
+
+    auto x = ExpressionBuilder::variable("x");
+    auto kernel = NativeKernel::load(*(x * 4.0 - 1.0).get());
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (values[i]) {
+            setenv(names[i], values[i]->c_str(), 1);
+        } else {
+            unsetenv(names[i]);
+        }
+    }
+    if (!kernel) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    const std::string library = kernel->getLibraryPath();
+    EXPECT_EQ(library.rfind(planted.string() + "/", 0), std::string::npos);
+    EXPECT_EQ(library.rfind(cacheDirectory_.string() + "/tt_int-kernels-", 0), 0);
+    EXPECT_TRUE(std::filesystem::is_empty(planted));
+}
+
+TEST_F(NativeKernelTest, EvaluatorMatchesInterpreter) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 2.0));
+    registry.registerVariable("unused", std::make_shared<NormalDistribution>(0.0, 1.0));
+
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto expr = (a * b - a / b) * (a * b) + 0.3;
+
+    MonteCarloEvaluator interpreted(2000, 11);
+    MonteCarloEvaluator native(2000, 11);
+    native.setNativeCodegen(true, options_);
+    auto expected = interpreted.evaluate(expr.get(), registry);
+    auto actual = native.evaluate(expr.get(), registry);
+    if (!actual.usedNativeKernel) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+
+    EXPECT_FALSE(expected.usedNativeKernel);
+    EXPECT_EQ(actual.samples, expected.samples);
+    EXPECT_EQ(actual.mean, expected.mean);
+}
+
+TEST_F(NativeKernelTest, EvaluatorFallsBackToInterpreter) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<UniformDistribution>(0.0, 1.0));
+    auto expr = ExpressionBuilder::variable("x") * 2.0;
+
+    options_.compiler = "/nonexistent/tt_int-compiler";
+    MonteCarloEvaluator interpreted(500, 3);
+    MonteCarloEvaluator native(500, 3);
+    native.setNativeCodegen(true, options_);
+    auto expected = interpreted.evaluate(expr.get(), registry);
+    auto actual = native.evaluate(expr.get(), registry);
+
+    EXPECT_FALSE(actual.usedNativeKernel);
+    EXPECT_EQ(actual.samples, expected.samples);
+}
+
+TEST_F(NativeKernelTest, EvaluatorCompilesGraphTape) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 2.0));
+
+    ExpressionGraph graph;
+    auto a = GraphExpressionBuilder::variable(graph, "a");
+    auto b = GraphExpressionBuilder::variable(graph, "b");
+    auto product = a * b;
+    auto expr = (product - a / b) * product + 0.3;
+
+    MonteCarloEvaluator interpreted(2000, 11);
+    MonteCarloEvaluator native(2000, 11);
+    native.setNativeCodegen(true, options_);
+    auto expected = interpreted.evaluate(graph, expr.getId(), registry);
+    auto actual = native.evaluate(graph, expr.getId(), registry);
+    if (!actual.usedNativeKernel) {
+        GTEST_SKIP() << "No working C++ compiler available";
+    }
+    EXPECT_EQ(actual.samples, expected.samples);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "pairwise_statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace tt_int;
+
+namespace {
+
+std::vector<double> randomValues(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> normal(1000.0, 3.0);
+    std::vector<double> values(count);
+    for (auto& value : values) {
+        value = normal(rng);
+    }
+    return values;
+}
+
+void expectSameStatistics(const SummaryStatistics& actual, const SummaryStatistics& expected) {
+    EXPECT_EQ(actual.count, expected.count);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.m2, expected.m2);
+    EXPECT_EQ(actual.min, expected.min);
+    EXPECT_EQ(actual.max, expected.max);
+}
+
+} // namespace
+
+TEST(PairwiseStatisticsTest, SummarizeBlock) {
+    const double values[] = {2.0, 4.0, NAN, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+    SummaryStatistics stats = summarizeBlock(values, 9);
+    EXPECT_EQ(stats.count, 8);
+    EXPECT_DOUBLE_EQ(stats.mean, 5.0);
+    EXPECT_DOUBLE_EQ(stats.m2, 32.0);
+    EXPECT_DOUBLE_EQ(stats.stddev(), std::sqrt(32.0 / 7.0));
+    EXPECT_EQ(stats.min, 2.0);
+    EXPECT_EQ(stats.max, 9.0);
+
+    SummaryStatistics empty = summarizeBlock(values + 2, 1);
+    EXPECT_EQ(empty.count, 0);
+    EXPECT_EQ(empty.stddev(), 0.0);
+}
+
+TEST(PairwiseStatisticsTest, CompensatedSummation) {
+    // 1e16 + 1 rounds back to 1e16, losing the 1 in a plain sum
+    const double values[] = {1e16, 1.0, -1e16};
+    EXPECT_EQ(summarizeBlock(values, 3).mean, 0.0);
+    EXPECT_EQ(summarizeBlock(values, 3, true).mean, 1.0 / 3.0);
+}
+
+TEST(PairwiseStatisticsTest, MergeMatchesWholeRange) {
+    auto values = randomValues(1000, 1);
+    SummaryStatistics merged = summarizeBlock(values.data(), 300);
+    merged.merge(summarizeBlock(values.data() + 300, 700));
+    SummaryStatistics whole = summarizeBlock(values.data(), 1000);
+    EXPECT_EQ(merged.count, whole.count);
+    EXPECT_NEAR(merged.mean, whole.mean, 1e-12);
+    EXPECT_NEAR(merged.m2, whole.m2, 1e-9 * whole.m2);
+    EXPECT_EQ(merged.min, whole.min);
+    EXPECT_EQ(merged.max, whole.max);
+
+    // Merging nothing, or into nothing, is exact
+    SummaryStatistics copy = whole;
+    copy.merge(SummaryStatistics());
+    expectSameStatistics(copy, whole);
+    SummaryStatistics empty;
+    empty.merge(whole);
+    expectSameStatistics(empty, whole);
+}
+
+TEST(PairwiseStatisticsTest, FixedTreeShape) {
+    auto values = randomValues(8 * 16, 2);
+    std::vector<SummaryStatistics> blocks;
+    PairwiseReducer reducer;
+    for (size_t b = 0; b < 8; ++b) {
+        blocks.push_back(summarizeBlock(values.data() + 16 * b, 16));
+        reducer.add(blocks.back());
+    }
+    EXPECT_EQ(reducer.getBlockCount(), 8);
+
+    // ((b0 b1)(b2 b3))((b4 b5)(b6 b7))
+    for (size_t step = 1; step < 8; step *= 2) {
+        for (size_t b = 0; b + step < 8; b += 2 * step) {
+            blocks[b].merge(blocks[b + step]);
+        }
+    }
+    expectSameStatistics(reducer.total(), blocks[0]);
+}
+
+TEST(PairwiseStatisticsTest, AlignedChunksReproduceBlockOrder) {
+    // 4 blocks per chunk, 37 blocks: 9 full chunks and a partial one
+    const size_t blockSize = 8;
+    const size_t blockCount = 37;
+    auto values = randomValues(blockSize * blockCount, 3);
+
+    PairwiseReducer sequential;
+    for (size_t b = 0; b < blockCount; ++b) {
+        sequential.add(summarizeBlock(values.data() + b * blockSize, blockSize));
+    }
+
+    std::vector<PairwiseReducer> chunks((blockCount + 3) / 4);
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (size_t b = 4 * c; b < std::min(4 * c + 4, blockCount); ++b) {
+            chunks[c].add(summarizeBlock(values.data() + b * blockSize, blockSize));
+        }
+    }
+    PairwiseReducer combined;
+    for (const auto& chunk : chunks) {
+        combined.append(chunk);
+    }
+    EXPECT_EQ(combined.getBlockCount(), blockCount);
+    expectSameStatistics(combined.total(), sequential.total());
+}
+
+TEST(PairwiseStatisticsTest, AccurateForLargeOffsets) {
+    // Tiny spread on a large offset, where naive accumulation loses digits
+    const size_t count = 1 << 20;
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = 1e9 + (i % 2 == 0 ? 0.5 : -0.5);
+    }
+    PairwiseReducer reducer;
+    for (size_t start = 0; start < count; start += 512) {
+        reducer.add(summarizeBlock(values.data() + start, 512, true));
+    }
+    SummaryStatistics stats = reducer.total();
+    EXPECT_EQ(stats.mean, 1e9);
+    EXPECT_NEAR(stats.m2, 0.25 * count, 1e-9 * count);
+}
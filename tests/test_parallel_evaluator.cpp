@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include "pairwise_statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+using namespace tt_int;
+
+namespace {
+
+VariableRegistry makeRegistry() {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    return registry;
+}
+
+std::shared_ptr<Expression> makeExpression() {
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    return (a * b + a / b).get();
+}
+
+SimulationResult runWithThreads(size_t threads, size_t samples, int interval, unsigned seed = 42) {
+    MonteCarloEvaluator evaluator(samples, seed);
+    evaluator.setThreadCount(threads);
+    return evaluator.evaluate(makeExpression(), makeRegistry(), interval);
+}
+
+// Bitwise equality, treating NaN samples as equal to each other
+void expectIdentical(const SimulationResult& actual, const SimulationResult& expected) {
+    ASSERT_EQ(actual.samples.size(), expected.samples.size());
+    for (size_t i = 0; i < actual.samples.size(); ++i) {
+        if (std::isnan(expected.samples[i])) {
+            ASSERT_TRUE(std::isnan(actual.samples[i])) << "sample " << i;
+        } else {
+            ASSERT_EQ(actual.samples[i], expected.samples[i]) << "sample " << i;
+        }
+    }
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.stddev, expected.stddev);
+    EXPECT_EQ(actual.min, expected.min);
+    EXPECT_EQ(actual.max, expected.max);
+    EXPECT_EQ(actual.validSampleCount, expected.validSampleCount);
+
+    ASSERT_EQ(actual.convergenceHistory.size(), expected.convergenceHistory.size());
+    for (size_t i = 0; i < actual.convergenceHistory.size(); ++i) {
+        EXPECT_EQ(actual.convergenceHistory[i].sampleCount, expected.convergenceHistory[i].sampleCount);
+        EXPECT_EQ(actual.convergenceHistory[i].validCount, expected.convergenceHistory[i].validCount);
+        EXPECT_EQ(actual.convergenceHistory[i].mean, expected.convergenceHistory[i].mean);
+        EXPECT_EQ(actual.convergenceHistory[i].stddev, expected.convergenceHistory[i].stddev);
+    }
+}
+
+} // namespace
+
+TEST(ParallelEvaluatorTest, DefaultIsSequential) {
+    MonteCarloEvaluator evaluator(10, 1);
+    EXPECT_EQ(evaluator.getThreadCount(), 0);
+    evaluator.setThreadCount(0);
+    EXPECT_GE(evaluator.getThreadCount(), 1);
+}
+
+TEST(ParallelEvaluatorTest, IdenticalAcrossThreadCounts) {
+    // Not a multiple of the chunk size, with smart convergence intervals
+    const size_t samples = 100003;
+    auto reference = runWithThreads(1, samples, -1);
+    for (size_t threads : {2, 3, 8}) {
+        SCOPED_TRACE(threads);
+        expectIdentical(runWithThreads(threads, samples, -1), reference);
+    }
+}
+
+TEST(ParallelEvaluatorTest, FixedIntervalConvergenceIdentical) {
+    auto reference = runWithThreads(1, 50000, 777);
+    auto parallel = runWithThreads(4, 50000, 777);
+    expectIdentical(parallel, reference);
+    ASSERT_FALSE(reference.convergenceHistory.empty());
+    EXPECT_EQ(reference.convergenceHistory.back().sampleCount, 50000);
+}
+
+TEST(ParallelEvaluatorTest, MergedStatisticsMatchSamples) {
+    auto result = runWithThreads(4, 70000, -1);
+
+    std::vector<double> valid;
+    for (double sample : result.samples) {
+        if (!std::isnan(sample)) {
+            valid.push_back(sample);
+        }
+    }
+    ASSERT_EQ(result.validSampleCount, valid.size());
+    double mean = std::accumulate(valid.begin(), valid.end(), 0.0) / valid.size();
+    double squares = 0.0;
+    for (double value : valid) {
+        squares += (value - mean) * (value - mean);
+    }
+    double stddev = std::sqrt(squares / (valid.size() - 1));
+
+    EXPECT_NEAR(result.mean, mean, 1e-9 * std::abs(mean));
+    EXPECT_NEAR(result.stddev, stddev, 1e-9 * stddev);
+
+    // Every convergence point's statistics cover exactly its prefix
+    for (const auto& point : result.convergenceHistory) {
+        size_t validInPrefix = 0;
+        for (size_t i = 0; i < point.sampleCount; ++i) {
+            validInPrefix += std::isnan(result.samples[i]) ? 0 : 1;
+        }
+        EXPECT_EQ(point.validCount, validInPrefix);
+    }
+}
+
+TEST(ParallelEvaluatorTest, SeedsAndRunsGiveDifferentStreams) {
+    auto first = runWithThreads(2, 1000, 0, 42);
+    auto sameSeed = runWithThreads(3, 1000, 0, 42);
+    auto otherSeed = runWithThreads(2, 1000, 0, 43);
+    EXPECT_EQ(first.samples, sameSeed.samples);
+    EXPECT_NE(first.samples, otherSeed.samples);
+
+    // Consecutive runs on one evaluator draw new samples, reproducibly
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setThreadCount(2);
+    auto run1 = evaluator.evaluate(makeExpression(), makeRegistry());
+    auto run2 = evaluator.evaluate(makeExpression(), makeRegistry());
+    EXPECT_EQ(run1.samples, first.samples);
+    EXPECT_NE(run2.samples, run1.samples);
+}
+
+TEST(ParallelEvaluatorTest, ChunksAreIndependentStreams) {
+    // The first samples of consecutive chunks must not repeat each other
+    auto result = runWithThreads(2, 40000, 0);
+    const size_t chunk = 16384;
+    EXPECT_NE(result.samples[0], result.samples[chunk]);
+    EXPECT_NE(result.samples[1], result.samples[chunk + 1]);
+}
+
+TEST(ParallelEvaluatorTest, ChunkStreamsSeededLikeSeedSeq) {
+    // Chunk c of run r draws from mt19937(seed_seq{seed, r, c}), 32-bit halves
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(1.0, 2.0));
+    MonteCarloEvaluator evaluator(40000, 42);
+    evaluator.setThreadCount(2);
+    auto result = evaluator.evaluate(ExpressionBuilder::variable("x").get(), registry);
+
+    const size_t chunkSize = 16384;
+    for (std::uint32_t chunk = 0; chunk < 3; ++chunk) {
+        std::seed_seq seeds = {42u, 0u, 0u, 0u, chunk, 0u};
+        std::mt19937 rng(seeds);
+        auto states = registry.makeSamplerStates();
+        for (size_t i = 0; i < 100; ++i) {
+            EXPECT_EQ(result.samples[chunk * chunkSize + i], registry.sampleAll(rng, states).at("x"));
+        }
+    }
+}
+
+TEST(ParallelEvaluatorTest, StatisticallySound) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(100.0, 15.0));
+
+    MonteCarloEvaluator evaluator(200000, 7);
+    evaluator.setThreadCount(4);
+    auto result = evaluator.evaluate(std::make_shared<Variable>("x"), registry);
+    EXPECT_NEAR(result.mean, 100.0, 0.2);
+    EXPECT_NEAR(result.stddev, 15.0, 0.2);
+}
+
+TEST(ParallelEvaluatorTest, AllNaN) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<UniformDistribution>(1.0, 2.0));
+    auto x = ExpressionBuilder::variable("x");
+
+    MonteCarloEvaluator evaluator(30000, 7);
+    evaluator.setThreadCount(3);
+    auto result = evaluator.evaluate((x / (x - x)).get(), registry, 10000);
+    EXPECT_EQ(result.validSampleCount, 0);
+    EXPECT_TRUE(std::isnan(result.mean));
+    ASSERT_EQ(result.convergenceHistory.size(), 3);
+    EXPECT_TRUE(std::isnan(result.convergenceHistory[0].mean));
+}
+
+TEST(ParallelEvaluatorTest, RegistrySharedByConcurrentEvaluators) {
+    // Each evaluator owns its stream and sampler state; the registry is only read
+    const VariableRegistry shared = makeRegistry();
+    const unsigned seeds[] = {1, 2, 3, 4};
+    std::vector<SimulationResult> concurrent(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            MonteCarloEvaluator evaluator(20001, seeds[t]);
+            concurrent[t] = evaluator.evaluate(makeExpression(), shared, -1);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t t = 0; t < 4; ++t) {
+        SCOPED_TRACE(t);
+        MonteCarloEvaluator alone(20001, seeds[t]);
+        expectIdentical(concurrent[t], alone.evaluate(makeExpression(), makeRegistry(), -1));
+    }
+
+    // Interleaved runs on one registry do not disturb each other's streams
+    MonteCarloEvaluator first(7, 42);
+    MonteCarloEvaluator second(7, 42);
+    auto a1 = first.evaluate(makeExpression(), shared);
+    auto b1 = second.evaluate(makeExpression(), shared);
+    auto a2 = first.evaluate(makeExpression(), shared);
+    auto b2 = second.evaluate(makeExpression(), shared);
+    EXPECT_EQ(a1.samples, b1.samples);
+    EXPECT_EQ(a2.samples, b2.samples);
+    EXPECT_NE(a1.samples, a2.samples);
+}
+
+TEST(ParallelEvaluatorTest, PreparedChunksInAnyOrder) {
+    auto expected = runWithThreads(3, 50001, -1);
+
+    MonteCarloEvaluator evaluator(50001, 42);
+    auto registry = makeRegistry();
+    ChunkedEvaluation run = evaluator.prepareChunks(makeExpression(), registry, -1);
+    ASSERT_EQ(run.getChunkCount(), 4);
+    for (size_t chunk = run.getChunkCount(); chunk-- > 0;) {
+        run.runChunk(chunk);
+    }
+    EXPECT_THROW(run.runChunk(4), std::out_of_range);
+    expectIdentical(run.finish(), expected);
+
+    // Preparing counts as a run, like a parallel evaluate()
+    evaluator.setThreadCount(2);
+    EXPECT_NE(evaluator.evaluate(makeExpression(), registry).samples, expected.samples);
+}
+
+TEST(ParallelEvaluatorTest, StatisticsFollowFixedBlockTree) {
+    // Reducing the samples block by block on one thread gives the same bits
+    for (bool compensated : {false, true}) {
+        SCOPED_TRACE(compensated);
+        MonteCarloEvaluator evaluator(100003, 42);
+        evaluator.setThreadCount(3);
+        evaluator.setCompensatedSummation(compensated);
+        EXPECT_EQ(evaluator.getCompensatedSummation(), compensated);
+        auto result = evaluator.evaluate(makeExpression(), makeRegistry());
+
+        PairwiseReducer reducer;
+        for (size_t start = 0; start < result.samples.size(); start += 512) {
+            const size_t count = std::min<size_t>(512, result.samples.size() - start);
+            reducer.add(summarizeBlock(result.samples.data() + start, count, compensated));
+        }
+        SummaryStatistics expected = reducer.total();
+        EXPECT_EQ(result.validSampleCount, expected.count);
+        EXPECT_EQ(result.mean, expected.mean);
+        EXPECT_EQ(result.stddev, expected.stddev());
+        EXPECT_EQ(result.min, expected.min);
+        EXPECT_EQ(result.max, expected.max);
+    }
+}
+
+TEST(ParallelEvaluatorTest, CompensatedIdenticalAcrossThreadCounts) {
+    std::vector<SimulationResult> results;
+    for (size_t threads : {1, 2, 5}) {
+        MonteCarloEvaluator evaluator(80000, 9);
+        evaluator.setThreadCount(threads);
+        evaluator.setCompensatedSummation(true);
+        results.push_back(evaluator.evaluate(makeExpression(), makeRegistry(), 1000));
+    }
+    expectIdentical(results[1], results[0]);
+    expectIdentical(results[2], results[0]);
+}
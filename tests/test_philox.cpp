@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "philox.h"
+#include "distribution.h"
+#include "variable_registry.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace tt_int;
+
+// Known-answer vectors from the Random123 distribution (kat_vectors)
+TEST(PhiloxTest, KnownAnswers) {
+    EXPECT_EQ(Philox4x32::block({0, 0, 0, 0}, {0, 0}),
+              (Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(Philox4x32::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                {0xffffffff, 0xffffffff}),
+              (Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(Philox4x32::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                {0xa4093822, 0x299f31d0}),
+              (Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(PhiloxTest, EngineYieldsBlocksInOrder) {
+    Philox4x32 rng(0x0123456789abcdefULL, 7);
+    for (std::uint32_t blockIndex = 0; blockIndex < 3; ++blockIndex) {
+        auto expected = Philox4x32::block({blockIndex, 0, 7, 0}, {0x89abcdef, 0x01234567});
+        for (std::uint32_t word : expected) {
+            EXPECT_EQ(rng(), word);
+        }
+    }
+}
+
+TEST(PhiloxTest, RandomAccessMatchesSequentialDraws) {
+    Philox4x32 sequential(42, 3);
+    std::vector<std::uint32_t> draws(103);
+    for (auto& draw : draws) {
+        draw = sequential();
+    }
+
+    for (std::uint64_t position : {0, 1, 3, 4, 5, 64, 101}) {
+        Philox4x32 jumped(42, 3);
+        jumped.setPosition(position);
+        EXPECT_EQ(jumped.getPosition(), position);
+        EXPECT_EQ(jumped(), draws[position]);
+        EXPECT_EQ(jumped.getPosition(), position + 1);
+    }
+
+    Philox4x32 discarded(42, 3);
+    discarded();
+    discarded.discard(10);
+    EXPECT_EQ(discarded(), draws[11]);
+    EXPECT_EQ(discarded, [&] { Philox4x32 rng(42, 3); rng.setPosition(12); return rng; }());
+}
+
+TEST(PhiloxTest, StreamsAndSeedsDiffer) {
+    Philox4x32 a(1, 0);
+    Philox4x32 b(1, 1);
+    Philox4x32 c(2, 0);
+    int equalAB = 0;
+    int equalAC = 0;
+    for (int i = 0; i < 64; ++i) {
+        auto va = a();
+        equalAB += va == b() ? 1 : 0;
+        equalAC += va == c() ? 1 : 0;
+    }
+    EXPECT_LT(equalAB, 2);
+    EXPECT_LT(equalAC, 2);
+}
+
+TEST(PhiloxTest, WorksWithStandardDistributions) {
+    Philox4x32 rng(2024);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double sum = 0.0;
+    const int count = 100000;
+    for (int i = 0; i < count; ++i) {
+        double value = uniform(rng);
+        ASSERT_GE(value, 0.0);
+        ASSERT_LT(value, 1.0);
+        sum += value;
+    }
+    EXPECT_NEAR(sum / count, 0.5, 0.01);
+}
+
+TEST(PhiloxTest, DistributionSampling) {
+    NormalDistribution normal(10.0, 2.0);
+    Philox4x32 rng(5);
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    const int count = 100000;
+    for (int i = 0; i < count; ++i) {
+        double value = normal.sample(rng);
+        sum += value;
+        sumSquares += value * value;
+    }
+    double mean = sum / count;
+    EXPECT_NEAR(mean, 10.0, 0.05);
+    EXPECT_NEAR(std::sqrt(sumSquares / count - mean * mean), 2.0, 0.05);
+
+    VariableRegistry registry;
+    registry.registerVariable("u", std::make_shared<UniformDistribution>(3.0, 4.0));
+    auto samples = registry.sampleAll(rng);
+    EXPECT_GE(samples["u"], 3.0);
+    EXPECT_LE(samples["u"], 4.0);
+}
+
+TEST(PhiloxTest, EvaluatorSequentialMatchesParallel) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 2.0));
+    auto expr = (ExpressionBuilder::variable("a") * ExpressionBuilder::variable("b")).get();
+
+    MonteCarloEvaluator sequential(60000, 42);
+    sequential.setRandomEngine(RandomEngine::Philox4x32);
+    EXPECT_EQ(sequential.getRandomEngine(), RandomEngine::Philox4x32);
+    auto expected = sequential.evaluate(expr, registry, -1);
+
+    for (size_t threads : {1, 4}) {
+        MonteCarloEvaluator parallel(60000, 42);
+        parallel.setRandomEngine(RandomEngine::Philox4x32);
+        parallel.setThreadCount(threads);
+        auto actual = parallel.evaluate(expr, registry, -1);
+        EXPECT_EQ(actual.samples, expected.samples);
+        EXPECT_EQ(actual.mean, expected.mean);
+        EXPECT_EQ(actual.stddev, expected.stddev);
+        ASSERT_EQ(actual.convergenceHistory.size(), expected.convergenceHistory.size());
+        EXPECT_EQ(actual.convergenceHistory.back().mean, expected.convergenceHistory.back().mean);
+    }
+
+    // Statistically sound and different from the Mersenne Twister stream
+    EXPECT_NEAR(expected.mean, 7.5, 0.05);
+    MonteCarloEvaluator mt(60000, 42);
+    EXPECT_NE(mt.evaluate(expr, registry).samples, expected.samples);
+}
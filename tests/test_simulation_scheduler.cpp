@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "simulation_scheduler.h"
+#include "expression_builder.h"
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace tt_int;
+
+namespace {
+
+// a * b + a / b over registry, which defines a and b
+SimulationJob makeJob(std::shared_ptr<const VariableRegistry> registry, size_t samples, unsigned seed,
+                      RandomEngine engine = RandomEngine::Mt19937, int interval = 0) {
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    SimulationJob job;
+    job.expression = (a * b + a / b).get();
+    job.registry = std::move(registry);
+    job.numSamples = samples;
+    job.seed = seed;
+    job.engine = engine;
+    job.convergenceInterval = interval;
+    return job;
+}
+
+// What a standalone parallel evaluator returns for the same job
+SimulationResult evaluateAlone(const SimulationJob& job) {
+    MonteCarloEvaluator evaluator(job.numSamples, job.seed);
+    evaluator.setRandomEngine(job.engine);
+    evaluator.setThreadCount(2);
+    return evaluator.evaluate(job.expression, *job.registry, job.convergenceInterval);
+}
+
+void expectSameResult(const SimulationResult& actual, const SimulationResult& expected) {
+    ASSERT_EQ(actual.samples.size(), expected.samples.size());
+    for (size_t i = 0; i < actual.samples.size(); ++i) {
+        if (std::isnan(expected.samples[i])) {
+            ASSERT_TRUE(std::isnan(actual.samples[i])) << "sample " << i;
+        } else {
+            ASSERT_EQ(actual.samples[i], expected.samples[i]) << "sample " << i;
+        }
+    }
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.stddev, expected.stddev);
+    EXPECT_EQ(actual.validSampleCount, expected.validSampleCount);
+    ASSERT_EQ(actual.convergenceHistory.size(), expected.convergenceHistory.size());
+    for (size_t i = 0; i < actual.convergenceHistory.size(); ++i) {
+        EXPECT_EQ(actual.convergenceHistory[i].sampleCount, expected.convergenceHistory[i].sampleCount);
+        EXPECT_EQ(actual.convergenceHistory[i].mean, expected.convergenceHistory[i].mean);
+    }
+}
+
+} // namespace
+
+TEST(SimulationSchedulerTest, DefaultThreadCount) {
+    SimulationScheduler scheduler;
+    EXPECT_GE(scheduler.getThreadCount(), 1);
+    EXPECT_EQ(SimulationScheduler(3).getThreadCount(), 3);
+}
+
+TEST(SimulationSchedulerTest, ResultsMatchStandaloneEvaluator) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+
+    // Large and small jobs of every engine, all in flight at once
+    std::vector<SimulationJob> jobs = {
+        makeJob(registry, 100003, 1, RandomEngine::Mt19937, -1),
+        makeJob(registry, 500, 2),
+        makeJob(registry, 70000, 3, RandomEngine::Philox4x32, 1000),
+        makeJob(registry, 17, 4, RandomEngine::Xoshiro256PlusPlus),
+        makeJob(registry, 40000, 5, RandomEngine::Xoroshiro128Plus, -1),
+        makeJob(registry, 16384, 6),
+    };
+    SimulationScheduler scheduler(4);
+    std::vector<std::future<SimulationResult>> futures;
+    for (const auto& job : jobs) {
+        futures.push_back(scheduler.submit(job));
+    }
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        SCOPED_TRACE(i);
+        expectSameResult(futures[i].get(), evaluateAlone(jobs[i]));
+    }
+}
+
+TEST(SimulationSchedulerTest, IndependentOfPoolSize) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    const SimulationJob job = makeJob(registry, 90000, 11, RandomEngine::Mt19937, -1);
+    auto expected = SimulationScheduler(1).submit(job).get();
+    for (size_t threads : {2, 7}) {
+        SCOPED_TRACE(threads);
+        SimulationScheduler scheduler(threads);
+        expectSameResult(scheduler.submit(job).get(), expected);
+    }
+}
+
+TEST(SimulationSchedulerTest, ManySmallJobsShareOneRegistry) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    SimulationScheduler scheduler(4);
+    std::vector<std::future<SimulationResult>> futures;
+    for (unsigned seed = 0; seed < 300; ++seed) {
+        futures.push_back(scheduler.submit(makeJob(registry, 1000, seed)));
+    }
+    for (auto& future : futures) {
+        SimulationResult result = future.get();
+        EXPECT_EQ(result.samples.size(), 1000);
+        EXPECT_EQ(result.totalSampleCount, 1000);
+        EXPECT_GT(result.validSampleCount, 0);
+    }
+}
+
+TEST(SimulationSchedulerTest, ErrorsArriveThroughTheFuture) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    SimulationScheduler scheduler(2);
+    SimulationJob job = makeJob(registry, 1000, 1);
+    job.expression = ExpressionBuilder::variable("missing").get();
+    auto failed = scheduler.submit(job);
+    auto fine = scheduler.submit(makeJob(registry, 1000, 1));
+    EXPECT_THROW(failed.get(), std::out_of_range);
+    EXPECT_EQ(fine.get().samples.size(), 1000);
+
+    SimulationJob empty;
+    EXPECT_THROW(scheduler.submit(empty), std::invalid_argument);
+}
+
+TEST(SimulationSchedulerTest, EmptyJob) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    SimulationScheduler scheduler(2);
+    auto result = scheduler.submit(makeJob(registry, 0, 1)).get();
+    EXPECT_TRUE(result.samples.empty());
+    EXPECT_EQ(result.validSampleCount, 0);
+    EXPECT_TRUE(std::isnan(result.mean));
+}
+
+TEST(SimulationSchedulerTest, DestructorFinishesPendingJobs) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(-1.0, 3.0));
+    std::vector<std::future<SimulationResult>> futures;
+    {
+        SimulationScheduler scheduler(2);
+        for (unsigned seed = 0; seed < 20; ++seed) {
+            futures.push_back(scheduler.submit(makeJob(registry, 20000, seed)));
+        }
+    }
+    for (auto& future : futures) {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_EQ(future.get().samples.size(), 20000);
+    }
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include "sobol_sequence.h"
+#include "monte_carlo_evaluator.h"
+#include "simulation_scheduler.h"
+#include "expression_builder.h"
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tt_int;
+
+namespace {
+
+// Every one of 2^m points falls into its own interval of width 2^-m
+void expectStratified(const std::vector<std::uint32_t>& points, int m) {
+    std::set<std::uint32_t> cells;
+    for (std::uint32_t point : points) {
+        cells.insert(point >> (32 - m));
+    }
+    EXPECT_EQ(cells.size(), size_t(1) << m);
+}
+
+SimulationResult runQuasiRandom(const std::shared_ptr<Expression>& expr, const VariableRegistry& registry,
+                                size_t samples, size_t threads, unsigned seed = 42) {
+    MonteCarloEvaluator evaluator(samples, seed);
+    evaluator.setSamplingMethod(SamplingMethod::QuasiMonteCarlo);
+    evaluator.setThreadCount(threads);
+    return evaluator.evaluate(expr, registry);
+}
+
+} // namespace
+
+TEST(SobolSequenceTest, FirstPoints) {
+    SobolSequence sobol(2);
+    // Gray-code order: indices 0, 1, 3, 2 of the natural sequence
+    const double expected0[] = {0.0, 0.5, 0.75, 0.25};
+    const double expected1[] = {0.0, 0.5, 0.25, 0.75};
+    for (size_t n = 0; n < 4; ++n) {
+        EXPECT_EQ(sobol.point(n, 0) * 0x1p-32, expected0[n]);
+        EXPECT_EQ(sobol.point(n, 1) * 0x1p-32, expected1[n]);
+    }
+    EXPECT_THROW(SobolSequence(SobolSequence::MAX_DIMENSIONS + 1), std::invalid_argument);
+}
+
+TEST(SobolSequenceTest, FillMatchesPoint) {
+    SobolSequence sobol(SobolSequence::MAX_DIMENSIONS);
+    std::vector<std::uint32_t> points(1000);
+    for (size_t d = 0; d < sobol.getDimensions(); d += 7) {
+        sobol.fill(123456789, points.size(), d, points.data());
+        for (size_t i = 0; i < points.size(); i += 37) {
+            ASSERT_EQ(points[i], sobol.point(123456789 + i, d)) << "dimension " << d;
+        }
+    }
+}
+
+TEST(SobolSequenceTest, EveryDimensionIsStratified) {
+    SobolSequence sobol(SobolSequence::MAX_DIMENSIONS);
+    std::vector<std::uint32_t> points(1024);
+    for (size_t d = 0; d < sobol.getDimensions(); ++d) {
+        sobol.fill(0, points.size(), d, points.data());
+        expectStratified(points, 10);
+        // Scrambling keeps the stratification
+        for (auto& point : points) {
+            point = owenScramble(point, 0x9e3779b9u + static_cast<std::uint32_t>(d));
+        }
+        expectStratified(points, 10);
+    }
+}
+
+TEST(SobolSequenceTest, FirstTwoDimensionsFormNet) {
+    // The first 2^8 points of dimensions 0 and 1, scrambled or not, put one
+    // point in every 2^-k by 2^-(8-k) box
+    SobolSequence sobol(2);
+    for (std::uint32_t seed : {0u, 12345u}) {
+        std::vector<std::uint32_t> x(256), y(256);
+        sobol.fill(0, 256, 0, x.data());
+        sobol.fill(0, 256, 1, y.data());
+        for (size_t i = 0; i < 256 && seed != 0; ++i) {
+            x[i] = owenScramble(x[i], seed);
+            y[i] = owenScramble(y[i], seed * 7 + 1);
+        }
+        for (int k = 0; k <= 8; ++k) {
+            std::set<std::pair<std::uint32_t, std::uint32_t>> boxes;
+            for (size_t i = 0; i < 256; ++i) {
+                boxes.insert({k == 0 ? 0 : x[i] >> (32 - k), k == 8 ? 0 : y[i] >> (24 + k)});
+            }
+            EXPECT_EQ(boxes.size(), 256u) << "k = " << k << ", seed " << seed;
+        }
+    }
+}
+
+TEST(SobolSequenceTest, OwenScrambleIsNested) {
+    // Values sharing their leading bits keep sharing them after scrambling
+    const std::uint32_t seed = 0xdeadbeefu;
+    std::set<std::uint32_t> images;
+    for (std::uint32_t high = 0; high < 256; ++high) {
+        const std::uint32_t a = owenScramble((high << 24) | 0x00123456u, seed);
+        const std::uint32_t b = owenScramble((high << 24) | 0x00fedcbau, seed);
+        EXPECT_EQ(a >> 24, b >> 24);
+        images.insert(a >> 24);
+    }
+    EXPECT_EQ(images.size(), 256u);  // A permutation of the leading byte
+}
+
+TEST(QuasiMonteCarloTest, ReplicatesEstimateError) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 3.0));
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    
+    // E[a * b + a] = 5 * 2 + 5
+    SimulationResult result = runQuasiRandom((a * b + a).get(), registry, 1 << 16, 0);
+    ASSERT_EQ(result.replicateMeans.size(), 16u);
+    EXPECT_EQ(result.validSampleCount, size_t(1) << 16);
+    EXPECT_GT(result.standardError, 0.0);
+    EXPECT_LT(std::abs(result.mean - 15.0), 6.0 * result.standardError);
+    // Var(a * (b + 1)) = E[a^2] E[(b + 1)^2] - 15^2 = 26 * 28 / 3 - 225
+    EXPECT_NEAR(result.stddev, std::sqrt(26.0 * 28.0 / 3.0 - 225.0), 0.01);
+    
+    double sum = 0.0;
+    for (double mean : result.replicateMeans) {
+        sum += mean;
+    }
+    EXPECT_NEAR(sum / 16.0, result.mean, 1e-12);
+}
+
+TEST(QuasiMonteCarloTest, FarSmallerErrorThanMonteCarlo) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 3.0));
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto expr = (a * b + a).get();
+    
+    const size_t samples = 1 << 16;
+    SimulationResult quasi = runQuasiRandom(expr, registry, samples, 0);
+    MonteCarloEvaluator plain(samples, 42);
+    SimulationResult random = plain.evaluate(expr, registry);
+    
+    EXPECT_TRUE(random.replicateMeans.empty());
+    EXPECT_DOUBLE_EQ(random.standardError, random.stddev / std::sqrt(static_cast<double>(samples)));
+    // Matching the quasi-random error would take well over 100x the samples
+    EXPECT_LT(quasi.standardError * 10.0, random.standardError);
+    EXPECT_NEAR(quasi.stddev, random.stddev, 0.05 * random.stddev);
+}
+
+TEST(QuasiMonteCarloTest, IndependentOfThreadsAndEngine) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 3.0));
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto expr = (a * b + a).get();
+    
+    SimulationResult expected = runQuasiRandom(expr, registry, 100000, 0);
+    for (size_t threads : {1, 3, 8}) {
+        SimulationResult actual = runQuasiRandom(expr, registry, 100000, threads);
+        EXPECT_EQ(actual.samples, expected.samples);
+        EXPECT_EQ(actual.mean, expected.mean);
+        EXPECT_EQ(actual.standardError, expected.standardError);
+    }
+    
+    MonteCarloEvaluator philox(100000, 42);
+    philox.setSamplingMethod(SamplingMethod::QuasiMonteCarlo);
+    philox.setRandomEngine(RandomEngine::Philox4x32);
+    EXPECT_EQ(philox.evaluate(expr, registry).samples, expected.samples);
+    
+    // Other seeds and later runs scramble differently
+    EXPECT_NE(runQuasiRandom(expr, registry, 100000, 0, 7).samples, expected.samples);
+    EXPECT_NE(philox.evaluate(expr, registry).samples, expected.samples);
+}
+
+TEST(QuasiMonteCarloTest, SchedulerMatchesEvaluator) {
+    auto registry = std::make_shared<VariableRegistry>();
+    registry->registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry->registerVariable("b", std::make_shared<UniformDistribution>(1.0, 3.0));
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    
+    SimulationJob job;
+    job.expression = (a * b + a).get();
+    job.registry = registry;
+    job.numSamples = 50000;
+    job.seed = 42;
+    job.samplingMethod = SamplingMethod::QuasiMonteCarlo;
+    SimulationScheduler scheduler(2);
+    SimulationResult actual = scheduler.submit(job).get();
+    SimulationResult expected = runQuasiRandom(job.expression, *registry, 50000, 2);
+    EXPECT_EQ(actual.samples, expected.samples);
+    EXPECT_EQ(actual.replicateMeans, expected.replicateMeans);
+}
+
+TEST(QuasiMonteCarloTest, UnevenReplicates) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 3.0));
+    auto a = ExpressionBuilder::variable("a");
+    auto b = ExpressionBuilder::variable("b");
+    auto expr = (a * b + a).get();
+    
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setSamplingMethod(SamplingMethod::QuasiMonteCarlo);
+    evaluator.setReplicateCount(3);
+    EXPECT_EQ(evaluator.getReplicateCount(), 3u);
+    SimulationResult result = evaluator.evaluate(expr, registry);
+    ASSERT_EQ(result.replicateMeans.size(), 3u);
+    // Replicates of 334, 333 and 333 samples
+    const double weighted = (334 * result.replicateMeans[0] + 333 * result.replicateMeans[1] +
+                             333 * result.replicateMeans[2]) / 1000.0;
+    EXPECT_NEAR(weighted, result.mean, 1e-12);
+    
+    // A single replicate has no error estimate
+    evaluator.setReplicateCount(1);
+    EXPECT_TRUE(std::isnan(evaluator.evaluate(expr, registry).standardError));
+    EXPECT_THROW(evaluator.setReplicateCount(0), std::invalid_argument);
+}
+
+TEST(QuasiMonteCarloTest, TooManyVariables) {
+    VariableRegistry registry;
+    auto sum = ExpressionBuilder::constant(0.0);
+    for (size_t i = 0; i <= SobolSequence::MAX_DIMENSIONS; ++i) {
+        const std::string name = "x" + std::to_string(i);
+        registry.registerVariable(name, std::make_shared<UniformDistribution>(0.0, 1.0));
+        sum = sum + ExpressionBuilder::variable(name);
+    }
+    MonteCarloEvaluator evaluator(1000, 42);
+    evaluator.setSamplingMethod(SamplingMethod::QuasiMonteCarlo);
+    EXPECT_THROW(evaluator.evaluate(sum.get(), registry), std::invalid_argument);
+}
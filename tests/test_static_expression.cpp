@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "static_expression.h"
+#include "expression_builder.h"
+#include "monte_carlo_evaluator.h"
+#include <cmath>
+#include <map>
+#include <type_traits>
+
+using namespace tt_int;
+
+TEST(StaticExpressionTest, LeavesEvaluate) {
+    double values[] = {3.0, 4.0};
+    EXPECT_EQ(staticConstant(2.5).evaluate(values), 2.5);
+    EXPECT_EQ(staticVariable<1>("y").evaluate(values), 4.0);
+}
+
+TEST(StaticExpressionTest, MatchesRuntimeTree) {
+    auto x = staticVariable<0>("x");
+    auto y = staticVariable<1>("y");
+    auto expr = (x + y) * 3.0 - x / (y - 2.0) + 0.5 / y;
+
+    auto rx = ExpressionBuilder::variable("x");
+    auto ry = ExpressionBuilder::variable("y");
+    auto reference = (rx + ry) * 3.0 - rx / (ry - 2.0) + 0.5 / ry;
+
+    for (double yValue : {-1.5, 0.0, 2.0, 4.25}) {
+        double values[] = {1.75, yValue};
+        std::map<std::string, double> vars = {{"x", 1.75}, {"y", yValue}};
+        double expected = reference.get()->evaluate(vars);
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(expr.evaluate(values)));
+        } else {
+            EXPECT_EQ(expr.evaluate(values), expected);
+        }
+    }
+}
+
+TEST(StaticExpressionTest, TypeEncodesExpression) {
+    auto x = staticVariable<0>("x");
+    auto expr = x * 2.0 + x;
+    using Expected = StaticBinaryOp<BinaryOperator::Add,
+                                    StaticBinaryOp<BinaryOperator::Multiply,
+                                                   StaticVariable<0>, StaticConstant>,
+                                    StaticVariable<0>>;
+    static_assert(std::is_same_v<decltype(expr), Expected>);
+    static_assert(!std::is_polymorphic_v<decltype(expr)>);
+    SUCCEED();
+}
+
+TEST(StaticExpressionTest, BatchMatchesScalar) {
+    auto x = staticVariable<0>("x");
+    auto y = staticVariable<1>("y");
+    auto expr = x * y + 1.0 / (x - y);
+
+    const size_t count = 16;
+    std::vector<double> xs(count), ys(count), out(count);
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = static_cast<double>(i);
+        ys[i] = static_cast<double>(i % 4);
+    }
+    const double* columns[] = {xs.data(), ys.data()};
+    expr.evaluateBatch(columns, count, out.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        double values[] = {xs[i], ys[i]};
+        double expected = expr.evaluate(values);
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(out[i]));
+        } else {
+            EXPECT_EQ(out[i], expected);
+        }
+    }
+}
+
+TEST(StaticExpressionTest, ConvertsToRuntimeExpression) {
+    auto x = staticVariable<0>("x");
+    auto y = staticVariable<1>("y");
+    auto expr = (x - 1.0) * (y + 2.0);
+
+    std::shared_ptr<Expression> runtime = expr;
+    auto reference = (ExpressionBuilder::variable("x") - 1.0) * (ExpressionBuilder::variable("y") + 2.0);
+    EXPECT_TRUE(runtime->equals(*reference.get()));
+
+    std::map<std::string, double> vars = {{"x", 3.0}, {"y", 0.5}};
+    double values[] = {3.0, 0.5};
+    EXPECT_EQ(runtime->evaluate(vars), expr.evaluate(values));
+}
+
+TEST(StaticExpressionTest, WorksWithEvaluator) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 2.0));
+
+    auto a = staticVariable<0>("a");
+    auto b = staticVariable<1>("b");
+    auto expr = a * b - a / b;
+
+    MonteCarloEvaluator staticEvaluator(500, 7);
+    MonteCarloEvaluator treeEvaluator(500, 7);
+    auto staticResult = staticEvaluator.evaluate(expr, registry);
+    auto treeResult = treeEvaluator.evaluate(
+        (ExpressionBuilder::variable("a") * ExpressionBuilder::variable("b")
+            - ExpressionBuilder::variable("a") / ExpressionBuilder::variable("b")).get(),
+        registry);
+    EXPECT_EQ(staticResult.samples, treeResult.samples);
+}
+
+TEST(StaticExpressionTest, FusedRunMatchesInterpretedRun) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 2.0));
+    registry.registerVariable("c", std::make_shared<NormalDistribution>(-1.0, 0.5));
+
+    // Indices in a different order than the registry slots, with a gap;
+    // b is registered but unused
+    auto c = staticVariable<0>("c");
+    auto a = staticVariable<2>("a");
+    auto expr = (a - c) * (a / c) + 0.25;
+    ASSERT_EQ(expr.getVariableNames(), (std::vector<std::string>{"c", "", "a"}));
+
+    for (size_t threads : {0, 3}) {
+        MonteCarloEvaluator fused(5000, 13);
+        MonteCarloEvaluator interpreted(5000, 13);
+        fused.setThreadCount(threads);
+        interpreted.setThreadCount(threads);
+        auto fusedResult = fused.evaluate(expr, registry);
+        auto interpretedResult = interpreted.evaluate(expr.toExpression(), registry);
+        EXPECT_EQ(fusedResult.samples, interpretedResult.samples);
+        EXPECT_EQ(fusedResult.mean, interpretedResult.mean);
+    }
+}
+
+TEST(StaticExpressionTest, IndexBoundToTwoNamesThrows) {
+    VariableRegistry registry;
+    registry.registerVariable("x", std::make_shared<NormalDistribution>(0.0, 1.0));
+    registry.registerVariable("y", std::make_shared<NormalDistribution>(0.0, 1.0));
+
+    auto expr = staticVariable<0>("x") + staticVariable<0>("y");
+    EXPECT_THROW(expr.getVariableNames(), std::invalid_argument);
+
+    MonteCarloEvaluator evaluator(100, 1);
+    EXPECT_THROW(evaluator.evaluate(expr, registry), std::invalid_argument);
+}
+
+TEST(StaticExpressionTest, ExpressionBuilderOperatorsUnaffected) {
+    auto x = ExpressionBuilder::variable("x");
+    auto expr = x * 2.0 + 1.0;
+    static_assert(std::is_same_v<decltype(expr), ExpressionBuilder>);
+
+    std::map<std::string, double> vars = {{"x", 3.0}};
+    EXPECT_EQ(expr.get()->evaluate(vars), 7.0);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "thread_placement.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace tt_int;
+
+TEST(ThreadPlacementTest, ParseCpuList) {
+    EXPECT_EQ(parseCpuList("0-3,8,10-11\n"), (std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parseCpuList("5"), (std::vector<unsigned>{5}));
+    EXPECT_TRUE(parseCpuList("").empty());
+    EXPECT_THROW(parseCpuList("3-1"), std::invalid_argument);
+    EXPECT_THROW(parseCpuList("1,,2"), std::invalid_argument);
+    EXPECT_THROW(parseCpuList("a-b"), std::invalid_argument);
+}
+
+TEST(ThreadPlacementTest, SpreadOrderAlternatesNodes) {
+    CpuTopology topology({{0, 1, 2}, {}, {4, 5}});
+    EXPECT_EQ(topology.getNodeCount(), 2);
+    EXPECT_EQ(topology.spreadOrder(), (std::vector<unsigned>{0, 4, 1, 5, 2}));
+}
+
+TEST(ThreadPlacementTest, DetectedTopologyCoversUsableCpus) {
+    CpuTopology topology = CpuTopology::detect();
+    ASSERT_GE(topology.getNodeCount(), 1);
+    std::vector<unsigned> order = topology.spreadOrder();
+    ASSERT_FALSE(order.empty());
+    EXPECT_EQ(std::set<unsigned>(order.begin(), order.end()).size(), order.size());
+}
+
+TEST(ThreadPlacementTest, PinIsRestored) {
+    const unsigned cpu = CpuTopology::detect().spreadOrder().back();
+#ifdef __linux__
+    cpu_set_t before;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(before), &before), 0);
+    {
+        ScopedThreadPin pin(cpu);
+        ASSERT_TRUE(pin.isPinned());
+        cpu_set_t pinned;
+        ASSERT_EQ(sched_getaffinity(0, sizeof(pinned), &pinned), 0);
+        EXPECT_EQ(CPU_COUNT(&pinned), 1);
+        EXPECT_TRUE(CPU_ISSET(cpu, &pinned));
+    }
+    cpu_set_t after;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(after), &after), 0);
+    EXPECT_TRUE(CPU_EQUAL(&before, &after));
+#else
+    ScopedThreadPin pin(cpu);
+    EXPECT_FALSE(pin.isPinned());
+#endif
+}
+
+TEST(ThreadPlacementTest, PinnedEvaluationMatchesUnpinned) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 3.0));
+    auto expr = (ExpressionBuilder::variable("a") * ExpressionBuilder::variable("b")).get();
+
+    MonteCarloEvaluator unpinned(100000, 42);
+    unpinned.setThreadCount(4);
+    SimulationResult expected = unpinned.evaluate(expr, registry, 1000);
+
+    MonteCarloEvaluator pinned(100000, 42);
+    pinned.setThreadCount(4);
+    pinned.setThreadPinning(true);
+    EXPECT_TRUE(pinned.getThreadPinning());
+    SimulationResult actual = pinned.evaluate(expr, registry, 1000);
+
+    EXPECT_EQ(actual.samples, expected.samples);
+    EXPECT_EQ(actual.mean, expected.mean);
+    EXPECT_EQ(actual.stddev, expected.stddev);
+    ASSERT_EQ(actual.convergenceHistory.size(), expected.convergenceHistory.size());
+    for (size_t i = 0; i < actual.convergenceHistory.size(); ++i) {
+        EXPECT_EQ(actual.convergenceHistory[i].mean, expected.convergenceHistory[i].mean);
+    }
+}
+
+TEST(ThreadPlacementTest, ReleasePagesKeepsPartialPages) {
+    std::vector<double> buffer(1 << 16, 1.0);
+    const size_t begin = 1000;
+    const size_t end = buffer.size() - 1000;
+    releasePages(buffer.data() + begin, end - begin);
+    // Outside the slice, and on its partial pages, values are untouched
+    EXPECT_EQ(buffer[begin - 1], 1.0);
+    EXPECT_EQ(buffer[begin], 1.0);
+    EXPECT_EQ(buffer[end - 1], 1.0);
+    EXPECT_EQ(buffer[end], 1.0);
+    // Whole pages inside it read as zero, where pages can be released
+    for (double value : buffer) {
+        EXPECT_TRUE(value == 1.0 || value == 0.0);
+    }
+#ifdef __linux__
+    EXPECT_EQ(buffer[buffer.size() / 2], 0.0);
+#endif
+}
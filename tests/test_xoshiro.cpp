@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "xoshiro.h"
+#include "distribution.h"
+#include "variable_registry.h"
+#include "monte_carlo_evaluator.h"
+#include "expression_builder.h"
+#include <cmath>
+#include <vector>
+
+using namespace tt_int;
+
+namespace {
+
+template <typename Engine>
+typename Engine::State xorStates(const typename Engine::State& lhs, const typename Engine::State& rhs) {
+    typename Engine::State result = lhs;
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i] ^= rhs[i];
+    }
+    return result;
+}
+
+// The engines are linear over GF(2), so a correct jump polynomial must map
+// A ^ B to jump(A) ^ jump(B) and commute with single steps
+template <typename Engine>
+void expectJumpIsLinearAndCommutes() {
+    const typename Engine::State a = Engine(11).getState();
+    const typename Engine::State b = Engine(12).getState();
+
+    for (auto advance : {&Engine::jump, &Engine::long_jump}) {
+        Engine ja(a), jb(b), jab(xorStates<Engine>(a, b));
+        (ja.*advance)();
+        (jb.*advance)();
+        (jab.*advance)();
+        EXPECT_EQ(jab.getState(), (xorStates<Engine>(ja.getState(), jb.getState())));
+
+        Engine stepThenJump(a), jumpThenStep(a);
+        stepThenJump();
+        (stepThenJump.*advance)();
+        (jumpThenStep.*advance)();
+        jumpThenStep();
+        EXPECT_EQ(stepThenJump, jumpThenStep);
+        EXPECT_NE(jumpThenStep, Engine(a));
+    }
+
+    Engine jumped(a), longJumped(a);
+    jumped.jump();
+    longJumped.long_jump();
+    EXPECT_NE(jumped, longJumped);
+}
+
+} // namespace
+
+TEST(XoshiroTest, KnownOutputs) {
+    Xoshiro256PlusPlus xoshiro(Xoshiro256PlusPlus::State{1, 2, 3, 4});
+    EXPECT_EQ(xoshiro(), 41943041ULL);
+    EXPECT_EQ(xoshiro(), 58720359ULL);
+    EXPECT_EQ(xoshiro(), 3588806011781223ULL);
+
+    Xoroshiro128Plus xoroshiro(Xoroshiro128Plus::State{1, 2});
+    EXPECT_EQ(xoroshiro(), 3ULL);
+    EXPECT_EQ(xoroshiro(), 412333834243ULL);
+    EXPECT_EQ(xoroshiro(), 2360170716294286339ULL);
+}
+
+TEST(XoshiroTest, SeedingAndDiscard) {
+    Xoshiro256PlusPlus a(7), b(7), c(8);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    b();
+    b();
+    a.discard(2);
+    EXPECT_EQ(a, b);
+    a.seed(8);
+    EXPECT_EQ(a, c);
+}
+
+TEST(XoshiroTest, JumpPolynomials) {
+    expectJumpIsLinearAndCommutes<Xoshiro256PlusPlus>();
+    expectJumpIsLinearAndCommutes<Xoroshiro128Plus>();
+}
+
+TEST(XoshiroTest, UnitDoubleConversion) {
+    EXPECT_EQ(toUnitDouble(0), 0.0);
+    EXPECT_EQ(toUnitDouble(~0ULL), 1.0 - 0x1.0p-53);
+    EXPECT_EQ(toUnitDouble(1ULL << 63), 0.5);
+    EXPECT_EQ(toUnitDouble(0x7ff), 0.0);  // Low 11 bits are dropped
+
+    Xoroshiro128Plus rng(3);
+    double sum = 0.0;
+    const int count = 100000;
+    for (int i = 0; i < count; ++i) {
+        double value = rng.nextDouble();
+        ASSERT_GE(value, 0.0);
+        ASSERT_LT(value, 1.0);
+        sum += value;
+    }
+    EXPECT_NEAR(sum / count, 0.5, 0.01);
+}
+
+TEST(XoshiroTest, DistributionSampling) {
+    NormalDistribution normal(10.0, 2.0);
+    UniformDistribution uniform(-3.0, 5.0);
+    Xoshiro256PlusPlus rng(5);
+    const int count = 200000;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    double uniformSum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        double value = normal.sample(rng);
+        sum += value;
+        sumSquares += value * value;
+        double u = uniform.sample(rng);
+        ASSERT_GE(u, -3.0);
+        ASSERT_LT(u, 5.0);
+        uniformSum += u;
+    }
+    double mean = sum / count;
+    EXPECT_NEAR(mean, 10.0, 0.03);
+    EXPECT_NEAR(std::sqrt(sumSquares / count - mean * mean), 2.0, 0.03);
+    EXPECT_NEAR(uniformSum / count, 1.0, 0.03);
+
+    // Clones start without a cached polar variate
+    NormalDistribution fresh(0.0, 1.0);
+    fresh.sample(rng);
+    auto copy = fresh.clone();
+    Xoshiro256PlusPlus r1(9), r2(9);
+    EXPECT_EQ(copy->sample(r1), NormalDistribution(0.0, 1.0).sample(r2));
+}
+
+TEST(XoshiroTest, EvaluatorIdenticalAcrossThreadCounts) {
+    VariableRegistry registry;
+    registry.registerVariable("a", std::make_shared<NormalDistribution>(5.0, 1.0));
+    registry.registerVariable("b", std::make_shared<UniformDistribution>(1.0, 2.0));
+    auto expr = (ExpressionBuilder::variable("a") * ExpressionBuilder::variable("b")).get();
+
+    for (RandomEngine engine : {RandomEngine::Xoshiro256PlusPlus, RandomEngine::Xoroshiro128Plus}) {
+        MonteCarloEvaluator sequential(60000, 42);
+        sequential.setRandomEngine(engine);
+        auto expected = sequential.evaluate(expr, registry, -1);
+        EXPECT_NEAR(expected.mean, 7.5, 0.05);
+
+        for (size_t threads : {1, 4}) {
+            MonteCarloEvaluator parallel(60000, 42);
+            parallel.setRandomEngine(engine);
+            parallel.setThreadCount(threads);
+            auto actual = parallel.evaluate(expr, registry, -1);
+            EXPECT_EQ(actual.samples, expected.samples);
+            EXPECT_EQ(actual.mean, expected.mean);
+            EXPECT_EQ(actual.stddev, expected.stddev);
+            ASSERT_EQ(actual.convergenceHistory.size(), expected.convergenceHistory.size());
+        }
+
+        // The next run starts a long jump further on
+        auto second = sequential.evaluate(expr, registry);
+        EXPECT_NE(second.samples, expected.samples);
+        EXPECT_NEAR(second.mean, 7.5, 0.05);
+    }
+}